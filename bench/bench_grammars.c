@@ -0,0 +1,511 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_grammars.h"
+
+
+///////////////
+// Constants //
+///////////////
+
+enum{
+	EXPR_ID, EXPR_PLUS, EXPR_STAR, EXPR_LPAREN, EXPR_RPAREN, EXPR_END,
+	EXPR_EXPR, EXPR_EXPR_TAIL, EXPR_TERM, EXPR_TERM_TAIL, EXPR_FACTOR, EXPR_EMPTY,
+};
+
+enum{
+	JSON_LBRACE, JSON_RBRACE, JSON_LBRACKET, JSON_RBRACKET, JSON_COMMA, JSON_COLON,
+	JSON_STRING, JSON_NUMBER, JSON_TRUE, JSON_FALSE, JSON_NULL, JSON_END,
+	JSON_VALUE, JSON_OBJECT, JSON_MEMBERS, JSON_MEMBERS_TAIL, JSON_PAIR,
+	JSON_ARRAY, JSON_ELEMENTS, JSON_ELEMENTS_TAIL, JSON_EMPTY,
+};
+
+// Maximum number of symbols of one top level item of generated input
+#define ITEM_MAX_SYMBOLS 256
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+// Generated grammar. Terminals are 0 to len_terminals - 1, followed by the
+// end symbol, variables, start and empty symbol. Each variable i has rules
+// V_i -> leaf_i
+// V_i -> open_i V_child1 V_child2 close_i
+// V_i -> mid_i V_child1
+// where the last two are left out for the last variable. Children have a
+// higher index, and the first terminals of a variable's rules differ, so the
+// grammar is LL1. Start symbol has rules S -> V_0 S and S -> empty
+typedef struct GeneratedGrammar{
+	int len_variables;
+	int len_terminals;
+
+	int *leaf_terminals;
+	int *open_terminals;
+	int *close_terminals;
+	int *mid_terminals;
+	int *children1;
+	int *children2;
+}GeneratedGrammar;
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static int token_to_symbol(Token *tkn_ptr);
+
+static char *symbol_to_string(int symbol);
+
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer);
+
+static BenchGrammar *BenchGrammar_alloc(const char *name, int len_variable_symbols, int len_terminal_symbols);
+
+static void GeneratedGrammar_destroy(void *data);
+
+static void add_expression_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+
+static int generate_expression(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed);
+
+static void add_json_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+
+static int generate_json(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed);
+
+static int generate_json_value(int *symbols, int len, int budget, int depth, unsigned int *seed);
+
+static void add_generated_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+
+static int generate_generated(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed);
+
+static int generate_generated_variable(GeneratedGrammar *gen_ptr, int variable_index, int *symbols, int len, int budget, unsigned int *seed);
+
+
+///////////////
+// Callbacks //
+///////////////
+
+static int token_to_symbol(Token *tkn_ptr){
+	return tkn_ptr->column;
+}
+
+static char *symbol_to_string(int symbol){
+	(void)symbol;
+	return "symbol";
+}
+
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer){
+	(void)tkn_ptr;
+	(void)buffer;
+	(void)len_buffer;
+}
+
+
+////////////////////////////////
+// Constructors & Destructors //
+////////////////////////////////
+
+static BenchGrammar *BenchGrammar_alloc(const char *name, int len_variable_symbols, int len_terminal_symbols){
+	BenchGrammar *bgr_ptr = malloc( sizeof(BenchGrammar) );
+
+	bgr_ptr->name = strdup(name);
+	bgr_ptr->variable_symbols = malloc( sizeof(int) * len_variable_symbols );
+	bgr_ptr->len_variable_symbols = len_variable_symbols;
+	bgr_ptr->terminal_symbols = malloc( sizeof(int) * len_terminal_symbols );
+	bgr_ptr->len_terminal_symbols = len_terminal_symbols;
+	bgr_ptr->data = NULL;
+	bgr_ptr->destroy_data = NULL;
+
+	return bgr_ptr;
+}
+
+BenchGrammar *BenchGrammar_new_expression(void){
+	BenchGrammar *bgr_ptr = BenchGrammar_alloc("expression", 6, 6);
+
+	for (int i = 0; i < 6; ++i){
+		bgr_ptr->terminal_symbols[i] = EXPR_ID + i;
+		bgr_ptr->variable_symbols[i] = EXPR_EXPR + i;
+	}
+	bgr_ptr->start_symbol = EXPR_EXPR;
+	bgr_ptr->empty_symbol = EXPR_EMPTY;
+	bgr_ptr->end_symbol = EXPR_END;
+	bgr_ptr->len_rules = 8;
+
+	bgr_ptr->add_rules = add_expression_rules;
+	bgr_ptr->generate = generate_expression;
+
+	return bgr_ptr;
+}
+
+BenchGrammar *BenchGrammar_new_json(void){
+	BenchGrammar *bgr_ptr = BenchGrammar_alloc("json", 9, 12);
+
+	for (int i = 0; i < 12; ++i)
+		bgr_ptr->terminal_symbols[i] = JSON_LBRACE + i;
+	for (int i = 0; i < 9; ++i)
+		bgr_ptr->variable_symbols[i] = JSON_VALUE + i;
+	bgr_ptr->start_symbol = JSON_VALUE;
+	bgr_ptr->empty_symbol = JSON_EMPTY;
+	bgr_ptr->end_symbol = JSON_END;
+	bgr_ptr->len_rules = 18;
+
+	bgr_ptr->add_rules = add_json_rules;
+	bgr_ptr->generate = generate_json;
+
+	return bgr_ptr;
+}
+
+BenchGrammar *BenchGrammar_new_generated(int len_variables, unsigned int seed){
+	// Enough terminals for three distinct first terminals per variable
+	int len_terminals = len_variables < 16 ? 16 : len_variables;
+
+	char name[32];
+	snprintf(name, sizeof(name), "generated_%d", len_variables);
+
+	BenchGrammar *bgr_ptr = BenchGrammar_alloc(name, len_variables + 2, len_terminals + 1);
+
+	for (int i = 0; i < len_terminals + 1; ++i)
+		bgr_ptr->terminal_symbols[i] = i;
+	for (int i = 0; i < len_variables + 2; ++i)
+		bgr_ptr->variable_symbols[i] = len_terminals + 1 + i;
+	bgr_ptr->end_symbol = len_terminals;
+	bgr_ptr->start_symbol = len_terminals + 1 + len_variables;
+	bgr_ptr->empty_symbol = len_terminals + 2 + len_variables;
+
+	GeneratedGrammar *gen_ptr = malloc( sizeof(GeneratedGrammar) );
+	gen_ptr->len_variables = len_variables;
+	gen_ptr->len_terminals = len_terminals;
+	gen_ptr->leaf_terminals = malloc( sizeof(int) * len_variables );
+	gen_ptr->open_terminals = malloc( sizeof(int) * len_variables );
+	gen_ptr->close_terminals = malloc( sizeof(int) * len_variables );
+	gen_ptr->mid_terminals = malloc( sizeof(int) * len_variables );
+	gen_ptr->children1 = malloc( sizeof(int) * len_variables );
+	gen_ptr->children2 = malloc( sizeof(int) * len_variables );
+
+	bgr_ptr->len_rules = 2;
+	for (int i = 0; i < len_variables; ++i){
+		// Three distinct first terminals
+		gen_ptr->leaf_terminals[i] = rand_r(&seed) % len_terminals;
+		gen_ptr->open_terminals[i] = (gen_ptr->leaf_terminals[i] + 1 + rand_r(&seed) % (len_terminals - 2)) % len_terminals;
+		do{
+			gen_ptr->mid_terminals[i] = rand_r(&seed) % len_terminals;
+		}while(gen_ptr->mid_terminals[i] == gen_ptr->leaf_terminals[i] || gen_ptr->mid_terminals[i] == gen_ptr->open_terminals[i]);
+		gen_ptr->close_terminals[i] = rand_r(&seed) % len_terminals;
+
+		if(i < len_variables - 1){
+			gen_ptr->children1[i] = i + 1 + rand_r(&seed) % (len_variables - i - 1);
+			gen_ptr->children2[i] = i + 1 + rand_r(&seed) % (len_variables - i - 1);
+			bgr_ptr->len_rules += 3;
+		}
+		else{
+			gen_ptr->children1[i] = -1;
+			gen_ptr->children2[i] = -1;
+			bgr_ptr->len_rules += 1;
+		}
+	}
+
+	bgr_ptr->data = gen_ptr;
+	bgr_ptr->destroy_data = GeneratedGrammar_destroy;
+	bgr_ptr->add_rules = add_generated_rules;
+	bgr_ptr->generate = generate_generated;
+
+	return bgr_ptr;
+}
+
+void BenchGrammar_destroy(BenchGrammar *bgr_ptr){
+	if(bgr_ptr->destroy_data != NULL)
+		bgr_ptr->destroy_data(bgr_ptr->data);
+
+	free(bgr_ptr->name);
+	free(bgr_ptr->variable_symbols);
+	free(bgr_ptr->terminal_symbols);
+	free(bgr_ptr);
+}
+
+static void GeneratedGrammar_destroy(void *data){
+	GeneratedGrammar *gen_ptr = data;
+
+	free(gen_ptr->leaf_terminals);
+	free(gen_ptr->open_terminals);
+	free(gen_ptr->close_terminals);
+	free(gen_ptr->mid_terminals);
+	free(gen_ptr->children1);
+	free(gen_ptr->children2);
+	free(gen_ptr);
+}
+
+ParserLL1_Grammar *BenchGrammar_build(BenchGrammar *bgr_ptr){
+	ParserLL1_Grammar *grm_ptr = ParserLL1_Grammar_new(bgr_ptr->variable_symbols, bgr_ptr->len_variable_symbols, bgr_ptr->terminal_symbols, bgr_ptr->len_terminal_symbols, bgr_ptr->start_symbol, bgr_ptr->empty_symbol, bgr_ptr->end_symbol, NULL, 0, token_to_symbol, symbol_to_string, token_to_value);
+
+	bgr_ptr->add_rules(bgr_ptr, grm_ptr);
+
+	return grm_ptr;
+}
+
+
+////////////////
+// Expression //
+////////////////
+
+static void add_expression_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	(void)bgr_ptr;
+
+	int r1[] = {EXPR_TERM, EXPR_EXPR_TAIL};
+	int r2[] = {EXPR_PLUS, EXPR_TERM, EXPR_EXPR_TAIL};
+	int r3[] = {EXPR_EMPTY};
+	int r4[] = {EXPR_FACTOR, EXPR_TERM_TAIL};
+	int r5[] = {EXPR_STAR, EXPR_FACTOR, EXPR_TERM_TAIL};
+	int r6[] = {EXPR_LPAREN, EXPR_EXPR, EXPR_RPAREN};
+	int r7[] = {EXPR_ID};
+
+	ParserLL1_Grammar_add_rule(grm_ptr, 1, EXPR_EXPR, r1, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 2, EXPR_EXPR_TAIL, r2, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 3, EXPR_EXPR_TAIL, r3, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 4, EXPR_TERM, r4, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 5, EXPR_TERM_TAIL, r5, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 6, EXPR_TERM_TAIL, r3, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 7, EXPR_FACTOR, r6, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 8, EXPR_FACTOR, r7, 1);
+}
+
+static int generate_expression(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed){
+	(void)bgr_ptr;
+
+	int len = 0;
+	int depth = 0;
+
+	while(1){
+		// Operand, optionally parenthesized
+		while(depth < 32 && len + depth < len_symbols - 4 && rand_r(seed) % 4 == 0){
+			symbols[len++] = EXPR_LPAREN;
+			depth++;
+		}
+		symbols[len++] = EXPR_ID;
+		while(depth > 0 && rand_r(seed) % 3 == 0){
+			symbols[len++] = EXPR_RPAREN;
+			depth--;
+		}
+
+		if(len + depth >= len_symbols - 3)
+			break;
+
+		symbols[len++] = rand_r(seed) % 2 ? EXPR_PLUS : EXPR_STAR;
+	}
+
+	while(depth-- > 0)
+		symbols[len++] = EXPR_RPAREN;
+	symbols[len++] = EXPR_END;
+
+	return len;
+}
+
+
+//////////
+// JSON //
+//////////
+
+static void add_json_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	(void)bgr_ptr;
+
+	int r1[] = {JSON_OBJECT};
+	int r2[] = {JSON_ARRAY};
+	int r3[] = {JSON_STRING};
+	int r4[] = {JSON_NUMBER};
+	int r5[] = {JSON_TRUE};
+	int r6[] = {JSON_FALSE};
+	int r7[] = {JSON_NULL};
+	int r8[] = {JSON_LBRACE, JSON_MEMBERS, JSON_RBRACE};
+	int r9[] = {JSON_PAIR, JSON_MEMBERS_TAIL};
+	int r10[] = {JSON_EMPTY};
+	int r11[] = {JSON_COMMA, JSON_PAIR, JSON_MEMBERS_TAIL};
+	int r13[] = {JSON_STRING, JSON_COLON, JSON_VALUE};
+	int r14[] = {JSON_LBRACKET, JSON_ELEMENTS, JSON_RBRACKET};
+	int r15[] = {JSON_VALUE, JSON_ELEMENTS_TAIL};
+	int r17[] = {JSON_COMMA, JSON_VALUE, JSON_ELEMENTS_TAIL};
+
+	ParserLL1_Grammar_add_rule(grm_ptr, 1, JSON_VALUE, r1, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 2, JSON_VALUE, r2, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 3, JSON_VALUE, r3, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 4, JSON_VALUE, r4, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 5, JSON_VALUE, r5, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 6, JSON_VALUE, r6, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 7, JSON_VALUE, r7, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 8, JSON_OBJECT, r8, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 9, JSON_MEMBERS, r9, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 10, JSON_MEMBERS, r10, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 11, JSON_MEMBERS_TAIL, r11, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 12, JSON_MEMBERS_TAIL, r10, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 13, JSON_PAIR, r13, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 14, JSON_ARRAY, r14, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 15, JSON_ELEMENTS, r15, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 16, JSON_ELEMENTS, r10, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 17, JSON_ELEMENTS_TAIL, r17, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 18, JSON_ELEMENTS_TAIL, r10, 1);
+}
+
+static int generate_json(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed){
+	(void)bgr_ptr;
+
+	// Top level array of values, closed before the end of the buffer
+	int len = 0;
+	symbols[len++] = JSON_LBRACKET;
+
+	while(len_symbols - len > 8){
+		if(len > 1)
+			symbols[len++] = JSON_COMMA;
+
+		int budget = len_symbols - len - 2;
+		if(budget > ITEM_MAX_SYMBOLS)
+			budget = ITEM_MAX_SYMBOLS;
+		len = generate_json_value(symbols, len, budget, 0, seed);
+	}
+
+	symbols[len++] = JSON_RBRACKET;
+	symbols[len++] = JSON_END;
+
+	return len;
+}
+
+// Writes a value of at most budget symbols at symbols[len], returns new length
+static int generate_json_value(int *symbols, int len, int budget, int depth, unsigned int *seed){
+	static const int scalars[] = {JSON_STRING, JSON_NUMBER, JSON_TRUE, JSON_FALSE, JSON_NULL};
+	int choice = rand_r(seed) % 4;
+
+	if(budget >= 8 && depth < 16 && choice == 0){
+		// Object of members, each costing two symbols and a comma
+		int len_members = 1 + rand_r(seed) % 4;
+		if(len_members > (budget - 2) / 4)
+			len_members = (budget - 2) / 4;
+		int member_budget = (budget - 2 - 3 * len_members) / len_members;
+
+		symbols[len++] = JSON_LBRACE;
+		for (int i = 0; i < len_members; ++i){
+			if(i > 0)
+				symbols[len++] = JSON_COMMA;
+			symbols[len++] = JSON_STRING;
+			symbols[len++] = JSON_COLON;
+			len = generate_json_value(symbols, len, member_budget, depth + 1, seed);
+		}
+		symbols[len++] = JSON_RBRACE;
+	}
+
+	else if(budget >= 8 && depth < 16 && choice == 1){
+		// Array of elements, each costing a comma
+		int len_elements = 1 + rand_r(seed) % 6;
+		if(len_elements > (budget - 2) / 2)
+			len_elements = (budget - 2) / 2;
+		int element_budget = (budget - 1 - len_elements) / len_elements;
+
+		symbols[len++] = JSON_LBRACKET;
+		for (int i = 0; i < len_elements; ++i){
+			if(i > 0)
+				symbols[len++] = JSON_COMMA;
+			len = generate_json_value(symbols, len, element_budget, depth + 1, seed);
+		}
+		symbols[len++] = JSON_RBRACKET;
+	}
+
+	else{
+		symbols[len++] = scalars[ rand_r(seed) % 5 ];
+	}
+
+	return len;
+}
+
+
+///////////////
+// Generated //
+///////////////
+
+static void add_generated_rules(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	GeneratedGrammar *gen_ptr = bgr_ptr->data;
+	int len_terminals = gen_ptr->len_terminals;
+	int rule_num = 1;
+
+	// Variable i is symbol variable_base + i
+	int variable_base = len_terminals + 1;
+
+	int start_rule[] = {variable_base, bgr_ptr->start_symbol};
+	int empty_rule[] = {bgr_ptr->empty_symbol};
+	ParserLL1_Grammar_add_rule(grm_ptr, rule_num++, bgr_ptr->start_symbol, start_rule, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, rule_num++, bgr_ptr->start_symbol, empty_rule, 1);
+
+	for (int i = 0; i < gen_ptr->len_variables; ++i){
+		int leaf_rule[] = {gen_ptr->leaf_terminals[i]};
+		ParserLL1_Grammar_add_rule(grm_ptr, rule_num++, variable_base + i, leaf_rule, 1);
+
+		if(gen_ptr->children1[i] == -1)
+			continue;
+
+		int open_rule[] = {gen_ptr->open_terminals[i], variable_base + gen_ptr->children1[i], variable_base + gen_ptr->children2[i], gen_ptr->close_terminals[i]};
+		int mid_rule[] = {gen_ptr->mid_terminals[i], variable_base + gen_ptr->children1[i]};
+		ParserLL1_Grammar_add_rule(grm_ptr, rule_num++, variable_base + i, open_rule, 4);
+		ParserLL1_Grammar_add_rule(grm_ptr, rule_num++, variable_base + i, mid_rule, 2);
+	}
+}
+
+static int generate_generated(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed){
+	GeneratedGrammar *gen_ptr = bgr_ptr->data;
+	int len = 0;
+
+	// Sequence of derivations of first variable
+	while(len_symbols - len > 8){
+		int budget = len_symbols - len - 1;
+		if(budget > ITEM_MAX_SYMBOLS)
+			budget = ITEM_MAX_SYMBOLS;
+		len = generate_generated_variable(gen_ptr, 0, symbols, len, budget, seed);
+	}
+
+	symbols[len++] = bgr_ptr->end_symbol;
+
+	return len;
+}
+
+// Writes a derivation of at most budget symbols at symbols[len], returns new
+// length
+static int generate_generated_variable(GeneratedGrammar *gen_ptr, int variable_index, int *symbols, int len, int budget, unsigned int *seed){
+	int choice = rand_r(seed) % 3;
+
+	if(gen_ptr->children1[variable_index] == -1 || budget < 6 || choice == 0){
+		symbols[len++] = gen_ptr->leaf_terminals[variable_index];
+	}
+
+	else if(choice == 1){
+		int child_budget = (budget - 2) / 2;
+		symbols[len++] = gen_ptr->open_terminals[variable_index];
+		len = generate_generated_variable(gen_ptr, gen_ptr->children1[variable_index], symbols, len, child_budget, seed);
+		len = generate_generated_variable(gen_ptr, gen_ptr->children2[variable_index], symbols, len, child_budget, seed);
+		symbols[len++] = gen_ptr->close_terminals[variable_index];
+	}
+
+	else{
+		symbols[len++] = gen_ptr->mid_terminals[variable_index];
+		len = generate_generated_variable(gen_ptr, gen_ptr->children1[variable_index], symbols, len, budget - 1, seed);
+	}
+
+	return len;
+}
+
+
+/////////////
+// Helpers //
+/////////////
+
+double bench_now(void){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+Token **bench_new_tokens(int *symbols, int len_symbols){
+	Token **tkn_ptrs = malloc( sizeof(Token *) * len_symbols );
+
+	for (int i = 0; i < len_symbols; ++i){
+		tkn_ptrs[i] = calloc(1, sizeof(Token));
+		tkn_ptrs[i]->line = i;
+		tkn_ptrs[i]->column = symbols[i];
+	}
+
+	return tkn_ptrs;
+}
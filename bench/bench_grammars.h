@@ -0,0 +1,85 @@
+#ifndef INCLUDE_GUARD_6D0A3F1C94B24E7B8E5A2C7D1F0B9E43
+#define INCLUDE_GUARD_6D0A3F1C94B24E7B8E5A2C7D1F0B9E43
+
+#include "ParserLL1.h"
+#include "Token.h"
+
+// Grammars and input generators shared by the benchmarks.
+//
+// Tokens are zero initialized and carry their terminal symbol in the column
+// field, so no lexer is needed.
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+typedef struct BenchGrammar BenchGrammar;
+
+typedef struct BenchGrammar{
+	char *name;
+
+	int *variable_symbols;
+	int len_variable_symbols;
+	int *terminal_symbols;
+	int len_terminal_symbols;
+	int start_symbol, empty_symbol, end_symbol;
+	int len_rules;
+
+	// Adds all rules to a new grammar, without initializing them
+	void (*add_rules)(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+
+	// Fills symbols with a valid input of about len_symbols symbols, ending
+	// with the end symbol. len_symbols must be at least 64. Returns number of
+	// symbols written, at most len_symbols
+	int (*generate)(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, unsigned int *seed);
+
+	// Grammar specific data, freed with destroy_data if not NULL
+	void *data;
+	void (*destroy_data)(void *data);
+}BenchGrammar;
+
+
+////////////////////////////////
+// Constructors & Destructors //
+////////////////////////////////
+
+/**
+ * Arithmetic expressions with + * and parentheses
+ */
+BenchGrammar *BenchGrammar_new_expression(void);
+
+/**
+ * JSON values with objects, arrays and scalar tokens
+ */
+BenchGrammar *BenchGrammar_new_json(void);
+
+/**
+ * Randomly generated LL1 grammar with the given number of variables, not
+ * counting start and empty symbol. Same seed gives same grammar
+ */
+BenchGrammar *BenchGrammar_new_generated(int len_variables, unsigned int seed);
+
+void BenchGrammar_destroy(BenchGrammar *bgr_ptr);
+
+/**
+ * Creates a grammar with all rules added, but not initialized
+ */
+ParserLL1_Grammar *BenchGrammar_build(BenchGrammar *bgr_ptr);
+
+
+/////////////
+// Helpers //
+/////////////
+
+/**
+ * Monotonic time in seconds
+ */
+double bench_now(void);
+
+/**
+ * Creates tokens for symbols. Array is allocated, tokens are owned by caller
+ */
+Token **bench_new_tokens(int *symbols, int len_symbols);
+
+#endif
@@ -0,0 +1,77 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ParserLL1.h"
+#include "Token.h"
+#include "bench_grammars.h"
+
+// Measures throughput of ParserLL1_parse_documents over a range of thread
+// counts. Usage: bench_parallel [max_threads] [num_documents] [tokens_per_document]
+
+
+//////////
+// Main //
+//////////
+
+int main(int argc, char *argv[]){
+	int max_threads = argc > 1 ? atoi(argv[1]) : 8;
+	int len_documents = argc > 2 ? atoi(argv[2]) : 4000;
+	int len_document_symbols = argc > 3 ? atoi(argv[3]) : 2000;
+
+	if(len_document_symbols < 64)
+		len_document_symbols = 64;
+
+	BenchGrammar *bgr_ptr = BenchGrammar_new_expression();
+	ParserLL1_Grammar *grm_ptr = BenchGrammar_build(bgr_ptr);
+	ParserLL1_Grammar_initialize_rules(grm_ptr);
+
+	// Symbols of each document, tokens are recreated for each run as parser
+	// takes ownership
+	int **symbols = malloc( sizeof(int *) * len_documents );
+	int *len_symbols = malloc( sizeof(int) * len_documents );
+	unsigned int seed = 1;
+	long long len_total_symbols = 0;
+	for (int i = 0; i < len_documents; ++i){
+		symbols[i] = malloc( sizeof(int) * len_document_symbols );
+		len_symbols[i] = bgr_ptr->generate(bgr_ptr, symbols[i], len_document_symbols, &seed);
+		len_total_symbols += len_symbols[i];
+	}
+
+	ParserLL1_Document *documents = malloc( sizeof(ParserLL1_Document) * len_documents );
+
+	double base_seconds = 0;
+	for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2){
+		for (int i = 0; i < len_documents; ++i){
+			documents[i].tkn_ptrs = bench_new_tokens(symbols[i], len_symbols[i]);
+			documents[i].len_tkn_ptrs = len_symbols[i];
+		}
+
+		double start = bench_now();
+		ParserLL1_parse_documents(grm_ptr, documents, len_documents, num_threads);
+		double seconds = bench_now() - start;
+
+		if(num_threads == 1)
+			base_seconds = seconds;
+
+		int len_failed = 0;
+		for (int i = 0; i < len_documents; ++i){
+			if(documents[i].result != PARSER_STEP_RESULT_SUCCESS)
+				len_failed++;
+			ParserLL1_Document_clear(&documents[i]);
+			free(documents[i].tkn_ptrs);
+		}
+
+		printf("{\"threads\": %d, \"documents\": %d, \"tokens\": %lld, \"seconds\": %.6f, \"tokens_per_second\": %.0f, \"speedup\": %.2f, \"failed\": %d}\n",
+			num_threads, len_documents, len_total_symbols, seconds, len_total_symbols / seconds, base_seconds / seconds, len_failed);
+	}
+
+	for (int i = 0; i < len_documents; ++i)
+		free(symbols[i]);
+	free(symbols);
+	free(len_symbols);
+	free(documents);
+	ParserLL1_Grammar_destroy(grm_ptr);
+	BenchGrammar_destroy(bgr_ptr);
+
+	return 0;
+}
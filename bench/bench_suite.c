@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "ParserLL1.h"
+#include "Token.h"
+#include "bench_grammars.h"
+
+// Measures grammar initialization time, parsing throughput on valid input,
+// throughput on input with errors and peak memory for several grammars.
+// Usage: bench_suite [tokens]
+//
+// Prints one JSON object per line for each grammar. Each grammar runs in its
+// own process so that peak memory is measured separately.
+
+
+///////////////
+// Constants //
+///////////////
+
+// Minimum total time spent initializing rules, to average short runs
+#define INIT_MIN_SECONDS 0.2
+
+// One in this many tokens is replaced in input with errors
+#define ERROR_INTERVAL 50
+
+
+/////////////
+// Helpers //
+/////////////
+
+static long peak_rss_kb(void){
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+// Parses all tokens with a new parser on grammar. Tokens are owned by the
+// parser afterwards
+static double parse(ParserLL1_Grammar *grm_ptr, Token **tkn_ptrs, int len_tkn_ptrs, Parser_StepResult_type *result_ptr, int *num_errors_ptr, int *peak_stack_depth_ptr){
+	ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+
+	int stop_index;
+	double start = bench_now();
+	*result_ptr = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_tkn_ptrs, &stop_index);
+	double seconds = bench_now() - start;
+
+	*num_errors_ptr = ParserLL1_get_num_errors(psr_ptr);
+	*peak_stack_depth_ptr = ParserLL1_get_peak_stack_depth(psr_ptr);
+
+	// Tokens not processed are still owned here
+	for (int i = stop_index; i < len_tkn_ptrs; ++i)
+		Token_destroy(tkn_ptrs[i]);
+
+	ParserLL1_destroy(psr_ptr);
+
+	return seconds;
+}
+
+static void run_benchmark(BenchGrammar *bgr_ptr, int len_tokens){
+	long base_rss_kb = peak_rss_kb();
+	unsigned int seed = 1;
+
+	// Initialization, repeated until enough time has passed
+	ParserLL1_Grammar *grm_ptr = NULL;
+	double init_seconds = 0;
+	int len_init_runs = 0;
+	while(init_seconds < INIT_MIN_SECONDS){
+		if(grm_ptr != NULL)
+			ParserLL1_Grammar_destroy(grm_ptr);
+		grm_ptr = BenchGrammar_build(bgr_ptr);
+
+		double start = bench_now();
+		ParserLL1_Grammar_initialize_rules(grm_ptr);
+		init_seconds += bench_now() - start;
+		len_init_runs++;
+	}
+
+	// Valid input
+	int *symbols = malloc( sizeof(int) * len_tokens );
+	int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, len_tokens, &seed);
+
+	Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+	Parser_StepResult_type result;
+	int num_errors, peak_stack_depth;
+	double parse_seconds = parse(grm_ptr, tkn_ptrs, len_symbols, &result, &num_errors, &peak_stack_depth);
+	free(tkn_ptrs);
+
+	// Same input with some tokens replaced by random terminals other than the
+	// end symbol
+	for (int i = ERROR_INTERVAL / 2; i < len_symbols - 1; i += ERROR_INTERVAL){
+		do{
+			symbols[i] = bgr_ptr->terminal_symbols[ rand_r(&seed) % bgr_ptr->len_terminal_symbols ];
+		}while(symbols[i] == bgr_ptr->end_symbol);
+	}
+
+	tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+	Parser_StepResult_type error_result;
+	int num_error_errors, error_peak_stack_depth;
+	double error_seconds = parse(grm_ptr, tkn_ptrs, len_symbols, &error_result, &num_error_errors, &error_peak_stack_depth);
+	free(tkn_ptrs);
+
+	printf("{\"grammar\": \"%s\", \"variables\": %d, \"terminals\": %d, \"rules\": %d, "
+		"\"init_seconds\": %.9f, \"init_runs\": %d, "
+		"\"tokens\": %d, \"parse_seconds\": %.6f, \"tokens_per_second\": %.0f, \"success\": %s, \"peak_stack_depth\": %d, "
+		"\"error_tokens_per_second\": %.0f, \"errors\": %d, "
+		"\"base_rss_kb\": %ld, \"peak_rss_kb\": %ld}\n",
+		bgr_ptr->name, bgr_ptr->len_variable_symbols, bgr_ptr->len_terminal_symbols, bgr_ptr->len_rules,
+		init_seconds / len_init_runs, len_init_runs,
+		len_symbols, parse_seconds, len_symbols / parse_seconds, result == PARSER_STEP_RESULT_SUCCESS ? "true" : "false", peak_stack_depth,
+		len_symbols / error_seconds, num_error_errors,
+		base_rss_kb, peak_rss_kb());
+
+	free(symbols);
+	ParserLL1_Grammar_destroy(grm_ptr);
+}
+
+
+//////////
+// Main //
+//////////
+
+int main(int argc, char *argv[]){
+	int len_tokens = argc > 1 ? atoi(argv[1]) : 1000000;
+	if(len_tokens < 64)
+		len_tokens = 64;
+
+	BenchGrammar *grammars[] = {
+		BenchGrammar_new_expression(),
+		BenchGrammar_new_json(),
+		BenchGrammar_new_generated(10, 1),
+		BenchGrammar_new_generated(100, 1),
+		BenchGrammar_new_generated(1000, 1),
+	};
+	int len_grammars = sizeof(grammars) / sizeof(grammars[0]);
+
+	for (int i = 0; i < len_grammars; ++i){
+		fflush(stdout);
+		pid_t pid = fork();
+
+		if(pid == 0){
+			run_benchmark(grammars[i], len_tokens);
+			fflush(stdout);
+			_exit(0);
+		}
+		else if(pid > 0){
+			waitpid(pid, NULL, 0);
+		}
+		else{
+			// Could not fork, peak memory includes earlier grammars
+			run_benchmark(grammars[i], len_tokens);
+		}
+	}
+
+	for (int i = 0; i < len_grammars; ++i)
+		BenchGrammar_destroy(grammars[i]);
+
+	return 0;
+}
@@ -1,9 +1,20 @@
 #ifndef INCLUDE_GUARD_FC41E67B8AC9429A8C4C6898EFB5E4FE
 #define INCLUDE_GUARD_FC41E67B8AC9429A8C4C6898EFB5E4FE
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "Token.h"
 #include "ParseTree.h"
 
+///////////////
+// Constants //
+///////////////
+
+// Maximum number of characters of token value kept for error messages
+#define PARSERLL1_LITERAL_MAX_CHAR 20
+
+
 ///////////
 // Types //
 ///////////
@@ -14,8 +25,19 @@ typedef enum{
 	PARSER_STEP_RESULT_FAIL = -1,
 	PARSER_STEP_RESULT_UNKNOWN_INPUT = -2,
 	PARSER_STEP_RESULT_HALTED = -3,
+	PARSER_STEP_RESULT_MAX_ERRORS = -4,
+	PARSER_STEP_RESULT_LIMIT_EXCEEDED = -5,
 } Parser_StepResult_type;
 
+typedef enum{
+	// Variable expanded by a rule
+	PARSERLL1_EVENT_ENTER,
+	// Terminal matched
+	PARSERLL1_EVENT_TOKEN,
+	// All symbols of a variable's expansion are done
+	PARSERLL1_EVENT_EXIT,
+} ParserLL1_EventType;
+
 
 /////////////////////
 // Data Structures //
@@ -23,6 +45,237 @@ typedef enum{
 
 typedef struct ParserLL1 ParserLL1;
 
+/**
+ * Symbols, rules and parse table of a grammar. Read only once rules are
+ * initialized, and can then be shared by any number of parsers across threads
+ */
+typedef struct ParserLL1_Grammar ParserLL1_Grammar;
+
+/**
+ * Parse tree node allocated by the parser in arena mode. Children are kept in
+ * order as a singly linked list. Also the form of the parse tree in
+ * incremental mode, read with ParserLL1_get_arena_tree
+ */
+typedef struct ParserLL1_Node ParserLL1_Node;
+
+/**
+ * Saved parse state of a parser, to return to with ParserLL1_restore
+ */
+typedef struct ParserLL1_Checkpoint ParserLL1_Checkpoint;
+
+struct ParserLL1_Node{
+	int symbol;
+	// Rule used to expand the node, 0 for matched terminals, -1 if the node
+	// was never expanded or matched
+	int rule_num;
+	// Position of the symbol in the expansion of the parent
+	int symbol_index;
+	// Position in the input of the matched token, counting from 0 since the
+	// parser was created or reset. -1 if no token was matched. Not updated
+	// when an edit moves the token in incremental mode
+	int token_index;
+	// Matched token, NULL if none or if the input was given as token records
+	Token *tkn_ptr;
+
+	ParserLL1_Node *parent;
+	ParserLL1_Node *first_child;
+	ParserLL1_Node *next_sibling;
+};
+
+/**
+ * Parse tree built in flat mode, as arrays indexed by node position in
+ * preorder. The root is at position 0, and the subtree of node i takes
+ * positions i to i + subtree_sizes[i] - 1. The next sibling of node i, if it
+ * has one, is at i + subtree_sizes[i]. Nodes have the same attributes as in
+ * ParserLL1_Event
+ */
+typedef struct ParserLL1_FlatTree{
+	int len_nodes;
+
+	int *symbols;
+	// Rule used to expand a variable, 0 for terminals, -1 if skipped by error
+	// recovery
+	int *rule_nums;
+	// Position of the symbol in the expansion of the parent, -1 for the root
+	int *symbol_indices;
+	// Matched token of terminals, owned by the tree. NULL for variables and
+	// terminals skipped by error recovery
+	Token **tkn_ptrs;
+	// Position in the input of the matched token of terminals, -1 for
+	// variables and terminals skipped by error recovery
+	int *token_indices;
+	// Number of nodes in the subtree of each node, including the node
+	int *subtree_sizes;
+	// Position of parent, -1 for the root
+	int *parents;
+}ParserLL1_FlatTree;
+
+/**
+ * Token given by symbol and position, without a Token object. Arrays of
+ * records are owned by the caller and are only read while they are parsed
+ */
+typedef struct ParserLL1_TokenRecord{
+	int symbol;
+	int line, column;
+	// Position and length of the token's text in the source
+	size_t offset;
+	int length;
+}ParserLL1_TokenRecord;
+
+/**
+ * Information about a syntax error
+ */
+typedef struct ParserLL1_Error{
+	int line, column;
+	int lookahead_symbol;
+	// Symbol on top of stack when error was detected
+	int top_symbol;
+	// Position in the input of the lookahead token, counting from 0 since the
+	// parser was created or reset
+	int token_index;
+
+	// Value of lookahead token, null terminated
+	char value[PARSERLL1_LITERAL_MAX_CHAR + 1];
+	// Set if value was longer than PARSERLL1_LITERAL_MAX_CHAR
+	int flag_value_truncated;
+}ParserLL1_Error;
+
+/**
+ * Event reported in event mode. Events follow the order of a depth first
+ * traversal of the parse tree, and ENTER and EXIT events of a variable
+ * enclose the events of its expansion
+ */
+typedef struct ParserLL1_Event{
+	ParserLL1_EventType type;
+	int symbol;
+	// Rule used to expand the variable for ENTER, -1 for ENTER and TOKEN if
+	// the symbol was skipped by error recovery. 0 otherwise
+	int rule_num;
+	// Position of the symbol in the expansion of the parent for ENTER and
+	// TOKEN, -1 for the start symbol and for EXIT
+	int symbol_index;
+	// Matched token for TOKEN, owned by the callback from then on. NULL if the
+	// terminal was skipped by error recovery, if the input was given as token
+	// records, and for other events
+	Token *tkn_ptr;
+	// Position in the input of the lookahead token when the event occurred,
+	// counting from 0 since the parser was created or reset
+	int token_index;
+}ParserLL1_Event;
+
+/**
+ * Counters of parser activity since the parser was created or last reset.
+ * Only collected if the library is built with PARSERLL1_STATS defined
+ */
+typedef struct ParserLL1_Stats{
+	// Tokens passed to the parser
+	long long tokens_consumed;
+	// Variables expanded by a rule
+	long long expansions;
+	// Expansions by rules with only the empty symbol
+	long long epsilon_expansions;
+	// Terminals matched, including the end symbol
+	long long terminal_matches;
+	long long errors_recorded;
+	// Tokens discarded during error recovery
+	long long tokens_discarded;
+	// Same as ParserLL1_get_peak_stack_depth, always set
+	int peak_stack_depth;
+	// Parse tree nodes allocated, 0 in event mode unless flat mode is used
+	long long nodes_allocated;
+	// Expansions by each rule, in the order the rules were added. Owned by the
+	// parser and valid until it is destroyed
+	long long *rule_expansions;
+	int len_rule_expansions;
+}ParserLL1_Stats;
+
+/**
+ * Bytes held by a parser and its grammar, as reported by
+ * ParserLL1_get_memory_usage. Tokens, and the internal bookkeeping of hash
+ * tables used while building the grammar, are not counted
+ */
+typedef struct ParserLL1_MemoryUsage{
+	// Grammar, possibly shared with other parsers. Symbol lists and symbol
+	// attributes
+	size_t grammar_symbols;
+	// Rules as added and in the form used while parsing
+	size_t grammar_rules;
+	// Nullable, first, follow and sync sets
+	size_t grammar_sets;
+	size_t grammar_parse_table;
+
+	// Current parse
+	size_t stack;
+	// Parse tree, arena or flat tree, while held by the parser
+	size_t tree;
+	// Error records and sync recovery sets
+	size_t errors;
+	// Input kept in incremental mode and token source buffer
+	size_t input;
+
+	// Sum of the current parse parts, which max_memory of
+	// ParserLL1_set_limits applies to
+	size_t parse_total;
+	// Sum of all parts
+	size_t total;
+}ParserLL1_MemoryUsage;
+
+/**
+ * Input and result of one document for ParserLL1_parse_documents and
+ * ParserLL1_parse_document_chunked
+ */
+typedef struct ParserLL1_Document{
+	// Input, set by user. Tokens up to stop_index are owned by the parser
+	// afterwards, as with ParserLL1_parse_tokens
+	Token **tkn_ptrs;
+	int len_tkn_ptrs;
+
+	// Output, set by parser
+	Parser_StepResult_type result;
+	int stop_index;
+	// Parse tree, complete or partial. Owned by user
+	ParseTree *tree;
+	// Errors in order of detection. NULL if none
+	ParserLL1_Error *errors;
+	int len_errors;
+}ParserLL1_Document;
+
+/**
+ * Initialized tables of a grammar as constant arrays, written by
+ * ParserLL1_Grammar_generate_c and read by ParserLL1_Grammar_from_tables. Arrays
+ * of length 0 may be NULL
+ */
+typedef struct ParserLL1_GrammarTables{
+	// Symbols, as given to ParserLL1_Grammar_new
+	const int *variable_symbols;
+	int len_variable_symbols;
+	const int *terminal_symbols;
+	int len_terminal_symbols;
+	int start_symbol;
+	int empty_symbol;
+	int end_symbol;
+	const int *forget_terminal_symbols;
+	int len_forget_terminal_symbols;
+
+	// Rules in parse table order. Expansion of rule i is
+	// expansion_symbols[rule_expansion_offsets[i]] onwards
+	const int *rule_nums;
+	const int *rule_variable_symbols;
+	const int *rule_expansion_offsets;
+	const int *rule_expansion_lengths;
+	int len_rules;
+	const int *expansion_symbols;
+	int len_expansion_symbols;
+
+	// Rule position for each variable and terminal index, row by variable, or
+	// -1 for no rule
+	const int *parse_table;
+	// First and follow sets by variable index, (len_terminal_symbols + 63) / 64
+	// words per row with bit i for terminal index i
+	const uint64_t *first_rows;
+	const uint64_t *follow_rows;
+}ParserLL1_GrammarTables;
+
 
 ////////////////////////////////
 // Constructors & Destructors //
@@ -43,16 +296,61 @@ typedef struct ParserLL1 ParserLL1;
  * identifier as input and returns a pointer to user allocated null terminated
  * string which can be printed. The string must be kept allocated until the
  * lifetime of the ParserLL1 struct
- * @return                      Pointer to ParserLL1 struct
+ * @return                      Pointer to ParserLL1 struct, or NULL if there
+ * are no variable or terminal symbols, or if the start, empty, end or a forget
+ * symbol lies outside the range of the listed symbols
  */
 ParserLL1 *ParserLL1_new(int *variable_symbols, int len_variable_symbols, int *terminal_symbols, int len_terminal_symbols, int start_symbol, int empty_symbol, int end_symbol, int *forget_terminal_symbols, int len_forget_terminal_symbols, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
 
 /**
- * Deallocates all internally allocated memory to the struct
+ * Deallocates all internally allocated memory to the struct. The grammar is
+ * freed too if the parser was created with ParserLL1_new
  * @param psr_ptr Pointer to ParserLL1 struct
  */
 void ParserLL1_destroy(ParserLL1 *psr_ptr);
 
+/**
+ * Allocates and initializes a ParserLL1_Grammar struct and returns a pointer to
+ * it. Parameters are the same as for ParserLL1_new. The callbacks may be called
+ * from multiple threads at once if the grammar is shared across threads
+ * @return Pointer to ParserLL1_Grammar struct, or NULL if the symbols are not
+ * valid, as for ParserLL1_new
+ */
+ParserLL1_Grammar *ParserLL1_Grammar_new(int *variable_symbols, int len_variable_symbols, int *terminal_symbols, int len_terminal_symbols, int start_symbol, int empty_symbol, int end_symbol, int *forget_terminal_symbols, int len_forget_terminal_symbols, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+
+/**
+ * Deallocates all internally allocated memory to the grammar. All parsers
+ * using the grammar must be destroyed first
+ * @param grm_ptr Pointer to ParserLL1_Grammar struct
+ */
+void ParserLL1_Grammar_destroy(ParserLL1_Grammar *grm_ptr);
+
+/**
+ * Allocates a parser which uses an existing grammar. The grammar is not copied
+ * and must be kept allocated for the lifetime of the parser. Rules of the
+ * grammar must be initialized before any parser using it is run. Creating a
+ * parser does not modify the grammar
+ * @param  grm_ptr Pointer to ParserLL1_Grammar struct
+ * @return         Pointer to ParserLL1 struct
+ */
+ParserLL1 *ParserLL1_new_session(ParserLL1_Grammar *grm_ptr);
+
+/**
+ * Discards the parse tree, stack and errors of the current parse, so that the
+ * parser can parse a new input. A parse tree obtained by
+ * ParserLL1_get_parse_tree is not freed. Arena mode and error settings are
+ * kept
+ * @param psr_ptr Pointer to ParserLL1 struct
+ */
+void ParserLL1_reset(ParserLL1 *psr_ptr);
+
+/**
+ * Returns the grammar used by the parser
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Pointer to ParserLL1_Grammar struct
+ */
+ParserLL1_Grammar *ParserLL1_get_grammar(ParserLL1 *psr_ptr);
+
 
 //////////////////////
 // Production rules //
@@ -72,6 +370,12 @@ void ParserLL1_destroy(ParserLL1 *psr_ptr);
  */
 void ParserLL1_add_rule(ParserLL1 *psr_ptr, int rule_num, int variable_symbol, int *expansion_symbols, int len_expansion_symbols);
 
+/**
+ * Same as ParserLL1_add_rule, for a grammar. Has no effect once rules are
+ * initialized
+ */
+void ParserLL1_Grammar_add_rule(ParserLL1_Grammar *grm_ptr, int rule_num, int variable_symbol, int *expansion_symbols, int len_expansion_symbols);
+
 /**
  * Calculates the first and follow sets for each symbol and initializes the
  * parse table
@@ -79,6 +383,105 @@ void ParserLL1_add_rule(ParserLL1 *psr_ptr, int rule_num, int variable_symbol, i
  */
 void ParserLL1_initialize_rules(ParserLL1 *psr_ptr);
 
+/**
+ * Same as ParserLL1_initialize_rules, for a grammar. The grammar is read only
+ * afterwards. Has no effect if called again
+ * @param grm_ptr Pointer to ParserLL1_Grammar struct
+ */
+void ParserLL1_Grammar_initialize_rules(ParserLL1_Grammar *grm_ptr);
+
+/**
+ * Same as ParserLL1_Grammar_initialize_rules, using several threads for large
+ * grammars. Independent groups of first and follow sets, and rows of the parse
+ * table, are calculated in parallel. The tables are identical to those built
+ * on one thread
+ * @param grm_ptr     Pointer to ParserLL1_Grammar struct
+ * @param num_threads Number of threads to use, including the calling thread
+ */
+void ParserLL1_Grammar_initialize_rules_parallel(ParserLL1_Grammar *grm_ptr, int num_threads);
+
+
+////////////////////
+// Grammar images //
+////////////////////
+
+/**
+ * Writes the initialized tables of a grammar to a binary image file, which can
+ * be loaded by ParserLL1_Grammar_load without recalculating them. The image
+ * contains no pointers, and can only be loaded on machines with the same byte
+ * order and int size
+ * @param  grm_ptr Pointer to ParserLL1_Grammar struct, with rules initialized
+ * @param  path    Path of file to write
+ * @return         0 on success, -1 on failure
+ */
+int ParserLL1_Grammar_save(ParserLL1_Grammar *grm_ptr, const char *path);
+
+/**
+ * Maps a grammar image written by ParserLL1_Grammar_save into memory and
+ * returns a grammar using it. Tables are used in place and are shared read only
+ * with other processes mapping the same file. The file must not be modified
+ * while the grammar exists. No rules can be added to the grammar. Callbacks are
+ * the same as for ParserLL1_Grammar_new
+ * @param  path Path of image file
+ * @return      Pointer to ParserLL1_Grammar struct, or NULL if the file could
+ * not be mapped or is not a valid image of the current version
+ */
+ParserLL1_Grammar *ParserLL1_Grammar_load(const char *path, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+
+/**
+ * Returns a grammar using a grammar image already in memory, such as one
+ * read into memory by the program. The image is used
+ * in place and never written, so it may be in read only memory. It must stay
+ * valid until the grammar is destroyed
+ * @param  image_ptr Pointer to image, aligned to 8 bytes
+ * @param  len_image Length of image in bytes
+ * @return           Pointer to ParserLL1_Grammar struct, or NULL if the image is
+ * not valid. Tables are checked to refer only to symbols, rules and expansion
+ * symbols that exist, so a damaged image is rejected rather than read out of
+ * bounds
+ */
+ParserLL1_Grammar *ParserLL1_Grammar_from_image(const void *image_ptr, size_t len_image, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+
+
+////////////////////////
+// Generated grammars //
+////////////////////////
+
+/**
+ * Returns a grammar using initialized tables compiled into the program, such
+ * as those written by ParserLL1_Grammar_generate_c. Tables are used in place and
+ * never written, and must stay valid until the grammar is destroyed. No rules
+ * can be added to the grammar. Callbacks are the same as for
+ * ParserLL1_Grammar_new
+ * @param  tbl_ptr Pointer to ParserLL1_GrammarTables struct
+ * @return         Pointer to ParserLL1_Grammar struct, or NULL if the tables
+ * are not valid. Tables are checked as with ParserLL1_Grammar_from_image
+ */
+ParserLL1_Grammar *ParserLL1_Grammar_from_tables(const ParserLL1_GrammarTables *tbl_ptr, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+
+/**
+ * Writes a C source file with a parser specialized to a grammar. It defines
+ * ParserLL1_Grammar *<name>_grammar_new(token_to_symbol, symbol_to_string, token_to_value),
+ * which returns the grammar from its initialized tables through
+ * ParserLL1_Grammar_from_tables, and <name>_step and <name>_parse_tokens, with
+ * the arguments and results of ParserLL1_step and ParserLL1_parse_tokens. These
+ * dispatch on the symbol on top of the stack and on the lookahead with switch
+ * statements, and push the expansion of each rule as constants, instead of
+ * reading the parse table and rules. Errors, recovery and tree building are
+ * shared with the library through ParserLL1_internal.h, so parsing behaves
+ * exactly as with the original grammar. Sessions of other grammars, and
+ * sessions in incremental mode, are handed to the library.
+ * The file must be compiled against the headers of the library it is linked
+ * with, and with PARSERLL1_STATS defined if the library was. Defining
+ * PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptr) before compiling it replaces
+ * calls to the token_to_symbol callback with an inline expression
+ * @param  grm_ptr Pointer to ParserLL1_Grammar struct, with rules initialized
+ * @param  path    Path of file to write
+ * @param  name    Prefix of generated identifiers, must be a valid C identifier
+ * @return         0 on success, -1 on failure
+ */
+int ParserLL1_Grammar_generate_c(ParserLL1_Grammar *grm_ptr, const char *path, const char *name);
+
 
 /////////
 // Run //
@@ -93,18 +496,315 @@ void ParserLL1_initialize_rules(ParserLL1 *psr_ptr);
  * @retval PARSER_STEP_RESULT_SUCCESS    Parsing complete, parse tree completely
  * constructed
  * @retval PARSER_STEP_RESULT_FAIL       Parsing failed
+ * @retval PARSER_STEP_RESULT_MAX_ERRORS Error limit set by
+ * ParserLL1_set_max_errors reached, parsing stopped
+ * @retval PARSER_STEP_RESULT_LIMIT_EXCEEDED Resource limit set by
+ * ParserLL1_set_limits reached, parsing stopped
  */
 Parser_StepResult_type ParserLL1_step(ParserLL1 *psr_ptr, Token *tkn_ptr);
 
+/**
+ * Processes tokens from @p tkn_ptrs in order, as if ParserLL1_step was called
+ * on each. Stops after a token for which ParserLL1_step would have returned
+ * PARSER_STEP_RESULT_SUCCESS, PARSER_STEP_RESULT_HALTED,
+ * PARSER_STEP_RESULT_UNKNOWN_INPUT, PARSER_STEP_RESULT_MAX_ERRORS or
+ * PARSER_STEP_RESULT_LIMIT_EXCEEDED. Tokens after that are not processed and
+ * remain owned by the caller
+ * @param  psr_ptr      Pointer to ParserLL1 struct
+ * @param  tkn_ptrs     Array of input tokens
+ * @param  len_tkn_ptrs Length of array
+ * @param  stop_index   Set to the number of tokens processed, which is the
+ * index of the first unprocessed token. Can be NULL
+ * @return              Status of the last processed token, or
+ * PARSER_STEP_RESULT_MORE_INPUT if the array is empty
+ */
+Parser_StepResult_type ParserLL1_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+
+/**
+ * Pulls tokens from a token source and processes them as if ParserLL1_step was
+ * called on each, until parsing is over, the source is exhausted or parsing
+ * stops at the error limit set by ParserLL1_set_max_errors. Tokens are pulled
+ * in chunks, and those pulled but not yet processed are kept by the parser for
+ * the next call. They are destroyed if the parser is reset or destroyed first.
+ * Tokens are owned by the parser once pulled
+ * @param  psr_ptr     Pointer to ParserLL1 struct
+ * @param  next_tokens User defined function that stores up to len_tkn_ptrs
+ * next tokens of the input in tkn_ptrs and returns how many were stored, 0 if
+ * no more tokens are available. Called as next_tokens(ctx, tkn_ptrs,
+ * len_tkn_ptrs)
+ * @param  ctx         User pointer passed to next_tokens
+ * @return             Status
+ * @retval PARSER_STEP_RESULT_MORE_INPUT   Source exhausted before parsing was
+ * over. Parsing continues on the next call. Errors found so far can be checked
+ * with ParserLL1_get_num_errors
+ * @retval PARSER_STEP_RESULT_SUCCESS      Parsing complete
+ * @retval PARSER_STEP_RESULT_HALTED       Parsing over, with errors
+ * @retval PARSER_STEP_RESULT_UNKNOWN_INPUT Last token was not a terminal
+ * @retval PARSER_STEP_RESULT_MAX_ERRORS   Error limit set by
+ * ParserLL1_set_max_errors with flag_stop reached, parsing stopped
+ * @retval PARSER_STEP_RESULT_LIMIT_EXCEEDED Resource limit set by
+ * ParserLL1_set_limits reached, parsing stopped
+ */
+Parser_StepResult_type ParserLL1_run(ParserLL1 *psr_ptr, int (*next_tokens)(void *, Token **, int), void *ctx);
+
+/**
+ * Processes token records in order, like ParserLL1_parse_tokens, without
+ * Token objects and without calling token_to_symbol. Matched terminals refer
+ * to the records by their position in the input, given by token_index of
+ * ParserLL1_Node, ParserLL1_Event and ParserLL1_FlatTree. Positions count
+ * every token since the parser was created or reset, so they are indices into
+ * @p records if the whole input is passed in one call. Only supported in
+ * arena, event and flat mode, and not in incremental mode
+ * @param  psr_ptr     Pointer to ParserLL1 struct
+ * @param  records     Array of input token records, not modified
+ * @param  len_records Length of array
+ * @param  source      Text the records point into, used for token values in
+ * error messages. Can be NULL, values are then empty
+ * @param  stop_index  Set to the number of records processed. Can be NULL
+ * @return             Status of the last processed record, or
+ * PARSER_STEP_RESULT_MORE_INPUT if the array is empty
+ * @retval PARSER_STEP_RESULT_FAIL Also returned without processing any record
+ * if the parser is in tree mode or incremental mode
+ */
+Parser_StepResult_type ParserLL1_parse_records(ParserLL1 *psr_ptr, const ParserLL1_TokenRecord *records, int len_records, const char *source, int *stop_index);
+
 /**
  * Returns a pointer to the internally constructed parse tree, if it has been
  * completely constructed. Otherwise returns NULL. The tree must be freed by the
- * user if this function is called
+ * user if this function is called. In arena mode the tree is a copy made on the
+ * first call, which takes the tokens from the arena tree. Returns NULL in event
+ * mode and incremental mode. In incremental mode the tree is read with
+ * ParserLL1_get_arena_tree instead, see ParserLL1_Node
  * @param  psr_ptr Pointer to ParserLL1 struct
  * @return         Pointer to ParseTree struct
  */
 ParseTree *ParserLL1_get_parse_tree(ParserLL1 *psr_ptr);
 
+/**
+ * Returns the maximum number of symbols held on the parse stack so far,
+ * including the end symbol
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Peak stack depth
+ */
+int ParserLL1_get_peak_stack_depth(ParserLL1 *psr_ptr);
+
+
+////////////////
+// Statistics //
+////////////////
+
+/**
+ * Copies the current statistics of the parser. Counters are updated on every
+ * step, and can be read at any time. If statistics are not compiled in, all
+ * counters except peak_stack_depth are 0 and rule_expansions is NULL
+ * @param  psr_ptr   Pointer to ParserLL1 struct
+ * @param  stats_ptr Pointer to struct to fill
+ * @return           1 if statistics are compiled in, else 0
+ */
+int ParserLL1_get_stats(ParserLL1 *psr_ptr, ParserLL1_Stats *stats_ptr);
+
+
+/////////////////////
+// Memory & limits //
+/////////////////////
+
+/**
+ * Reports the bytes currently held by the parser and its grammar
+ * @param psr_ptr Pointer to ParserLL1 struct
+ * @param usg_ptr Pointer to struct to fill
+ */
+void ParserLL1_get_memory_usage(ParserLL1 *psr_ptr, ParserLL1_MemoryUsage *usg_ptr);
+
+/**
+ * Limits the resources a parse can use. Limits are checked before each
+ * variable is expanded, and max_memory also before other growth of the parse.
+ * If the expansion or growth would go past a limit, parsing stops as with
+ * ParserLL1_set_max_errors: the step returns PARSER_STEP_RESULT_LIMIT_EXCEEDED
+ * and later steps return PARSER_STEP_RESULT_HALTED. The tree is kept as it was
+ * when parsing stopped. The limits are kept on reset
+ * @param psr_ptr         Pointer to ParserLL1 struct
+ * @param max_tree_nodes  Maximum number of parse tree nodes. In event mode
+ * without flat mode, counts the nodes the tree would have. 0 for no limit
+ * @param max_stack_depth Maximum number of entries on the parse stack,
+ * including the end symbol and the exit markers of event mode. 0 for no limit
+ * @param max_memory      Maximum bytes held by the current parse, as
+ * parse_total of ParserLL1_MemoryUsage. Checked before the stack or tree grows
+ * for an expansion, before input records grow for a token in incremental mode,
+ * and before ParserLL1_run allocates its token buffer. Not checked when
+ * ParserLL1_reparse inserts tokens, nor for error records, which are bounded
+ * with ParserLL1_set_max_errors instead. Checkpoints are owned by the user and
+ * not counted. 0 for no limit
+ */
+void ParserLL1_set_limits(ParserLL1 *psr_ptr, long long max_tree_nodes, int max_stack_depth, size_t max_memory);
+
+
+////////////////
+// Arena mode //
+////////////////
+
+/**
+ * Makes the parser allocate all parse tree nodes from large blocks owned by
+ * the parser instead of allocating each node separately. Must be called before
+ * the first call to ParserLL1_step, has no effect afterwards.
+ * ParserLL1_get_parse_tree still works in this mode, but copies the tree out of
+ * the arena on its first call and moves the tokens to the copy. Later calls
+ * return the same copy, and the arena tree keeps no tokens. Use
+ * ParserLL1_get_arena_tree to avoid the copy
+ * @param psr_ptr    Pointer to ParserLL1 struct
+ * @param block_size Number of nodes per block. 0 for default
+ */
+void ParserLL1_set_arena_mode(ParserLL1 *psr_ptr, int block_size);
+
+/**
+ * Returns the root of the parse tree constructed in arena mode, or NULL if the
+ * parser is not in arena mode. The tree is owned by the parser and stays valid
+ * until ParserLL1_release_arena_tree or ParserLL1_destroy is called
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Pointer to root node
+ */
+ParserLL1_Node *ParserLL1_get_arena_tree(ParserLL1 *psr_ptr);
+
+/**
+ * Releases all nodes of the arena parse tree at once, along with the tokens
+ * they hold. Nodes are not visited individually, only the tokens are
+ * destroyed. Parsing cannot continue after this call
+ * @param psr_ptr Pointer to ParserLL1 struct
+ */
+void ParserLL1_release_arena_tree(ParserLL1 *psr_ptr);
+
+
+////////////////
+// Event mode //
+////////////////
+
+/**
+ * Makes the parser report the parse as a stream of events instead of building
+ * a parse tree. No tree nodes are allocated, and memory use is bounded by the
+ * depth of the parse stack. ParserLL1_get_parse_tree returns NULL in this mode.
+ * Must be called before the first call to ParserLL1_step, has no effect
+ * afterwards or if arena mode is enabled. The mode is kept on reset
+ * @param psr_ptr        Pointer to ParserLL1 struct
+ * @param event_callback Function called with each event and ctx, from within
+ * ParserLL1_step. The event is only valid during the call
+ * @param ctx            User pointer passed to event_callback
+ */
+void ParserLL1_set_event_mode(ParserLL1 *psr_ptr, void (*event_callback)(ParserLL1_Event *, void *), void *ctx);
+
+
+///////////////
+// Flat mode //
+///////////////
+
+/**
+ * Makes the parser build the parse tree as a ParserLL1_FlatTree instead of
+ * linked nodes. Nodes are appended to the arrays in the order they are
+ * reached, so the tree can be walked linearly and freed without visiting
+ * nodes. Symbols not reached by the parse are not in the tree. Uses event
+ * mode internally, so the same conditions apply, and event mode cannot be
+ * enabled by the user as well. The mode is kept on reset
+ * @param psr_ptr Pointer to ParserLL1 struct
+ */
+void ParserLL1_set_flat_mode(ParserLL1 *psr_ptr);
+
+/**
+ * Returns the flat parse tree once parsing has ended, else NULL. The tree is
+ * owned by the user afterwards, and must be freed with
+ * ParserLL1_FlatTree_destroy. Returns NULL if called again before the parser
+ * is reset, or if the parser is not in flat mode
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Pointer to ParserLL1_FlatTree struct
+ */
+ParserLL1_FlatTree *ParserLL1_get_flat_tree(ParserLL1 *psr_ptr);
+
+/**
+ * Frees a flat parse tree along with its tokens
+ * @param ft_ptr Pointer to ParserLL1_FlatTree struct. Can be NULL
+ */
+void ParserLL1_FlatTree_destroy(ParserLL1_FlatTree *ft_ptr);
+
+
+/////////////////
+// Checkpoints //
+/////////////////
+
+/**
+ * Saves the parse state, so that tokens can be parsed speculatively and the
+ * parser returned to this point with ParserLL1_restore. The tree is shared
+ * with the parser and only the stack is copied, so the cost depends on the
+ * stack depth and not on the length of the input. Only supported in arena and
+ * flat mode, and not in incremental mode
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Pointer to ParserLL1_Checkpoint struct, to be freed with
+ * ParserLL1_Checkpoint_destroy. NULL if not supported in the current mode, or
+ * if the tree was taken by the user
+ */
+ParserLL1_Checkpoint *ParserLL1_checkpoint(ParserLL1 *psr_ptr);
+
+/**
+ * Returns the parser to the state saved in @p chk_ptr. Tree nodes and errors
+ * added since are discarded, and tokens processed since are destroyed. The
+ * checkpoint stays valid and can be restored again, but checkpoints taken
+ * after it become invalid and can only be destroyed. All checkpoints become
+ * invalid when the parser is reset, or the tree is released or taken
+ * @param psr_ptr Pointer to ParserLL1 struct
+ * @param chk_ptr Checkpoint taken on the same parser
+ */
+void ParserLL1_restore(ParserLL1 *psr_ptr, ParserLL1_Checkpoint *chk_ptr);
+
+/**
+ * Frees a checkpoint. The parser is not affected
+ * @param chk_ptr Pointer to ParserLL1_Checkpoint struct. Can be NULL
+ */
+void ParserLL1_Checkpoint_destroy(ParserLL1_Checkpoint *chk_ptr);
+
+
+/////////////////////////
+// Incremental parsing //
+/////////////////////////
+
+/**
+ * Makes the parser keep every token of the input, so that the input can later
+ * be edited with ParserLL1_reparse. Enables arena mode, and the parse tree is
+ * only available through ParserLL1_get_arena_tree, which replaces
+ * ParserLL1_get_parse_tree in this mode. The ParserLL1_Node tree it returns
+ * has the same shape as a ParseTree, stays owned by the parser and changes
+ * with each edit. Tokens are owned by the parser as usual, including those
+ * discarded by error recovery, and stay valid until they are removed by an
+ * edit or the parser is reset or destroyed. Must
+ * be called before the first call to ParserLL1_step, has no effect afterwards
+ * or if event mode is enabled. The mode is kept on reset
+ * @param psr_ptr Pointer to ParserLL1 struct
+ */
+void ParserLL1_set_incremental_mode(ParserLL1 *psr_ptr);
+
+/**
+ * Replaces tokens of the input processed so far, and updates the parse tree and
+ * errors to be the same as if the new input had been processed from the start
+ * by calling ParserLL1_step on each token. Parsing resumes from the state after
+ * the last matched token before the edit. Once the parser reaches the same
+ * state as the previous parse at a token after the edit, the rest of the
+ * previous tree is reused as is, so only the part of the input around the edit
+ * is parsed again. The rest can only be reused if the previous parse matched
+ * the end symbol. Finding the parser state also walks up the tree from the
+ * edit, so deep trees, as built by long right recursive lists, take longer.
+ * Nodes of the previous tree that are not reused are taken back by the arena
+ * for later nodes, so memory does not grow with the number of edits and
+ * pointers to those nodes become invalid. Tokens and nodes outside the edit
+ * are kept, so pointers to them stay valid, but the arena tree root may change
+ * @param  psr_ptr      Pointer to ParserLL1 struct, in incremental mode
+ * @param  edit_index   Position of the first replaced token in the input
+ * @param  len_removed  Number of tokens removed from the input, which are
+ * destroyed
+ * @param  tkn_ptrs     Tokens inserted at edit_index, owned by the parser
+ * afterwards. Can be NULL if len_tkn_ptrs is 0
+ * @param  len_tkn_ptrs Length of array
+ * @return              Status ParserLL1_step would have returned for the last
+ * token of the new input, PARSER_STEP_RESULT_MORE_INPUT if the input is empty,
+ * or PARSER_STEP_RESULT_FAIL without any change if the parser is not in
+ * incremental mode or the edit is outside the input
+ */
+Parser_StepResult_type ParserLL1_reparse(ParserLL1 *psr_ptr, int edit_index, int len_removed, Token **tkn_ptrs, int len_tkn_ptrs);
+
 
 ////////////
 // Errors //
@@ -124,4 +824,105 @@ void ParserLL1_print_errors(ParserLL1 *psr_ptr);
  */
 void ParserLL1_set_immediate_print_error(ParserLL1 *psr_ptr, int val);
 
+/**
+ * Limits the number of errors recorded in a parse. Records for all errors
+ * allowed are allocated at once, so no memory is allocated for errors while
+ * parsing. Once the limit is reached, further errors are still recovered from
+ * but not recorded, or parsing stops if flag_stop is set: the step returns
+ * PARSER_STEP_RESULT_MAX_ERRORS, and later steps return
+ * PARSER_STEP_RESULT_HALTED as after the end of parsing. The parse tree is kept
+ * as it was when parsing stopped. The limit is kept on reset
+ * @param psr_ptr    Pointer to ParserLL1 struct
+ * @param max_errors Maximum number of errors recorded, 0 for no limit
+ * @param flag_stop  Non zero to stop parsing at the limit
+ */
+void ParserLL1_set_max_errors(ParserLL1 *psr_ptr, int max_errors, int flag_stop);
+
+/**
+ * Returns the number of errors recorded so far
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @return         Number of errors
+ */
+int ParserLL1_get_num_errors(ParserLL1 *psr_ptr);
+
+/**
+ * Copies information about errors encountered so far, in order of detection
+ * @param  psr_ptr    Pointer to ParserLL1 struct
+ * @param  errors     Array to copy errors into
+ * @param  len_errors Length of array
+ * @return            Number of errors copied
+ */
+int ParserLL1_get_errors(ParserLL1 *psr_ptr, ParserLL1_Error *errors, int len_errors);
+
+
+////////////////////
+// Error recovery //
+////////////////////
+
+/**
+ * After an error, tokens are discarded until one that the symbol on top of the
+ * stack can use, which ParserLL1_parse_tokens, ParserLL1_parse_records and
+ * ParserLL1_run skip in a single pass. Sync recovery also stops at tokens that
+ * a symbol further down the stack can use, and pops the symbols above it as
+ * missing, so that a parse resumes at the next statement rather than
+ * discarding the rest of the input. Declared sync terminals, such as a
+ * statement terminator, stop recovery too: if no symbol on the stack can use
+ * one, it is discarded and recovery ends, so that the next error is recorded.
+ * Kept on reset
+ * @param psr_ptr          Pointer to ParserLL1 struct
+ * @param val              0 to only look at the top of the stack, non zero to
+ * use sync recovery
+ * @param sync_symbols     Terminals that stop recovery, replacing those
+ * declared earlier. Other symbols are ignored. Can be NULL if
+ * len_sync_symbols is 0
+ * @param len_sync_symbols Length of array
+ */
+void ParserLL1_set_sync_recovery(ParserLL1 *psr_ptr, int val, const int *sync_symbols, int len_sync_symbols);
+
+
+//////////////////////
+// Parallel parsing //
+//////////////////////
+
+/**
+ * Parses independent documents in parallel. Each document is parsed from the
+ * start symbol as if by ParserLL1_parse_tokens on a fresh parser, and its
+ * result, tree and errors are stored in the document. Documents are spread
+ * over the threads, and threads that finish early take over documents from
+ * busy threads. Returns when all documents are parsed
+ * @param grm_ptr       Pointer to ParserLL1_Grammar struct, with rules
+ * initialized
+ * @param documents     Array of documents, with input set
+ * @param len_documents Length of array
+ * @param num_threads   Number of threads to use, including the calling thread
+ */
+void ParserLL1_parse_documents(ParserLL1_Grammar *grm_ptr, ParserLL1_Document *documents, int len_documents, int num_threads);
+
+/**
+ * Parses one large document in parallel, for documents made of a list of
+ * items that each end with a sync terminal. The input is split into chunks
+ * after sync tokens, and chunks are parsed in parallel from @p list_symbol,
+ * assuming each starts a new item. Chunk trees are then joined in order.
+ * Chunks where the assumption does not hold, for example if the sync token
+ * was nested inside an item or a chunk has errors, are parsed again in
+ * sequence, so result, tree and errors are the same as with
+ * ParserLL1_parse_tokens on a fresh parser. Inputs too small to split are
+ * parsed in sequence
+ * @param grm_ptr     Pointer to ParserLL1_Grammar struct, with rules
+ * initialized
+ * @param doc_ptr     Document, with input set
+ * @param list_symbol Variable that derives the rest of the list, which is on
+ * top of the stack whenever an item starts
+ * @param sync_symbol Terminal that ends an item
+ * @param num_threads Number of threads to use, including the calling thread
+ */
+void ParserLL1_parse_document_chunked(ParserLL1_Grammar *grm_ptr, ParserLL1_Document *doc_ptr, int list_symbol, int sync_symbol, int num_threads);
+
+/**
+ * Frees the parse tree and errors of a document parsed by
+ * ParserLL1_parse_documents. Input tokens are not affected
+ * @param doc_ptr Pointer to ParserLL1_Document struct
+ */
+void ParserLL1_Document_clear(ParserLL1_Document *doc_ptr);
+
 #endif
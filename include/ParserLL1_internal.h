@@ -0,0 +1,592 @@
+#ifndef INCLUDE_GUARD_8AF8B87ABEF14CBFA899561C0F3B48C8
+#define INCLUDE_GUARD_8AF8B87ABEF14CBFA899561C0F3B48C8
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "ParserLL1.h"
+#include "ParseTree.h"
+#include "Token.h"
+#include "HashTable.h"
+
+// Parser state and step code shared by ParserLL1.c and generated parsers, so
+// both parse with the same tree building and error recovery. Not a stable
+// interface, generated parsers must be built with the header of the library
+// they are linked with
+
+
+///////////////
+// Constants //
+///////////////
+
+// Symbol index of stack entries marking the end of a variable's expansion in
+// event mode
+#define STACK_ENTRY_EXIT -2
+
+// Updates a statistics counter, if statistics are compiled in
+#ifdef PARSERLL1_STATS
+#define STATS_ADD(psr_ptr, counter, value) ((psr_ptr)->stats.counter += (value))
+#else
+#define STATS_ADD(psr_ptr, counter, value) ((void)0)
+#endif
+
+// Symbol attribute flags
+#define SYMBOL_FLAG_KNOWN		0x01
+#define SYMBOL_FLAG_TERMINAL	0x02
+#define SYMBOL_FLAG_FORGET		0x04
+#define SYMBOL_FLAG_NULLABLE	0x08
+#define SYMBOL_FLAG_END			0x10
+#define SYMBOL_FLAG_EMPTY		0x20
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+typedef struct Rule Rule;
+
+typedef struct NodeBlock NodeBlock;
+
+typedef struct ErrorBuffer ErrorBuffer;
+
+typedef struct StackEntry{
+	int symbol;
+	// Position of the symbol in the expansion of its parent, -1 for start and
+	// end symbol. STACK_ENTRY_EXIT for exit markers in event mode
+	int symbol_index;
+	// Tree node of the symbol. ParseTree_Node, or ParserLL1_Node in arena
+	// mode. NULL in event mode and for end symbol, which does not belong to
+	// tree
+	void *node_ptr;
+}StackEntry;
+
+// Token of the input kept in incremental mode, with the parser state before
+// it was processed
+typedef struct InputRecord{
+	Token *tkn_ptr;
+	// Leaf the token was matched to, NULL if it was not matched
+	ParserLL1_Node *leaf_node_ptr;
+	// Length of parse stack before the token was processed
+	int len_stack;
+}InputRecord;
+
+typedef struct CompiledRule{
+	int rule_num;
+	int variable_symbol;
+	// Expansion symbols are expansion_pool[expansion_offset] onwards
+	int expansion_offset;
+	int len_expansion_symbols;
+}CompiledRule;
+
+typedef struct SymbolAttr{
+	// Position of the symbol in variable_symbols or terminal_symbols
+	int index;
+	// Combination of SYMBOL_FLAG_*
+	int flags;
+}SymbolAttr;
+
+typedef struct ParserLL1_Grammar{
+
+	// Symbols
+
+	int *variable_symbols;
+	int len_variable_symbols;
+	// Minimum and maximum of variable symbols
+	int variable_symbols_min, variable_symbols_max;
+
+	int *terminal_symbols;
+	int len_terminal_symbols;
+	// Minimum and maximum of terminal symbols
+	int terminal_symbols_min, terminal_symbols_max;
+
+	// Minimum and maximum of all symbols
+	int symbols_min, symbols_max;
+
+	// Attributes of each symbol, indexed by (symbol - symbols_min). Unknown
+	// symbols have index -1 and no flags
+	SymbolAttr *symbol_attr_table;
+
+	int start_symbol;
+	int empty_symbol;
+	int end_symbol;
+
+	// Terminals that user might forget
+	int *forget_terminal_symbols;
+	int len_forget_terminal_symbols;
+
+
+	// Rules
+
+	HashTable *rule_table;
+
+	// All rules in order of addition. Parse table entries index this list
+	Rule **rule_list;
+	int len_rule_list;
+	int cap_rule_list;
+
+	// Sets used to build the tables are indexed by position of the symbol in
+	// variable_symbols or terminal_symbols, as given by symbol_attr_table, so
+	// their size does not depend on the range of symbol values
+
+	// First sets do not capture epsilon reachability. Row of
+	// (len_variable_symbols + 63) / 64 words, where bit i stands for
+	// variable_symbols[i]
+	uint64_t *nullable_set;
+	HashTable *parse_table;
+
+	// Dense parse table, len_variable_symbols rows of len_terminal_symbols
+	// columns, indexed by symbol_attr_table. Entries are indices into
+	// rule_list, -1 if no entry. NULL if it could not be allocated, in which
+	// case parse_table is used instead
+	int *dense_parse_table;
+
+	// Rules in the form used while parsing, indexed like rule_list
+	CompiledRule *compiled_rules;
+	int len_compiled_rules;
+	// Expansion symbols of all compiled rules
+	int *expansion_pool;
+	int len_expansion_pool;
+
+	// First and follow set of each variable, ordered as variable_symbols.
+	// Each is a row of len_set_words words, where bit i stands for
+	// terminal_symbols[i]. Built in place when rules are initialized
+	uint64_t *first_rows;
+	uint64_t *follow_rows;
+	int len_set_words;
+	// Set union kernel for the CPU, a WordSet_OrFunction chosen when the
+	// grammar is created
+	int (*or_words)(uint64_t *dst, const uint64_t *src, int len_words);
+
+	// Terminals at which error recovery stops skipping input while each
+	// variable is on top of the stack, being its first set joined with its
+	// follow set. Rows like first_rows. Built after the tables, also for a
+	// loaded grammar
+	uint64_t *sync_rows;
+
+	// Image the grammar was loaded from. NULL if grammar was built from
+	// rules. Tables of a loaded grammar point into the image, and the hash
+	// tables and sets used to build them are NULL
+	void *image_ptr;
+	size_t len_image;
+	// Set if image was mapped by ParserLL1_Grammar_load
+	int flag_image_mapped;
+	// Tables the grammar was created from by ParserLL1_Grammar_from_tables,
+	// else NULL. Tables are user constants, except symbol attributes and
+	// compiled rules, which are built from them. Generated parsers check it
+	// to only step parsers of their own grammar
+	const ParserLL1_GrammarTables *tables_ptr;
+
+	// Callbacks
+
+	int (*token_to_symbol)(Token *);
+	char *(*symbol_to_string)(int);
+	void (*token_to_value)(Token *, char *, int);
+
+	// Set once rules are initialized, grammar is read only afterwards
+	int flag_rules_initialized;
+
+}ParserLL1_Grammar;
+
+typedef struct ParserLL1{
+
+	// Grammar, possibly shared with other parsers
+	ParserLL1_Grammar *grm_ptr;
+	// If 1, grammar is freed when parser is destroyed
+	int flag_owns_grammar;
+
+	// Parsing
+
+	// Parse stack, top is at the end
+	StackEntry *stack;
+	int len_stack;
+	int cap_stack;
+	int peak_stack_depth;
+
+	ParseTree_Node *tree;
+	// Nodes of current parse tree. Counted as symbols are pushed, so also
+	// counted in event mode
+	long long num_tree_nodes;
+
+	// Arena mode
+
+	int flag_arena_mode;
+	int arena_block_size;
+	// Most recently allocated block first
+	NodeBlock *arena_block_list;
+	int len_arena_blocks;
+	ParserLL1_Node *arena_tree;
+	// Nodes dropped by ParserLL1_reparse, linked by next_sibling
+	ParserLL1_Node *arena_free_list;
+
+	// Event mode
+
+	int flag_event_mode;
+	void (*event_callback)(ParserLL1_Event *, void *);
+	void *event_ctx;
+
+	// Flat mode, built from events
+
+	int flag_flat_mode;
+	ParserLL1_FlatTree *flat_tree;
+	int cap_flat_nodes;
+	// Positions of variables entered but not exited, innermost last
+	int *flat_open_nodes;
+	int len_flat_open_nodes;
+	int cap_flat_open_nodes;
+
+	// Number of tokens received in current parse
+	int num_tokens;
+
+	// Incremental mode
+
+	int flag_incremental_mode;
+	// Every token of the input in order, owned by the parser. Tree nodes only
+	// refer to them
+	InputRecord *input_records;
+	int len_input_records;
+	int cap_input_records;
+	// Position of the token that matched the end symbol, -1 if not matched
+	int end_token_index;
+
+	// Tokens pulled from a token source but not yet processed. Kept for the
+	// next call to ParserLL1_run
+	Token **run_buffer;
+	int len_run_buffer;
+	int pos_run_buffer;
+
+	// Record being processed by ParserLL1_parse_records, NULL when the input
+	// is given as tokens. Its text starts at record_source + offset
+	const ParserLL1_TokenRecord *record_ptr;
+	const char *record_source;
+
+	int flag_errors_found;
+	int flag_halted;
+	int flag_error_recovery;
+	int flag_immediate_print_error;
+	// If 1, error recovery stops at any token a symbol on the stack can use
+	int flag_sync_recovery;
+	// Terminals declared by user to stop error recovery, a row of
+	// len_set_words words allocated once sync recovery is enabled
+	uint64_t *sync_terminal_row;
+	// Row i holds the declared terminals and every terminal stack entries 0
+	// to i can use. Rows below len_recovery_rows are valid, pushes and other
+	// writes to the stack lower it to the entry written
+	uint64_t *recovery_rows;
+	int len_recovery_rows;
+	int cap_recovery_rows;
+	int flag_free_parse_tree;
+	// If 1, tokens belong to the caller and are never destroyed. Used for
+	// chunks of a document, which may have to be parsed again
+	int flag_borrowed_tokens;
+
+	// Errors in order of detection
+	ErrorBuffer *errors;
+	int num_errors;
+	int cap_errors;
+	// Errors beyond this are not recorded, 0 for no limit
+	int max_errors;
+	// If 1, parsing stops once max_errors errors are recorded
+	int flag_stop_at_max_errors;
+	// Set if errors were found but not recorded because of the limit
+	int flag_errors_dropped;
+
+	// Resource limits, 0 for no limit
+	long long max_tree_nodes;
+	int max_stack_depth;
+	size_t max_memory;
+	// Set if any resource limit is set
+	int flag_limits;
+
+	// Statistics, only updated if compiled in. Rule expansion counts are
+	// allocated with the parser
+	ParserLL1_Stats stats;
+
+}ParserLL1;
+
+typedef struct NodeBlock{
+	// Next older block
+	NodeBlock *next;
+
+	int len_nodes;
+	int cap_nodes;
+	ParserLL1_Node nodes[];
+}NodeBlock;
+
+
+///////////
+// Steps //
+///////////
+
+/**
+ * Matches the end symbol on top of the stack, which ends parsing
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @param  tkn_ptr Lookahead token, NULL if input is given as records
+ * @return         PARSER_STEP_RESULT_SUCCESS, or PARSER_STEP_RESULT_HALTED if
+ * errors were found
+ */
+Parser_StepResult_type ParserLL1_step_end(ParserLL1 *psr_ptr, Token *tkn_ptr);
+
+/**
+ * Handles a lookahead that does not match the terminal on top of the stack
+ * @param  psr_ptr          Pointer to ParserLL1 struct
+ * @param  top_symbol_flags Attribute flags of the terminal on top
+ * @param  tkn_ptr          Lookahead token, NULL if input is given as records
+ * @param  result_ptr       Set to the result of the step if it is over
+ * @return                  1 if the step goes on with the new top of stack, 0
+ * if it is over
+ */
+int ParserLL1_step_mismatch(ParserLL1 *psr_ptr, int top_symbol_flags, Token *tkn_ptr, Parser_StepResult_type *result_ptr);
+
+/**
+ * Handles a lookahead for which the variable on top of the stack has no rule
+ * @param  psr_ptr          Pointer to ParserLL1 struct
+ * @param  lookahead_symbol Symbol of lookahead
+ * @param  tkn_ptr          Lookahead token, NULL if input is given as records
+ * @param  result_ptr       Set to the result of the step if it is over
+ * @return                  1 if the step goes on with the new top of stack, 0
+ * if it is over
+ */
+int ParserLL1_step_no_rule(ParserLL1 *psr_ptr, int lookahead_symbol, Token *tkn_ptr, Parser_StepResult_type *result_ptr);
+
+/**
+ * Checks whether expanding the variable on top of the stack by a rule would
+ * exceed a resource limit of the parser
+ * @param  psr_ptr Pointer to ParserLL1 struct
+ * @param  crl_ptr Rule to expand by
+ * @return         1 if a limit would be exceeded, else 0
+ */
+int ParserLL1_expansion_exceeds_limits(ParserLL1 *psr_ptr, const CompiledRule *crl_ptr);
+
+/**
+ * Discards the tokens at the start of an array that error recovery would skip
+ * one by one, as ParserLL1_parse_tokens does between steps
+ * @param  psr_ptr      Pointer to ParserLL1 struct
+ * @param  tkn_ptrs     Array of tokens
+ * @param  len_tkn_ptrs Length of array
+ * @return              Number of tokens discarded
+ */
+int ParserLL1_skip_recovery_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs);
+
+
+///////////
+// Stack //
+///////////
+
+static inline void stack_push(ParserLL1 *psr_ptr, int symbol, int symbol_index, void *node_ptr){
+	if(psr_ptr->len_stack == psr_ptr->cap_stack){
+		// Full, double capacity
+		psr_ptr->cap_stack *= 2;
+		psr_ptr->stack = realloc( psr_ptr->stack, sizeof(StackEntry) * psr_ptr->cap_stack );
+	}
+
+	if(psr_ptr->len_stack < psr_ptr->len_recovery_rows)
+		psr_ptr->len_recovery_rows = psr_ptr->len_stack;
+
+	psr_ptr->stack[psr_ptr->len_stack].symbol = symbol;
+	psr_ptr->stack[psr_ptr->len_stack].symbol_index = symbol_index;
+	psr_ptr->stack[psr_ptr->len_stack].node_ptr = node_ptr;
+	psr_ptr->len_stack++;
+
+	if(psr_ptr->len_stack > psr_ptr->peak_stack_depth)
+		psr_ptr->peak_stack_depth = psr_ptr->len_stack;
+}
+
+
+///////////
+// Nodes //
+///////////
+
+static inline void emit_event(ParserLL1 *psr_ptr, ParserLL1_EventType type, int symbol, int rule_num, int symbol_index, Token *tkn_ptr){
+	ParserLL1_Event evt;
+
+	evt.type = type;
+	evt.symbol = symbol;
+	evt.rule_num = rule_num;
+	evt.symbol_index = symbol_index;
+	evt.tkn_ptr = tkn_ptr;
+	// Lookahead is the latest token
+	evt.token_index = psr_ptr->num_tokens - 1;
+
+	psr_ptr->event_callback(&evt, psr_ptr->event_ctx);
+}
+
+static inline ParserLL1_Node *arena_node_new(ParserLL1 *psr_ptr, int symbol, ParserLL1_Node *parent_node_ptr){
+	ParserLL1_Node *node_ptr = psr_ptr->arena_free_list;
+
+	if(node_ptr != NULL){
+		// Reuse a node dropped by reparse
+		psr_ptr->arena_free_list = node_ptr->next_sibling;
+	}
+	else{
+		NodeBlock *blk_ptr = psr_ptr->arena_block_list;
+
+		if(blk_ptr == NULL || blk_ptr->len_nodes == blk_ptr->cap_nodes){
+			// Current block full, start a new one
+			blk_ptr = malloc( sizeof(NodeBlock) + sizeof(ParserLL1_Node) * psr_ptr->arena_block_size );
+			blk_ptr->len_nodes = 0;
+			blk_ptr->cap_nodes = psr_ptr->arena_block_size;
+			blk_ptr->next = psr_ptr->arena_block_list;
+			psr_ptr->arena_block_list = blk_ptr;
+			psr_ptr->len_arena_blocks++;
+		}
+
+		node_ptr = &(blk_ptr->nodes[blk_ptr->len_nodes++]);
+	}
+
+	node_ptr->symbol = symbol;
+	node_ptr->rule_num = -1;
+	node_ptr->symbol_index = -1;
+	node_ptr->token_index = -1;
+	node_ptr->tkn_ptr = NULL;
+	node_ptr->parent = parent_node_ptr;
+	node_ptr->first_child = NULL;
+	node_ptr->next_sibling = NULL;
+
+	return node_ptr;
+}
+
+static inline void node_set_token(ParserLL1 *psr_ptr, StackEntry *ent_ptr, Token *tkn_ptr){
+	void *node_ptr = ent_ptr->node_ptr;
+
+	if(psr_ptr->flag_event_mode == 1){
+		// Token is passed on to user
+		emit_event(psr_ptr, PARSERLL1_EVENT_TOKEN, ent_ptr->symbol, 0, ent_ptr->symbol_index, tkn_ptr);
+	}
+	else if(psr_ptr->flag_arena_mode == 1){
+		((ParserLL1_Node *)node_ptr)->tkn_ptr = tkn_ptr;
+		((ParserLL1_Node *)node_ptr)->token_index = psr_ptr->num_tokens - 1;
+		((ParserLL1_Node *)node_ptr)->rule_num = 0;
+
+		if(psr_ptr->flag_incremental_mode == 1)
+			psr_ptr->input_records[psr_ptr->num_tokens - 1].leaf_node_ptr = node_ptr;
+	}
+	else{
+		((ParseTree_Node *)node_ptr)->tkn_ptr = tkn_ptr;
+		((ParseTree_Node *)node_ptr)->rule_num = 0;
+	}
+}
+
+static inline void node_set_rule_num(ParserLL1 *psr_ptr, StackEntry *ent_ptr, int rule_num){
+	void *node_ptr = ent_ptr->node_ptr;
+
+	if(psr_ptr->flag_event_mode == 1){
+		// Exit marker goes below the expansion symbols
+		emit_event(psr_ptr, PARSERLL1_EVENT_ENTER, ent_ptr->symbol, rule_num, ent_ptr->symbol_index, NULL);
+		stack_push(psr_ptr, ent_ptr->symbol, STACK_ENTRY_EXIT, NULL);
+	}
+	else if(psr_ptr->flag_arena_mode == 1)
+		((ParserLL1_Node *)node_ptr)->rule_num = rule_num;
+	else
+		((ParseTree_Node *)node_ptr)->rule_num = rule_num;
+}
+
+static inline void *node_create_child(ParserLL1 *psr_ptr, void *parent_node_ptr, int symbol, int symbol_index){
+	if(psr_ptr->flag_event_mode == 1)
+		return NULL;
+
+	STATS_ADD(psr_ptr, nodes_allocated, 1);
+
+	if(psr_ptr->flag_arena_mode == 1){
+		// Add at left end, expansions are traversed in reverse
+		ParserLL1_Node *prt_ptr = parent_node_ptr;
+		ParserLL1_Node *chd_ptr = arena_node_new(psr_ptr, symbol, prt_ptr);
+		chd_ptr->symbol_index = symbol_index;
+		chd_ptr->next_sibling = prt_ptr->first_child;
+		prt_ptr->first_child = chd_ptr;
+		return chd_ptr;
+	}
+
+	ParseTree_Node *chd_ptr = ParseTree_Node_create_child_left_end(parent_node_ptr, symbol, NULL);
+	chd_ptr->symbol_index = symbol_index;
+	return chd_ptr;
+}
+
+
+//////////////////
+// Step Helpers //
+//////////////////
+
+static inline void discard_token(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	// Input keeps token in incremental mode, records and borrowed tokens are
+	// owned by caller
+	if(psr_ptr->flag_incremental_mode == 0 && psr_ptr->flag_borrowed_tokens == 0 && tkn_ptr != NULL)
+		Token_destroy(tkn_ptr);
+}
+
+static inline Parser_StepResult_type stop_parsing(ParserLL1 *psr_ptr, Token *tkn_ptr, Parser_StepResult_type result){
+	// Tree is left as it is, with symbols still on the stack never expanded.
+	// Further tokens are discarded as after the end of parsing
+	psr_ptr->len_stack = 0;
+	psr_ptr->flag_halted = 1;
+
+	discard_token(psr_ptr, tkn_ptr);
+	STATS_ADD(psr_ptr, tokens_discarded, 1);
+
+	return result;
+}
+
+static inline Parser_StepResult_type step_unknown_input(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	// Free token, as not added to parse tree, will be lost otherwise
+	discard_token(psr_ptr, tkn_ptr);
+
+	return PARSER_STEP_RESULT_UNKNOWN_INPUT;
+}
+
+static inline Parser_StepResult_type step_halted(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	// No symbols on the stack are left, parsing has ended. Free token, as not
+	// added to parse tree, will be lost otherwise
+	discard_token(psr_ptr, tkn_ptr);
+
+	return PARSER_STEP_RESULT_HALTED;
+}
+
+static inline void step_exit(ParserLL1 *psr_ptr, StackEntry *top_ent_ptr){
+	// All symbols of a variable's expansion are done
+	emit_event(psr_ptr, PARSERLL1_EVENT_EXIT, top_ent_ptr->symbol, 0, -1, NULL);
+	psr_ptr->len_stack--;
+}
+
+static inline Parser_StepResult_type step_match(ParserLL1 *psr_ptr, StackEntry *top_ent_ptr, Token *tkn_ptr){
+	// This step was successful
+	psr_ptr->flag_error_recovery = 0;
+	STATS_ADD(psr_ptr, terminal_matches, 1);
+
+	// Terminal rule number is 0
+	node_set_token(psr_ptr, top_ent_ptr, tkn_ptr);
+
+	// No need to free popped node, already exists in tree. Stack not empty,
+	// require more input
+	psr_ptr->len_stack--;
+	return PARSER_STEP_RESULT_MORE_INPUT;
+}
+
+static inline void *step_expand(ParserLL1 *psr_ptr, StackEntry *top_ent_ptr, int rule_num, int rule_index){
+	// Pops the variable on top and returns its node, for the children pushed
+	// by step_push_child in reverse order. rule_index is only used for
+	// statistics
+	(void)rule_index;
+
+	// This step was successful
+	psr_ptr->flag_error_recovery = 0;
+
+	// No need to free popped node, already exists in tree. Entry is copied,
+	// as pushing can move the stack
+	StackEntry parent_ent = *top_ent_ptr;
+	psr_ptr->len_stack--;
+	// Add rule number to popped node
+	node_set_rule_num(psr_ptr, &parent_ent, rule_num);
+
+	STATS_ADD(psr_ptr, expansions, 1);
+	STATS_ADD(psr_ptr, rule_expansions[rule_index], 1);
+
+	return parent_ent.node_ptr;
+}
+
+static inline void step_push_child(ParserLL1 *psr_ptr, void *parent_node_ptr, int symbol, int symbol_index){
+	// Add a new node to tree, and push it onto stack
+	void *child_node_ptr = node_create_child(psr_ptr, parent_node_ptr, symbol, symbol_index);
+	stack_push(psr_ptr, symbol, symbol_index, child_node_ptr);
+	psr_ptr->num_tree_nodes++;
+}
+
+#endif
@@ -1,13 +1,20 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "ParserLL1.h"
+#include "ParserLL1_internal.h"
 #include "ParseTree.h"
 #include "Token.h"
-#include "LinkedList.h"
 #include "HashTable.h"
-#include "BitSet.h"
+#include "WorkPool.h"
+#include "WordSet.h"
 
 #include <stdio.h>
 
@@ -15,86 +22,95 @@
 // Constants //
 ///////////////
 
-#define PARSERLL1_LITERAL_MAX_CHAR 20
-
-// ANSI escape codes to print to console
-#define TEXT_RED	"\x1B[31m"
-#define TEXT_GRN	"\x1B[32m"
-#define TEXT_YLW	"\x1B[33m"
-#define TEXT_BLD	"\x1B[1m"
-#define TEXT_RST	"\x1B[0m"
-
-
-/////////////////////
-// Data Structures //
-/////////////////////
-
-typedef struct ParserLL1{
-
-	// Symbols
-
-	int *variable_symbols;
-	int len_variable_symbols;
-	// Minimum and maximum for BitSet
-	int variable_symbols_min, variable_symbols_max;
+// Initial number of entries the parse stack can hold before growing
+#define PARSERLL1_INITIAL_STACK_SIZE 64
 
-	int *terminal_symbols;
-	int len_terminal_symbols;
-	// Minimum and maximum for BitSet
-	int terminal_symbols_min, terminal_symbols_max;
+// Number of nodes in an arena block if not specified by user
+#define PARSERLL1_DEFAULT_ARENA_BLOCK_SIZE 4096
 
-	// Minimum and maximum of all symbols
-	int symbols_min, symbols_max;
+// Initial number of nodes a flat tree can hold before growing
+#define PARSERLL1_INITIAL_FLAT_TREE_SIZE 1024
 
-	int start_symbol;
-	int empty_symbol;
-	int end_symbol;
+// Initial number of errors that can be recorded before growing, if there is
+// no limit
+#define PARSERLL1_INITIAL_ERRORS_SIZE 16
 
-	// Terminals that user might forget
-	int *forget_terminal_symbols;
-	int len_forget_terminal_symbols;
+// Number of tokens pulled from a token source at once
+#define PARSERLL1_RUN_CHUNK_SIZE 256
 
-	// Set for terminals, clear for variables
-	BitSet *symbol_class_set;
+// Chunks per thread when a document is parsed in chunks, so that threads
+// finishing early can take over chunks of busy threads
+#define PARSERLL1_CHUNKS_PER_THREAD 4
 
-	// Set for marking forget terminal symbols
-	BitSet *forget_terminal_symbol_set;
+// Minimum number of tokens in a chunk of a document parsed in chunks
+#define PARSERLL1_MIN_CHUNK_TOKENS 4096
 
+// Minimum number of independent parse table rows or set components for
+// grammar initialization to hand them to threads
+#define PARSERLL1_MIN_PARALLEL_GRAMMAR_TASKS 256
 
-	// Rules
+// Bytes of one flat tree node, over all arrays of the tree
+#define FLAT_NODE_SIZE ( sizeof(int) * 6 + sizeof(Token *) )
 
-	HashTable *rule_table;
+// Symbol index of old nodes taken over by ParserLL1_reparse, while the rest of
+// the old parse is freed
+#define NODE_ADOPTED -3
 
-	// First set table does not capture epsilon reachability 
-	BitSet *nullable_set;
-	HashTable *first_table;
-	HashTable *follow_table;
-	HashTable *parse_table;
+// Grammar image identification
+#define GRAMMAR_IMAGE_MAGIC "PLL1GRM"
+#define GRAMMAR_IMAGE_VERSION 1
+#define GRAMMAR_IMAGE_BYTE_ORDER 0x01020304
 
-	// Parsing
+// ANSI escape codes to print to console
+#define TEXT_RED	"\x1B[31m"
+#define TEXT_GRN	"\x1B[32m"
+#define TEXT_YLW	"\x1B[33m"
+#define TEXT_BLD	"\x1B[1m"
+#define TEXT_RST	"\x1B[0m"
 
-	int (*token_to_symbol)(Token *);
-	char *(*symbol_to_string)(int);
-	void (*token_to_value)(Token *, char *, int);
 
-	LinkedList *stack;
-	ParseTree_Node *tree;
+/////////////////////
+// Data Structures //
+/////////////////////
 
+// Sibling link changed when resuming a parse in incremental mode
+typedef struct RestoredLink{
+	// NULL if the whole old tree was dropped
+	ParserLL1_Node *node_ptr;
+	// Next sibling in the old parse
+	ParserLL1_Node *next_sibling;
+}RestoredLink;
+
+typedef struct ParserLL1_Checkpoint{
+	// Copy of the stack. Nodes it refers to are shared with the parser, and
+	// were all unexpanded when the checkpoint was taken
+	StackEntry *stack;
+	int len_stack;
+
+	int num_tokens;
+	long long num_tree_nodes;
+	int num_errors;
 	int flag_errors_found;
-	int flag_halted;
+	int flag_errors_dropped;
 	int flag_error_recovery;
-	int flag_immediate_print_error;
-	int flag_free_parse_tree;
-
-	LinkedList *error_list;
+	int flag_halted;
 
-}ParserLL1;
+	// End of arena. Nodes allocated after it are freed on restore
+	NodeBlock *arena_block_ptr;
+	int len_arena_block_nodes;
 
-typedef struct Rule Rule;
+	// Flat tree size, and copy of the variables open in it
+	int len_flat_nodes;
+	int *flat_open_nodes;
+	int len_flat_open_nodes;
+}ParserLL1_Checkpoint;
 
 typedef struct Rule{
 	int rule_num;
 
+	// Position in rule list
+	int rule_index;
+
 	int variable_symbol;
 	int *expansion_symbols;
 	int len_expansion_symbols;
@@ -103,12 +119,102 @@ typedef struct Rule{
 	Rule *next;
 }Rule;
 
+// Set inclusions found while calculating first and follow tables. Set of
+// from_indices[i] includes set of to_indices[i]
+typedef struct SetDependencies{
+	int *from_indices;
+	int *to_indices;
+	int len_dependencies;
+	int cap_dependencies;
+}SetDependencies;
+
+// Strongly connected components of the set dependency graph, solved one level
+// at a time. Components of a level only depend on components of lower levels
+typedef struct SetComponents{
+	uint64_t *sets;
+	int len_set_words;
+	WordSet_OrFunction or_words;
+
+	// Dependencies of set i are dep_targets[dep_offsets[i]] to
+	// dep_targets[dep_offsets[i+1] - 1]
+	int *dep_offsets;
+	int *dep_targets;
+
+	// Members of component i are members[member_offsets[i]] to
+	// members[member_offsets[i+1] - 1]. First member is the root
+	int *members;
+	int *member_offsets;
+
+	// Components of the level being solved
+	int *level_components;
+}SetComponents;
+
+typedef struct GrammarImageHeader{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	// Sizes of stored structs, as a layout check
+	uint32_t size_symbol_attr;
+	uint32_t size_compiled_rule;
+	uint64_t len_image;
+
+	int32_t len_variable_symbols;
+	int32_t len_terminal_symbols;
+	int32_t len_forget_terminal_symbols;
+	int32_t variable_symbols_min, variable_symbols_max;
+	int32_t terminal_symbols_min, terminal_symbols_max;
+	int32_t symbols_min, symbols_max;
+	int32_t start_symbol;
+	int32_t empty_symbol;
+	int32_t end_symbol;
+	int32_t len_compiled_rules;
+	int32_t len_expansion_pool;
+	int32_t len_set_words;
+	int32_t reserved;
+
+	// Byte offsets of sections from start of image, each 8 byte aligned
+	uint64_t variable_symbols_offset;
+	uint64_t terminal_symbols_offset;
+	uint64_t forget_terminal_symbols_offset;
+	uint64_t symbol_attr_table_offset;
+	uint64_t compiled_rules_offset;
+	uint64_t expansion_pool_offset;
+	uint64_t first_rows_offset;
+	uint64_t follow_rows_offset;
+	uint64_t dense_parse_table_offset;
+}GrammarImageHeader;
+
+typedef struct DocumentBatch{
+	ParserLL1_Document *documents;
+	// One parser for each thread
+	ParserLL1 **parsers;
+}DocumentBatch;
+
+typedef struct ChunkBatch{
+	Token **tkn_ptrs;
+	// Chunk i is made of tokens chunk_starts[i] to chunk_starts[i+1] - 1
+	int *chunk_starts;
+	int list_symbol;
+
+	// Parser of each chunk. The first parses from the start symbol and goes
+	// on to parse the whole document, others parse from list_symbol
+	ParserLL1 **parsers;
+	// Status of the first chunk, as returned by ParserLL1_parse_tokens
+	Parser_StepResult_type first_result;
+	int first_stop_index;
+	// Set for other chunks if all tokens parsed without errors and the
+	// chunk ended where the next list item starts
+	int *flag_chunk_valid;
+}ChunkBatch;
+
 typedef struct ErrorBuffer{
 	int lookahead_symbol;
 	int line, column;
+	// Position of the lookahead token in the input
+	int token_index;
 
-	char *value;
-	char *buffer;
+	// Value of lookahead token, with characters for \0 and truncation check
+	char buffer[PARSERLL1_LITERAL_MAX_CHAR + 2];
 	int len_buffer;
 
 	int top_symbol;
@@ -127,197 +233,496 @@ static int hash_function(void *key);
 
 static int key_compare(void *key1, void *key2);
 
-static void calculate_first_table(ParserLL1 *psr_ptr);
+static void calculate_nullable_set(ParserLL1_Grammar *grm_ptr);
 
-static void calculate_follow_table(ParserLL1 *psr_ptr);
+static void calculate_first_table(ParserLL1_Grammar *grm_ptr, int num_threads);
 
-static void populate_parse_table(ParserLL1 *psr_ptr);
+static void calculate_follow_table(ParserLL1_Grammar *grm_ptr, int num_threads);
 
-static ErrorBuffer *ErrorBuffer_new(ParserLL1 *psr_ptr, Token *tkn_ptr, int top_symbol);
+static int get_variable_index(ParserLL1_Grammar *grm_ptr, int symbol);
+
+static int get_terminal_index(ParserLL1_Grammar *grm_ptr, int symbol);
 
-static void ErrorBuffer_destroy(ErrorBuffer *err_ptr);
+static void add_set_dependency(SetDependencies *deps_ptr, int from_index, int to_index);
 
-static void add_error(ParserLL1 *psr_ptr, Token* tkn_ptr, int top_symbol);
+static void propagate_sets(uint64_t *sets, int len_set_words, int len_sets, SetDependencies *deps_ptr, WordSet_OrFunction or_words, int num_threads);
+
+static void solve_set_component_task(void *ctx, int thread_index, int task_index);
+
+static void populate_parse_table(ParserLL1_Grammar *grm_ptr, int num_threads);
+
+static void populate_parse_table_row_task(void *ctx, int thread_index, int task_index);
+
+static void compile_rules(ParserLL1_Grammar *grm_ptr);
+
+static int get_parse_table_entry(ParserLL1_Grammar *grm_ptr, int variable_symbol, int terminal_symbol);
+
+static inline int set_get_bit(uint64_t *set, int index);
+
+static inline void set_set_bit(uint64_t *set, int index);
+
+static int write_image(ParserLL1_Grammar *grm_ptr, FILE *file_ptr);
+
+static int write_image_section(FILE *file_ptr, uint64_t *offset_ptr, void *data, size_t len_data);
+
+static int check_image_section(const GrammarImageHeader *hdr_ptr, uint64_t offset, uint64_t len_elements, size_t size_element);
+
+static int check_grammar_tables(ParserLL1_Grammar *grm_ptr);
+
+static void write_symbol_name(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, int symbol);
+
+static void write_rule(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, CompiledRule *crl_ptr);
+
+static void write_step_symbol(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, const char *name);
+
+static void write_symbol_flags(FILE *file_ptr, int flags);
+
+static void write_entry_points(FILE *file_ptr, const char *name);
+
+static void write_int_array(FILE *file_ptr, const char *name, const char *suffix, const int *values, int len_values);
+
+static void write_word_array(FILE *file_ptr, const char *name, const char *suffix, const uint64_t *words, size_t len_words);
+
+static void write_table_field(FILE *file_ptr, const char *name, const char *field, int len_values);
+
+static int get_symbol_flags(ParserLL1_Grammar *grm_ptr, int symbol);
+
+static void calculate_symbol_ranges(ParserLL1_Grammar *grm_ptr);
+
+static int check_special_symbols(ParserLL1_Grammar *grm_ptr);
+
+static SymbolAttr *new_symbol_attr_table(ParserLL1_Grammar *grm_ptr);
+
+static ErrorBuffer *ErrorBuffer_new(ParserLL1 *psr_ptr, Token *tkn_ptr, int top_symbol);
+
+static int add_error(ParserLL1 *psr_ptr, Token* tkn_ptr, int top_symbol);
 
 static void print_error(ParserLL1 *psr_ptr, ErrorBuffer *err_ptr);
 
+static void get_grammar_memory_usage(ParserLL1_Grammar *grm_ptr, ParserLL1_MemoryUsage *usg_ptr);
+
+static size_t get_parse_memory_usage(ParserLL1 *psr_ptr, ParserLL1_MemoryUsage *usg_ptr);
+
+static int growth_exceeds_memory_limit(ParserLL1 *psr_ptr, size_t len_growth);
+
+static void build_sync_rows(ParserLL1_Grammar *grm_ptr);
+
+static inline int skip_recovery_input(ParserLL1 *psr_ptr, Token **tkn_ptrs, const ParserLL1_TokenRecord *records, int len_input);
+
+static uint64_t *get_recovery_row(ParserLL1 *psr_ptr);
+
+static int unwind_to_sync(ParserLL1 *psr_ptr, int lookahead_symbol, int lookahead_index);
+
+static void parse_document_task(void *ctx, int thread_index, int task_index);
+
+static void parse_chunk_task(void *ctx, int thread_index, int task_index);
+
+static void splice_chunk(ParserLL1 *psr_ptr, ParserLL1 *chunk_psr_ptr);
+
+static void arena_destroy(ParserLL1 *psr_ptr);
+
+static void arena_truncate(ParserLL1 *psr_ptr, NodeBlock *blk_ptr, int len_nodes);
+
+static void arena_free_old_parse(ParserLL1 *psr_ptr, RestoredLink *links, int len_links);
+
+static ParseTree_Node *arena_tree_to_parse_tree(ParserLL1_Node *root_node_ptr);
+
+static void init_parse_state(ParserLL1 *psr_ptr);
+
+static void clear_parse_state(ParserLL1 *psr_ptr);
+
+static inline Parser_StepResult_type step(ParserLL1 *psr_ptr, Token *tkn_ptr);
+
+static inline Parser_StepResult_type step_symbol(ParserLL1 *psr_ptr, int lookahead_symbol, Token *tkn_ptr);
+
+static void node_skip(ParserLL1 *psr_ptr, StackEntry *ent_ptr);
+
+static ParserLL1_FlatTree *flat_tree_new(int cap_nodes);
+
+static void flat_tree_add_event(ParserLL1_Event *evt_ptr, void *ctx);
+
+static void record_input_token(ParserLL1 *psr_ptr, Token *tkn_ptr);
+
+static void clear_input_records(ParserLL1 *psr_ptr);
+
+static int restore_parse_state(ParserLL1 *psr_ptr, int resume_index, int resume_len_stack, RestoredLink *links);
+
+static int adopt_old_parse(ParserLL1 *psr_ptr, ParserLL1_Node *old_leaf_node_ptr, int old_len_stack, RestoredLink *links, int len_links);
+
 ////////////////////////////////
 // Constructors & Destructors //
 ////////////////////////////////
 
 ParserLL1 *ParserLL1_new(int *variable_symbols, int len_variable_symbols, int *terminal_symbols, int len_terminal_symbols, int start_symbol, int empty_symbol, int end_symbol, int *forget_terminal_symbols, int len_forget_terminal_symbols, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){
+	ParserLL1_Grammar *grm_ptr = ParserLL1_Grammar_new(variable_symbols, len_variable_symbols, terminal_symbols, len_terminal_symbols, start_symbol, empty_symbol, end_symbol, forget_terminal_symbols, len_forget_terminal_symbols, token_to_symbol, symbol_to_string, token_to_value);
+	if(grm_ptr == NULL)
+		return NULL;
+
+	ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+	psr_ptr->flag_owns_grammar = 1;
+
+	return psr_ptr;
+}
+
+ParserLL1 *ParserLL1_new_session(ParserLL1_Grammar *grm_ptr){
 
 	// Allocate
 	ParserLL1 *psr_ptr = malloc( sizeof(ParserLL1) );
 
+	psr_ptr->grm_ptr = grm_ptr;
+	psr_ptr->flag_owns_grammar = 0;
 
-	// Copy parameters
-	psr_ptr->variable_symbols = variable_symbols;
-	psr_ptr->len_variable_symbols = len_variable_symbols;
-	psr_ptr->terminal_symbols = terminal_symbols;
-	psr_ptr->len_terminal_symbols = len_terminal_symbols;
-	psr_ptr->start_symbol = start_symbol;
-	psr_ptr->empty_symbol = empty_symbol;
-	psr_ptr->end_symbol = end_symbol;
-	psr_ptr->forget_terminal_symbols = forget_terminal_symbols;
-	psr_ptr->len_forget_terminal_symbols = len_forget_terminal_symbols;
-
-	psr_ptr->token_to_symbol = token_to_symbol;
-	psr_ptr->symbol_to_string = symbol_to_string;
-	psr_ptr->token_to_value = token_to_value;
-
-	// Set error flag to 0
-	psr_ptr->flag_errors_found = 0;
-	// If 1, can access parse tree
-	psr_ptr->flag_halted = 0;
-	// If 1, error recovery is active, avoid recording another error
-	psr_ptr->flag_error_recovery = 0;
 	// If 1, parsing errors printed immediately on being encountered
 	psr_ptr->flag_immediate_print_error = 0;
-	// If 0, parse tree wont be freed when parser is destoryed
-	psr_ptr->flag_free_parse_tree = 1;
+	psr_ptr->flag_borrowed_tokens = 0;
+
+	// Arena mode is off until enabled by user
+	psr_ptr->flag_arena_mode = 0;
+	psr_ptr->arena_block_size = PARSERLL1_DEFAULT_ARENA_BLOCK_SIZE;
+	psr_ptr->arena_block_list = NULL;
+	psr_ptr->len_arena_blocks = 0;
+	psr_ptr->arena_tree = NULL;
+	psr_ptr->arena_free_list = NULL;
+
+	// Event mode is off until enabled by user
+	psr_ptr->flag_event_mode = 0;
+	psr_ptr->event_callback = NULL;
+	psr_ptr->event_ctx = NULL;
+
+	// Flat mode is off until enabled by user
+	psr_ptr->flag_flat_mode = 0;
+	psr_ptr->flat_tree = NULL;
+	psr_ptr->cap_flat_nodes = 0;
+	psr_ptr->flat_open_nodes = NULL;
+	psr_ptr->len_flat_open_nodes = 0;
+	psr_ptr->cap_flat_open_nodes = 0;
+
+	// Incremental mode is off until enabled by user. Records are allocated on
+	// first token
+	psr_ptr->flag_incremental_mode = 0;
+	psr_ptr->input_records = NULL;
+	psr_ptr->len_input_records = 0;
+	psr_ptr->cap_input_records = 0;
+	psr_ptr->end_token_index = -1;
+
+	// Token source buffer is allocated on first run
+	psr_ptr->run_buffer = NULL;
+	psr_ptr->len_run_buffer = 0;
+	psr_ptr->pos_run_buffer = 0;
+
+	psr_ptr->record_ptr = NULL;
+	psr_ptr->record_source = NULL;
 
-	// Calc minimum and maximum
-	psr_ptr->variable_symbols_min = INT_MAX;
-	psr_ptr->variable_symbols_max = INT_MIN;
-	psr_ptr->terminal_symbols_min = INT_MAX;
-	psr_ptr->terminal_symbols_max = INT_MIN;
+	// Create stack
+	psr_ptr->len_stack = 0;
+	psr_ptr->cap_stack = PARSERLL1_INITIAL_STACK_SIZE;
+	psr_ptr->stack = malloc( sizeof(StackEntry) * psr_ptr->cap_stack );
+
+	// Error records are allocated on first error, or when a limit is set
+	psr_ptr->errors = NULL;
+	psr_ptr->num_errors = 0;
+	psr_ptr->cap_errors = 0;
+	psr_ptr->max_errors = 0;
+	psr_ptr->flag_stop_at_max_errors = 0;
+	psr_ptr->flag_errors_dropped = 0;
+
+	// Recovery only looks at top of the stack until sync recovery is enabled
+	psr_ptr->flag_sync_recovery = 0;
+	psr_ptr->sync_terminal_row = NULL;
+	psr_ptr->recovery_rows = NULL;
+	psr_ptr->len_recovery_rows = 0;
+	psr_ptr->cap_recovery_rows = 0;
+
+	// No resource limits until set by user
+	psr_ptr->max_tree_nodes = 0;
+	psr_ptr->max_stack_depth = 0;
+	psr_ptr->max_memory = 0;
+	psr_ptr->flag_limits = 0;
+
+	// One expansion counter for each rule
+	psr_ptr->stats.rule_expansions = NULL;
+	psr_ptr->stats.len_rule_expansions = 0;
+#ifdef PARSERLL1_STATS
+	psr_ptr->stats.len_rule_expansions = grm_ptr->len_compiled_rules;
+	psr_ptr->stats.rule_expansions = calloc( grm_ptr->len_compiled_rules > 0 ? grm_ptr->len_compiled_rules : 1, sizeof(long long) );
+#endif
+
+	// Create Parse Tree. This is freed when parser is destroyed or reset
+	// Add end symbol and starting symbol to tree and stack
+	init_parse_state(psr_ptr);
 
-	for (int i = 0; i < len_variable_symbols; ++i){
-		if(variable_symbols[i] < psr_ptr->variable_symbols_min)
-			psr_ptr->variable_symbols_min = variable_symbols[i];
-		if(variable_symbols[i] > psr_ptr->variable_symbols_max)
-			psr_ptr->variable_symbols_max = variable_symbols[i];
-	}
 
-	for (int i = 0; i < len_terminal_symbols; ++i){
-		if(terminal_symbols[i] < psr_ptr->terminal_symbols_min)
-			psr_ptr->terminal_symbols_min = terminal_symbols[i];
-		if(terminal_symbols[i] > psr_ptr->terminal_symbols_max)
-			psr_ptr->terminal_symbols_max = terminal_symbols[i];
-	}
+	return psr_ptr;
+}
 
-	if(psr_ptr->terminal_symbols_min < psr_ptr->variable_symbols_min)
-		psr_ptr->symbols_min = psr_ptr->terminal_symbols_min;
-	else
-		psr_ptr->symbols_min = psr_ptr->variable_symbols_min;
+ParserLL1_Grammar *ParserLL1_Grammar_new(int *variable_symbols, int len_variable_symbols, int *terminal_symbols, int len_terminal_symbols, int start_symbol, int empty_symbol, int end_symbol, int *forget_terminal_symbols, int len_forget_terminal_symbols, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){
 
-	if(psr_ptr->terminal_symbols_max > psr_ptr->variable_symbols_max)
-		psr_ptr->symbols_max = psr_ptr->terminal_symbols_max;
-	else
-		psr_ptr->symbols_max = psr_ptr->variable_symbols_max;
+	// Allocate
+	ParserLL1_Grammar *grm_ptr = malloc( sizeof(ParserLL1_Grammar) );
 
-	// Create and Initialize symbol class set
-	psr_ptr->symbol_class_set = BitSet_new(psr_ptr->symbols_min, psr_ptr->symbols_max);
-	for (int i = 0; i < len_terminal_symbols; ++i)
-		BitSet_set_bit(psr_ptr->symbol_class_set, psr_ptr->terminal_symbols[i]);
 
-	// Create and initialize forget terminal symbol set
-	psr_ptr->forget_terminal_symbol_set = BitSet_new(psr_ptr->terminal_symbols_min, psr_ptr->terminal_symbols_max);
-	for (int i = 0; i < len_forget_terminal_symbols; ++i)
-		BitSet_set_bit(psr_ptr->forget_terminal_symbol_set, psr_ptr->forget_terminal_symbols[i]);
+	// Copy parameters
+	grm_ptr->variable_symbols = variable_symbols;
+	grm_ptr->len_variable_symbols = len_variable_symbols;
+	grm_ptr->terminal_symbols = terminal_symbols;
+	grm_ptr->len_terminal_symbols = len_terminal_symbols;
+	grm_ptr->start_symbol = start_symbol;
+	grm_ptr->empty_symbol = empty_symbol;
+	grm_ptr->end_symbol = end_symbol;
+	grm_ptr->forget_terminal_symbols = forget_terminal_symbols;
+	grm_ptr->len_forget_terminal_symbols = len_forget_terminal_symbols;
+
+	grm_ptr->token_to_symbol = token_to_symbol;
+	grm_ptr->symbol_to_string = symbol_to_string;
+	grm_ptr->token_to_value = token_to_value;
+
+	// Rules can be added until initialized
+	grm_ptr->flag_rules_initialized = 0;
+
+	grm_ptr->or_words = WordSet_get_or();
+
+	// Special symbols index the symbol attribute table, so they must lie
+	// within the range of listed symbols
+	calculate_symbol_ranges(grm_ptr);
+	if( check_special_symbols(grm_ptr) != 0 ){
+		free(grm_ptr);
+		return NULL;
+	}
+
+	// Nullable flags are set when rules are initialized
+	grm_ptr->symbol_attr_table = new_symbol_attr_table(grm_ptr);
 
 	// Create rule table
-	psr_ptr->rule_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
+	grm_ptr->rule_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
 
-	// Create nullable set
-	psr_ptr->nullable_set = BitSet_new(psr_ptr->variable_symbols_min, psr_ptr->variable_symbols_max);
+	// Create rule list
+	grm_ptr->len_rule_list = 0;
+	grm_ptr->cap_rule_list = len_variable_symbols > 0 ? len_variable_symbols : 1;
+	grm_ptr->rule_list = malloc( sizeof(Rule *) * grm_ptr->cap_rule_list );
 
-	// Create first and follow set table
-	psr_ptr->first_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
-	psr_ptr->follow_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
+	// Create nullable set
+	grm_ptr->nullable_set = calloc( len_variable_symbols > 0 ? (len_variable_symbols + 63) / 64 : 1, sizeof(uint64_t) );
 
-	// Create first and follow set for each table entry
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		HashTable_add(psr_ptr->first_table, &(psr_ptr->variable_symbols[i]), (void*) BitSet_new(psr_ptr->terminal_symbols_min, psr_ptr->terminal_symbols_max) );
-		HashTable_add(psr_ptr->follow_table, &(psr_ptr->variable_symbols[i]), (void*) BitSet_new(psr_ptr->terminal_symbols_min, psr_ptr->terminal_symbols_max) );
-	}
+	// Create first and follow set for each variable
+	grm_ptr->len_set_words = (len_terminal_symbols + 63) / 64;
+	int len_set_table_words = len_variable_symbols * grm_ptr->len_set_words;
+	grm_ptr->first_rows = calloc( len_set_table_words > 0 ? len_set_table_words : 1, sizeof(uint64_t) );
+	grm_ptr->follow_rows = calloc( len_set_table_words > 0 ? len_set_table_words : 1, sizeof(uint64_t) );
 
 	// Create parse table
-	psr_ptr->parse_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
+	grm_ptr->parse_table = HashTable_new(len_variable_symbols, hash_function, key_compare);
 
 	// Create row entry table for each variable symbol
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		HashTable_add(psr_ptr->parse_table, &(psr_ptr->variable_symbols[i]), HashTable_new(psr_ptr->len_terminal_symbols, hash_function, key_compare));
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		HashTable_add(grm_ptr->parse_table, &(grm_ptr->variable_symbols[i]), HashTable_new(grm_ptr->len_terminal_symbols, hash_function, key_compare));
 	}
 
-	// Create stack
-	psr_ptr->stack = LinkedList_new();
+	// Dense parse table and sync rows are allocated when rules are
+	// initialized
+	grm_ptr->dense_parse_table = NULL;
+	grm_ptr->sync_rows = NULL;
 
-	// Create Parse Tree. This is freed when parser is destroyed
-	// Add end symbol and starting symbol to tree and stack
-	psr_ptr->tree = ParseTree_Node_new(psr_ptr->start_symbol, NULL);
-	LinkedList_push(psr_ptr->stack, ParseTree_Node_new(psr_ptr->end_symbol, NULL) );
-	LinkedList_push(psr_ptr->stack, psr_ptr->tree);
+	// Compiled when rules are initialized
+	grm_ptr->compiled_rules = NULL;
+	grm_ptr->len_compiled_rules = 0;
+	grm_ptr->expansion_pool = NULL;
+	grm_ptr->len_expansion_pool = 0;
 
-	// Create error buffer list
-	psr_ptr->error_list = LinkedList_new();
+	// Not loaded from image or generated tables
+	grm_ptr->image_ptr = NULL;
+	grm_ptr->len_image = 0;
+	grm_ptr->flag_image_mapped = 0;
+	grm_ptr->tables_ptr = NULL;
 
-	return psr_ptr;
+	return grm_ptr;
 }
 
 void ParserLL1_destroy(ParserLL1 *psr_ptr){
-	// Free symbol class set
-	BitSet_destroy(psr_ptr->symbol_class_set);
+	// Free tree, arena and errors of current parse
+	clear_parse_state(psr_ptr);
+
+	// Free stack
+	free(psr_ptr->stack);
+
+	// Free token source buffer. Tokens already destroyed
+	free(psr_ptr->run_buffer);
+
+	// Free input records. Tokens already destroyed
+	free(psr_ptr->input_records);
+
+	// Free open flat tree nodes. Tree already freed
+	free(psr_ptr->flat_open_nodes);
+
+	// Free error records
+	free(psr_ptr->errors);
+
+	// Free sync recovery rows
+	free(psr_ptr->sync_terminal_row);
+	free(psr_ptr->recovery_rows);
+
+	// Free rule expansion counts
+	free(psr_ptr->stats.rule_expansions);
+
+	// Free grammar if not shared
+	if(psr_ptr->flag_owns_grammar == 1)
+		ParserLL1_Grammar_destroy(psr_ptr->grm_ptr);
 
-	// Free forget terminal symbol set
-	BitSet_destroy(psr_ptr->forget_terminal_symbol_set);
+	// Free parser
+	free(psr_ptr);
+}
+
+void ParserLL1_Grammar_destroy(ParserLL1_Grammar *grm_ptr){
+	if(grm_ptr->image_ptr != NULL || grm_ptr->tables_ptr != NULL){
+		// All tables are in image or user constants, except sync rows, and
+		// tables built from generated tables
+		if(grm_ptr->flag_image_mapped)
+			munmap(grm_ptr->image_ptr, grm_ptr->len_image);
+		if(grm_ptr->tables_ptr != NULL){
+			free(grm_ptr->symbol_attr_table);
+			free(grm_ptr->compiled_rules);
+		}
+		free(grm_ptr->sync_rows);
+		free(grm_ptr);
+		return;
+	}
+
+	// Free symbol attribute table
+	free(grm_ptr->symbol_attr_table);
 
 	// Free rule_table and rules
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		Rule *rul_ptr = HashTable_get( psr_ptr->rule_table, (void*) &(psr_ptr->variable_symbols[i]) );
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		Rule *rul_ptr = HashTable_get( grm_ptr->rule_table, (void*) &(grm_ptr->variable_symbols[i]) );
 		while(rul_ptr != NULL){
 			Rule *next_rul_ptr = rul_ptr->next;
 			Rule_destroy(rul_ptr);
 			rul_ptr = next_rul_ptr;
 		}
 	}
-	HashTable_destroy(psr_ptr->rule_table);
-
-	// Free nullable set
-	BitSet_destroy(psr_ptr->nullable_set);
+	HashTable_destroy(grm_ptr->rule_table);
 
-	// Free first and follow set for each table entry
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		BitSet_destroy( (BitSet*) HashTable_get(psr_ptr->first_table, (void*) &(psr_ptr->variable_symbols[i]) ) );
-		BitSet_destroy( (BitSet*) HashTable_get(psr_ptr->follow_table, (void*) &(psr_ptr->variable_symbols[i]) ) );
-	}
+	// Free rule list. Rules already freed
+	free(grm_ptr->rule_list);
 
-	// Free first and follow set table
-	HashTable_destroy(psr_ptr->first_table);
-	HashTable_destroy(psr_ptr->follow_table);
+	// Free nullable set
+	free(grm_ptr->nullable_set);
 
 
 	// Free row entry table for each variable symbol
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		HashTable_destroy( HashTable_get( psr_ptr->parse_table, &(psr_ptr->variable_symbols[i]) ) );
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		HashTable_destroy( HashTable_get( grm_ptr->parse_table, &(grm_ptr->variable_symbols[i]) ) );
 	}
 
 	// Free parse table
-	HashTable_destroy(psr_ptr->parse_table);
+	HashTable_destroy(grm_ptr->parse_table);
+
+	// Free dense parse table
+	free(grm_ptr->dense_parse_table);
+
+	// Free compiled rules and sets
+	free(grm_ptr->compiled_rules);
+	free(grm_ptr->expansion_pool);
+	free(grm_ptr->first_rows);
+	free(grm_ptr->follow_rows);
+	free(grm_ptr->sync_rows);
+
+	// Free grammar
+	free(grm_ptr);
+}
+
+static void init_parse_state(ParserLL1 *psr_ptr){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
 
-	// Check if end symbol exists at the end of stack, free it
-	if(LinkedList_peekback(psr_ptr->stack) != NULL){
-		ParseTree_Node_destroy(LinkedList_peekback(psr_ptr->stack));
+	// Set error flag to 0
+	psr_ptr->flag_errors_found = 0;
+	// If 1, can access parse tree
+	psr_ptr->flag_halted = 0;
+	// If 1, error recovery is active, avoid recording another error
+	psr_ptr->flag_error_recovery = 0;
+	// If 0, parse tree wont be freed when parser is destoryed
+	psr_ptr->flag_free_parse_tree = 1;
+
+	psr_ptr->num_tokens = 0;
+	psr_ptr->num_errors = 0;
+	psr_ptr->flag_errors_dropped = 0;
+
+	// Clear statistics, keeping rule expansion counts allocated
+	long long *rule_expansions = psr_ptr->stats.rule_expansions;
+	int len_rule_expansions = psr_ptr->stats.len_rule_expansions;
+	memset(&(psr_ptr->stats), 0, sizeof(ParserLL1_Stats));
+	psr_ptr->stats.rule_expansions = rule_expansions;
+	psr_ptr->stats.len_rule_expansions = len_rule_expansions;
+	if(rule_expansions != NULL)
+		memset(rule_expansions, 0, sizeof(long long) * len_rule_expansions);
+
+	// Add end symbol and starting symbol to tree and stack
+	psr_ptr->len_stack = 0;
+	psr_ptr->peak_stack_depth = 0;
+	stack_push(psr_ptr, grm_ptr->end_symbol, -1, NULL);
+	psr_ptr->num_tree_nodes = 1;
+
+	if(psr_ptr->flag_event_mode == 1){
+		// No tree is built, except from events in flat mode
+		stack_push(psr_ptr, grm_ptr->start_symbol, -1, NULL);
+
+		if(psr_ptr->flag_flat_mode == 1){
+			psr_ptr->flat_tree = flat_tree_new(psr_ptr->cap_flat_nodes);
+			psr_ptr->len_flat_open_nodes = 0;
+		}
+	}
+	else if(psr_ptr->flag_arena_mode == 0){
+		psr_ptr->tree = ParseTree_Node_new(grm_ptr->start_symbol, NULL);
+		stack_push(psr_ptr, grm_ptr->start_symbol, -1, psr_ptr->tree);
+		STATS_ADD(psr_ptr, nodes_allocated, 1);
+	}
+	else{
+		psr_ptr->arena_tree = arena_node_new(psr_ptr, grm_ptr->start_symbol, NULL);
+		stack_push(psr_ptr, grm_ptr->start_symbol, -1, psr_ptr->arena_tree);
+		STATS_ADD(psr_ptr, nodes_allocated, 1);
 	}
+}
 
-	// Free stack
-	LinkedList_destroy(psr_ptr->stack);
+static void clear_parse_state(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_event_mode == 1){
+		// No tree to free, unless flat tree was not taken by user
+		ParserLL1_FlatTree_destroy(psr_ptr->flat_tree);
+		psr_ptr->flat_tree = NULL;
+	}
 
-	// Free parse tree
-	if(psr_ptr->flag_free_parse_tree == 1)
-		ParseTree_Node_destroy(psr_ptr->tree);
+	else if(psr_ptr->flag_arena_mode == 0){
+		// Free parse tree
+		if(psr_ptr->flag_free_parse_tree == 1)
+			ParseTree_Node_destroy(psr_ptr->tree);
+		psr_ptr->tree = NULL;
+	}
 
-	// Free all buffers in error buffer list
-	while( LinkedList_peek(psr_ptr->error_list) != NULL ){
-		ErrorBuffer_destroy( LinkedList_pop(psr_ptr->error_list) );
+	else{
+		// All nodes are in arena. A copy taken by ParserLL1_get_parse_tree
+		// belongs to the user
+		arena_destroy(psr_ptr);
+		psr_ptr->arena_tree = NULL;
+		psr_ptr->tree = NULL;
 	}
 
-	// Free error buffer list
-	LinkedList_destroy(psr_ptr->error_list);
+	// Error records are kept for the next parse
+	psr_ptr->num_errors = 0;
 
-	// Free parser
-	free(psr_ptr);
+	// Free tokens kept for incremental parsing
+	clear_input_records(psr_ptr);
+
+	// Free tokens pulled but not processed
+	for (int i = psr_ptr->pos_run_buffer; i < psr_ptr->len_run_buffer; ++i)
+		Token_destroy(psr_ptr->run_buffer[i]);
+	psr_ptr->len_run_buffer = 0;
+	psr_ptr->pos_run_buffer = 0;
+}
+
+void ParserLL1_reset(ParserLL1 *psr_ptr){
+	clear_parse_state(psr_ptr);
+	init_parse_state(psr_ptr);
+}
+
+ParserLL1_Grammar *ParserLL1_get_grammar(ParserLL1 *psr_ptr){
+	return psr_ptr->grm_ptr;
 }
 
 static Rule *Rule_new(int rule_num, int variable_symbol, int *expansion_symbols, int len_expansion_symbols){
@@ -339,25 +744,53 @@ static void Rule_destroy(Rule *rul_ptr){
 }
 
 static ErrorBuffer *ErrorBuffer_new(ParserLL1 *psr_ptr, Token *tkn_ptr, int top_symbol){
-	ErrorBuffer *err_ptr = malloc( sizeof(ErrorBuffer) );
-	err_ptr->lookahead_symbol = psr_ptr->token_to_symbol(tkn_ptr);
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
+	if(psr_ptr->max_errors > 0 && psr_ptr->num_errors >= psr_ptr->max_errors){
+		// Limit reached, error is not recorded
+		psr_ptr->flag_errors_dropped = 1;
+		return NULL;
+	}
+
+	if(psr_ptr->num_errors == psr_ptr->cap_errors){
+		// Full, double capacity
+		psr_ptr->cap_errors = psr_ptr->cap_errors > 0 ? psr_ptr->cap_errors * 2 : PARSERLL1_INITIAL_ERRORS_SIZE;
+		psr_ptr->errors = realloc( psr_ptr->errors, sizeof(ErrorBuffer) * psr_ptr->cap_errors );
+	}
 
-	err_ptr->line = tkn_ptr->line;
-	err_ptr->column = tkn_ptr->column;
+	// Records are reused across parses
+	ErrorBuffer *err_ptr = &(psr_ptr->errors[psr_ptr->num_errors++]);
+	// Lookahead is the latest token
+	err_ptr->token_index = psr_ptr->num_tokens - 1;
 
-	// Get value of token if it exists
-	// Add characters for \0 and truncation check
 	err_ptr->len_buffer = PARSERLL1_LITERAL_MAX_CHAR + 2;
-	err_ptr->buffer = malloc( sizeof(char) * err_ptr->len_buffer );
 	memset(err_ptr->buffer, '\0', err_ptr->len_buffer);
-	psr_ptr->token_to_value(tkn_ptr, err_ptr->buffer, err_ptr->len_buffer);
+
+	if(tkn_ptr != NULL){
+		err_ptr->lookahead_symbol = grm_ptr->token_to_symbol(tkn_ptr);
+		err_ptr->line = tkn_ptr->line;
+		err_ptr->column = tkn_ptr->column;
+
+		// Get value of token if it exists
+		grm_ptr->token_to_value(tkn_ptr, err_ptr->buffer, err_ptr->len_buffer);
+	}
+	else{
+		// Input given as records
+		const ParserLL1_TokenRecord *rec_ptr = psr_ptr->record_ptr;
+		err_ptr->lookahead_symbol = rec_ptr->symbol;
+		err_ptr->line = rec_ptr->line;
+		err_ptr->column = rec_ptr->column;
+
+		if(psr_ptr->record_source != NULL && rec_ptr->length > 0){
+			// Copy one character past the limit, so truncation is detected
+			int len_value = rec_ptr->length < err_ptr->len_buffer - 1 ? rec_ptr->length : err_ptr->len_buffer - 1;
+			memcpy(err_ptr->buffer, psr_ptr->record_source + rec_ptr->offset, len_value);
+		}
+	}
 
 	err_ptr->top_symbol = top_symbol;
-}
 
-static void ErrorBuffer_destroy(ErrorBuffer *err_ptr){
-	free(err_ptr->buffer);
-	free(err_ptr);
+	return err_ptr;
 }
 
 
@@ -367,531 +800,3084 @@ static void ErrorBuffer_destroy(ErrorBuffer *err_ptr){
 //////////////////////
 
 void ParserLL1_add_rule(ParserLL1 *psr_ptr, int rule_num, int variable_symbol, int *expansion_symbols, int len_expansion_symbols){
+	ParserLL1_Grammar_add_rule(psr_ptr->grm_ptr, rule_num, variable_symbol, expansion_symbols, len_expansion_symbols);
+}
+
+void ParserLL1_Grammar_add_rule(ParserLL1_Grammar *grm_ptr, int rule_num, int variable_symbol, int *expansion_symbols, int len_expansion_symbols){
+	// Grammar is read only once initialized
+	if(grm_ptr->flag_rules_initialized == 1)
+		return;
+
 	Rule *new_rul_ptr = Rule_new(rule_num, variable_symbol, expansion_symbols, len_expansion_symbols);
-	Rule *prev_rul_ptr = HashTable_get(psr_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol) );
+
+	// Append to rule list, growing it if full
+	if(grm_ptr->len_rule_list == grm_ptr->cap_rule_list){
+		grm_ptr->cap_rule_list *= 2;
+		grm_ptr->rule_list = realloc( grm_ptr->rule_list, sizeof(Rule *) * grm_ptr->cap_rule_list );
+	}
+	new_rul_ptr->rule_index = grm_ptr->len_rule_list;
+	grm_ptr->rule_list[grm_ptr->len_rule_list++] = new_rul_ptr;
+
+	Rule *prev_rul_ptr = HashTable_get(grm_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol) );
 
 	if(prev_rul_ptr == NULL){
 		// Need to add rule, no rule with same lhs exists. Use the key which
 		// exists within the rule, as it will exist outside this function's
 		// scope
 		new_rul_ptr->next = NULL;
-		HashTable_add(psr_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol), (void*) new_rul_ptr);
+		HashTable_add(grm_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol), (void*) new_rul_ptr);
 	}
 
 	else{
 		// Need to add rule to already existing rule list
 		new_rul_ptr->next = prev_rul_ptr;
-		HashTable_set(psr_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol), (void*) new_rul_ptr);
+		HashTable_set(grm_ptr->rule_table, (void*) &(new_rul_ptr->variable_symbol), (void*) new_rul_ptr);
 	}
 }
 
-static void calculate_first_table(ParserLL1 *psr_ptr){
-
-	// Add empty symbol to nullable set
-	BitSet_set_bit(psr_ptr->nullable_set, psr_ptr->empty_symbol);
-
-	int flag_change = 1;
-	while(flag_change){
-		flag_change = 0;
+static void calculate_nullable_set(ParserLL1_Grammar *grm_ptr){
+	int len_rules = grm_ptr->len_rule_list;
+	int len_variables = grm_ptr->len_variable_symbols;
 
-		for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-			// For each variable symbol
-			int variable_symbol = psr_ptr->variable_symbols[i];
-			// Will be set to 1 if variable symbol is nullable, else 0
-			int flag_nullable;
+	// Number of expansion symbols of each rule not yet known to be nullable,
+	// -1 if rule can never be nullable
+	int *len_remaining = malloc( sizeof(int) * (len_rules > 0 ? len_rules : 1) );
+	// Rules each variable appears in, once per appearance
+	int *occurrence_offsets = calloc(len_variables + 1, sizeof(int));
 
-			// No rules expand empty symbol
-			if(variable_symbol == psr_ptr->empty_symbol)
-				continue;
-
-
-			BitSet *var_first_set_ptr = HashTable_get(psr_ptr->first_table, (void*) &variable_symbol);
-			Rule *rul_ptr = HashTable_get(psr_ptr->rule_table, (void*) &variable_symbol );
-
-			while(rul_ptr != NULL){
-				// For each expansion of the variable symbol
+	for (int i = 0; i < len_rules; ++i){
+		Rule *rul_ptr = grm_ptr->rule_list[i];
+		len_remaining[i] = rul_ptr->len_expansion_symbols;
 
-				for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j){
-					// For each symbol in expansion
-					int expansion_symbol = rul_ptr->expansion_symbols[j];
+		// No rules expand empty symbol
+		if( get_variable_index(grm_ptr, rul_ptr->variable_symbol) == -1 || rul_ptr->variable_symbol == grm_ptr->empty_symbol ){
+			len_remaining[i] = -1;
+			continue;
+		}
 
-					if( BitSet_get_bit(psr_ptr->symbol_class_set, expansion_symbol) == 1 ){
-						// Symbol is terminal
+		for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j){
+			if( get_variable_index(grm_ptr, rul_ptr->expansion_symbols[j]) == -1 ){
+				// Terminal symbol, rule cannot be nullable
+				len_remaining[i] = -1;
+				break;
+			}
+		}
 
-						if( BitSet_get_bit(var_first_set_ptr, expansion_symbol) == 0 ){
-							// Not in first set, add
-							BitSet_set_bit(var_first_set_ptr, expansion_symbol);
-							flag_change = 1;
-						}
+		if(len_remaining[i] == -1)
+			continue;
+		for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j)
+			occurrence_offsets[ get_variable_index(grm_ptr, rul_ptr->expansion_symbols[j]) + 1 ]++;
+	}
 
-						// This rule cannot be nullable, as it has a terminal symbol
-						flag_nullable = 0;
+	for (int i = 0; i < len_variables; ++i)
+		occurrence_offsets[i + 1] += occurrence_offsets[i];
 
-						// No need to look at further symbols
-						break;
-					}
+	int *occurrences = malloc( sizeof(int) * (occurrence_offsets[len_variables] > 0 ? occurrence_offsets[len_variables] : 1) );
+	int *occurrence_ends = malloc( sizeof(int) * (len_variables > 0 ? len_variables : 1) );
+	memcpy(occurrence_ends, occurrence_offsets, sizeof(int) * len_variables);
 
-					else{
-						// Symbol is not a terminal
+	for (int i = 0; i < len_rules; ++i){
+		if(len_remaining[i] == -1)
+			continue;
 
-						// Get first set of expansion symbol
-						BitSet *exp_first_set_ptr = HashTable_get(psr_ptr->first_table, (void*) &expansion_symbol);
-						// Temporary set to find changes
-						BitSet *tmp_set_ptr = BitSet_clone(exp_first_set_ptr);
-						BitSet_subtract(tmp_set_ptr, var_first_set_ptr);
+		Rule *rul_ptr = grm_ptr->rule_list[i];
+		for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j)
+			occurrences[ occurrence_ends[ get_variable_index(grm_ptr, rul_ptr->expansion_symbols[j]) ]++ ] = i;
+	}
 
-						if(BitSet_get_any(tmp_set_ptr) == 1){
-							// New terminals exist to be added to first set
-							BitSet_or(var_first_set_ptr, exp_first_set_ptr);
-							flag_change = 1;
-						}
+	// Each variable enters worklist once, when found to be nullable
+	int *worklist = malloc( sizeof(int) * (len_variables > 0 ? len_variables : 1) );
+	int len_worklist = 0;
 
-						BitSet_destroy(tmp_set_ptr);
+	// Add empty symbol to nullable set
+	int empty_index = get_variable_index(grm_ptr, grm_ptr->empty_symbol);
+	set_set_bit(grm_ptr->nullable_set, empty_index);
+	worklist[len_worklist++] = empty_index;
 
-						if( BitSet_get_bit(psr_ptr->nullable_set, expansion_symbol) == 0 ){
-							// expansion symbol not nullable
-							flag_nullable = 0;
-							// No need to look further
-							break;
-						}
-						else{
-							// Chance that this rule may be nullable. Check further 
-							flag_nullable = 1;
-							continue;
-						}
-					}
+	for (int i = 0; i < len_rules; ++i){
+		int variable_index = get_variable_index(grm_ptr, grm_ptr->rule_list[i]->variable_symbol);
 
-				}
+		if( len_remaining[i] == 0 && set_get_bit(grm_ptr->nullable_set, variable_index) == 0 ){
+			// Rule has no expansion symbols
+			set_set_bit(grm_ptr->nullable_set, variable_index);
+			worklist[len_worklist++] = variable_index;
+		}
+	}
 
-				if(flag_nullable == 1){
-					// The variable symbol is nullable
+	while(len_worklist > 0){
+		int variable_index = worklist[--len_worklist];
 
-					if( BitSet_get_bit(psr_ptr->nullable_set, variable_symbol) == 0 ){
-						// Not yet added to nullable set
-						BitSet_set_bit(psr_ptr->nullable_set, variable_symbol);
-						flag_change = 1;
-					}
-				}
+		for (int i = occurrence_offsets[variable_index]; i < occurrence_offsets[variable_index + 1]; ++i){
+			int rule_index = occurrences[i];
+			int rule_variable_index = get_variable_index(grm_ptr, grm_ptr->rule_list[rule_index]->variable_symbol);
 
-				rul_ptr = rul_ptr->next;
+			if( --len_remaining[rule_index] == 0 && set_get_bit(grm_ptr->nullable_set, rule_variable_index) == 0 ){
+				// All expansion symbols nullable
+				set_set_bit(grm_ptr->nullable_set, rule_variable_index);
+				worklist[len_worklist++] = rule_variable_index;
 			}
 		}
 	}
-}
 
-static void calculate_follow_table(ParserLL1 *psr_ptr){
-	// TODO add end of input to follow set of start symbol
-	BitSet *start_follow_set_ptr = HashTable_get(psr_ptr->follow_table, (void*) &(psr_ptr->start_symbol) );
-	BitSet_set_bit(start_follow_set_ptr, psr_ptr->end_symbol);
-
-	int flag_change = 1;
-	while(flag_change){
-		flag_change = 0;
-
-		for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-			// For each variable symbol
-			int variable_symbol = psr_ptr->variable_symbols[i];
-
-			// Get follow set of lhs
-			BitSet *var_follow_set_ptr = HashTable_get(psr_ptr->follow_table, (void*) &variable_symbol);
-
-
-			Rule *rul_ptr = HashTable_get(psr_ptr->rule_table, (void*) &variable_symbol );
-
-			while(rul_ptr != NULL){
-				// For each expansion of the variable symbol
-
-				// Flag to check if follow of lhs shoulf be included in the
-				// expansion symbol. Initialized to 1, as the last expansion symbol, if
-				// it is a non terminal, which will be iterated first,
-				// necessarily contains follow of lhs.
-				int flag_nullable = 1;
-
-				// Iterate in reverse, quicker in case of nullable expansion
-				// symbols
-				for (int j = rul_ptr->len_expansion_symbols - 1; j >= 0; --j){
-					// For each symbol in expansion
-					int expansion_symbol = rul_ptr->expansion_symbols[j];
+	free(len_remaining);
+	free(occurrence_offsets);
+	free(occurrences);
+	free(occurrence_ends);
+	free(worklist);
+}
 
-					// No follow set of empty symbol
-					if(expansion_symbol == psr_ptr->empty_symbol)
-						continue;
+static void calculate_first_table(ParserLL1_Grammar *grm_ptr, int num_threads){
+	calculate_nullable_set(grm_ptr);
 
-					if( BitSet_get_bit(psr_ptr->symbol_class_set, expansion_symbol) == 0 ){
-						// Symbol is not terminal
+	int len_set_words = grm_ptr->len_set_words;
+	SetDependencies deps = {NULL, NULL, 0, 0};
 
-						// Get follow set of expansion symbol
-						BitSet *exp_follow_set_ptr = HashTable_get(psr_ptr->follow_table, (void*) &expansion_symbol);
+	for (int i = 0; i < grm_ptr->len_rule_list; ++i){
+		Rule *rul_ptr = grm_ptr->rule_list[i];
+		int variable_index = get_variable_index(grm_ptr, rul_ptr->variable_symbol);
 
-						if(flag_nullable == 1){
-							// Add follow of lhs
+		// No rules expand empty symbol
+		if(variable_index == -1 || rul_ptr->variable_symbol == grm_ptr->empty_symbol)
+			continue;
 
-							// Temporary set to find changes
-							BitSet *tmp_set_ptr = BitSet_clone(var_follow_set_ptr);
-							BitSet_subtract(tmp_set_ptr, exp_follow_set_ptr);
+		for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j){
+			// For each symbol in expansion, up to the first not nullable
+			int expansion_symbol = rul_ptr->expansion_symbols[j];
+			int expansion_index = get_variable_index(grm_ptr, expansion_symbol);
 
+			if(expansion_index == -1){
+				// Symbol is terminal
+				int terminal_index = get_terminal_index(grm_ptr, expansion_symbol);
+				if(terminal_index != -1)
+					set_set_bit(grm_ptr->first_rows + variable_index * len_set_words, terminal_index);
+				break;
+			}
 
-							if(BitSet_get_any(tmp_set_ptr) == 1){
-								// New terminals exist to be added to follow set
+			// First set of variable includes first set of expansion symbol
+			add_set_dependency(&deps, variable_index, expansion_index);
 
-								BitSet_or(exp_follow_set_ptr, var_follow_set_ptr);
-								flag_change = 1;
-							}
+			if( set_get_bit(grm_ptr->nullable_set, expansion_index) == 0 )
+				break;
+		}
+	}
 
-							BitSet_destroy(tmp_set_ptr);
-						}
+	propagate_sets(grm_ptr->first_rows, len_set_words, grm_ptr->len_variable_symbols, &deps, grm_ptr->or_words, num_threads);
 
-						if( BitSet_get_bit(psr_ptr->nullable_set, expansion_symbol) == 0 ){
-							// expansion is no longer nullable
-							flag_nullable = 0;
-						}
+	free(deps.from_indices);
+	free(deps.to_indices);
+}
 
+static void calculate_follow_table(ParserLL1_Grammar *grm_ptr, int num_threads){
+	uint64_t *follow_rows = grm_ptr->follow_rows;
+	int len_set_words = grm_ptr->len_set_words;
+	SetDependencies deps = {NULL, NULL, 0, 0};
 
-						if(j < rul_ptr->len_expansion_symbols - 1){
-							// Symbol is not the last in rule, can add first set of next symbol
-							int next_expansion_symbol = rul_ptr->expansion_symbols[j+1];
+	// Add end of input to follow set of start symbol
+	set_set_bit(follow_rows + get_variable_index(grm_ptr, grm_ptr->start_symbol) * len_set_words, get_terminal_index(grm_ptr, grm_ptr->end_symbol));
 
-							if( BitSet_get_bit(psr_ptr->symbol_class_set, next_expansion_symbol) == 1 ){
-								// Add the terminal symbol
+	for (int i = 0; i < grm_ptr->len_rule_list; ++i){
+		Rule *rul_ptr = grm_ptr->rule_list[i];
+		int variable_index = get_variable_index(grm_ptr, rul_ptr->variable_symbol);
 
-								if( BitSet_get_bit(exp_follow_set_ptr, next_expansion_symbol) == 0 ){
-									// Not yet set
-									BitSet_set_bit(exp_follow_set_ptr, next_expansion_symbol);
-									flag_change = 1;
-								}
-							}
+		if(variable_index == -1)
+			continue;
 
-							else{
-								// Add first set of following symbol
+		// Set while all symbols after the current one are nullable, so that
+		// follow of lhs is included in follow of current symbol
+		int flag_nullable = 1;
 
-								BitSet *next_exp_first_set_ptr = HashTable_get(psr_ptr->first_table, (void*) &next_expansion_symbol);
+		// Iterate in reverse, to track nullable suffix
+		for (int j = rul_ptr->len_expansion_symbols - 1; j >= 0; --j){
+			int expansion_symbol = rul_ptr->expansion_symbols[j];
+			int expansion_index = get_variable_index(grm_ptr, expansion_symbol);
 
-								// Temporary set to find changes
-								BitSet *tmp_set_ptr = BitSet_clone(next_exp_first_set_ptr);
-								BitSet_subtract(tmp_set_ptr, exp_follow_set_ptr);
+			// No follow set of empty symbol
+			if(expansion_symbol == grm_ptr->empty_symbol)
+				continue;
 
-								if(BitSet_get_any(tmp_set_ptr) == 1){
-									// New terminals exist to be added to follow set
-									BitSet_or(exp_follow_set_ptr, next_exp_first_set_ptr);
-									flag_change = 1;
-								}
+			if(expansion_index == -1){
+				// Terminal symbol, no follow set, and no null expansion
+				// possible from here
+				flag_nullable = 0;
+				continue;
+			}
 
-								BitSet_destroy(tmp_set_ptr);
-							}
-						}
-					}
+			if(flag_nullable == 1)
+				add_set_dependency(&deps, expansion_index, variable_index);
 
-					else{
-						// Terminal symbol, no follow set
+			if( set_get_bit(grm_ptr->nullable_set, expansion_index) == 0 )
+				flag_nullable = 0;
 
-						// Set this to 0 as it is no longer possibe to have a
-						// null expansion
-						flag_nullable = 0;
-					}
+			if(j < rul_ptr->len_expansion_symbols - 1){
+				// Symbol is not the last in rule, add first set of next symbol
+				int next_expansion_symbol = rul_ptr->expansion_symbols[j+1];
+				int next_expansion_index = get_variable_index(grm_ptr, next_expansion_symbol);
 
+				if(next_expansion_index == -1){
+					int terminal_index = get_terminal_index(grm_ptr, next_expansion_symbol);
+					if(terminal_index != -1)
+						set_set_bit(follow_rows + expansion_index * len_set_words, terminal_index);
 				}
-
-				rul_ptr = rul_ptr->next;
+				else
+					grm_ptr->or_words(follow_rows + expansion_index * len_set_words, grm_ptr->first_rows + next_expansion_index * len_set_words, len_set_words);
 			}
 		}
 	}
-}
-
-static void populate_parse_table(ParserLL1 *psr_ptr){
-	for (int i = 0; i < psr_ptr->len_variable_symbols; ++i){
-		// For each variable
 
-		int variable_symbol = psr_ptr->variable_symbols[i];
-		int *variable_symbol_ptr = &(psr_ptr->variable_symbols[i]);
-		HashTable* var_row_tbl_ptr = HashTable_get(psr_ptr->parse_table, &variable_symbol);
+	propagate_sets(follow_rows, len_set_words, grm_ptr->len_variable_symbols, &deps, grm_ptr->or_words, num_threads);
 
-		Rule *rul_ptr = HashTable_get(psr_ptr->rule_table, (void*) &variable_symbol );
+	free(deps.from_indices);
+	free(deps.to_indices);
+}
 
-		while(rul_ptr != NULL){
-			// For each expansion of the variable symbol
+static int get_variable_index(ParserLL1_Grammar *grm_ptr, int symbol){
+	int flags = get_symbol_flags(grm_ptr, symbol);
 
-			int expansion_symbol = rul_ptr->expansion_symbols[0];
-			// Need pointer for hashtable key
-			int *expansion_symbol_ptr = &(rul_ptr->expansion_symbols[0]);
+	if( (flags & SYMBOL_FLAG_KNOWN) == 0 || (flags & SYMBOL_FLAG_TERMINAL) != 0 )
+		return -1;
+	return grm_ptr->symbol_attr_table[symbol - grm_ptr->symbols_min].index;
+}
 
-			if( BitSet_get_bit(psr_ptr->symbol_class_set, expansion_symbol) == 1 ){
-				// Symbol is terminal. First set is itself
-				HashTable_add(var_row_tbl_ptr, expansion_symbol_ptr, rul_ptr);
-				// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, expansion_symbol);
-			}
+static int get_terminal_index(ParserLL1_Grammar *grm_ptr, int symbol){
+	if( (get_symbol_flags(grm_ptr, symbol) & SYMBOL_FLAG_TERMINAL) == 0 )
+		return -1;
+	return grm_ptr->symbol_attr_table[symbol - grm_ptr->symbols_min].index;
+}
 
-			else{
-				// Symbol is not terminal. Need to add rule for each symbol in
-				// first set
+static void add_set_dependency(SetDependencies *deps_ptr, int from_index, int to_index){
+	if(deps_ptr->len_dependencies == deps_ptr->cap_dependencies){
+		deps_ptr->cap_dependencies = deps_ptr->cap_dependencies > 0 ? deps_ptr->cap_dependencies * 2 : 64;
+		deps_ptr->from_indices = realloc( deps_ptr->from_indices, sizeof(int) * deps_ptr->cap_dependencies );
+		deps_ptr->to_indices = realloc( deps_ptr->to_indices, sizeof(int) * deps_ptr->cap_dependencies );
+	}
 
-				BitSet *exp_first_set_ptr = HashTable_get(psr_ptr->first_table, expansion_symbol_ptr);
+	deps_ptr->from_indices[deps_ptr->len_dependencies] = from_index;
+	deps_ptr->to_indices[deps_ptr->len_dependencies] = to_index;
+	deps_ptr->len_dependencies++;
+}
 
-				for (int j = 0; j < psr_ptr->len_terminal_symbols; ++j){
-					if( BitSet_get_bit(exp_first_set_ptr, psr_ptr->terminal_symbols[j]) == 1 ){
-						HashTable_add(var_row_tbl_ptr, &(psr_ptr->terminal_symbols[j]), rul_ptr);
-						// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, psr_ptr->terminal_symbols[j]);
-					}
+static void propagate_sets(uint64_t *sets, int len_set_words, int len_sets, SetDependencies *deps_ptr, WordSet_OrFunction or_words, int num_threads){
+	// Sets of a strongly connected component of the dependency graph are all
+	// equal. Components are found with Tarjan's algorithm, which completes
+	// each one after all components it depends on. Each component is placed
+	// one level above the highest component it depends on, and is solved
+	// with a single union once lower levels are done. Components of a level
+	// are independent, and are solved in parallel
+	int len_deps = deps_ptr->len_dependencies;
+	int len_alloc = len_sets > 0 ? len_sets : 1;
+
+	// Group dependencies by set
+	int *dep_offsets = calloc(len_sets + 1, sizeof(int));
+	int *dep_targets = malloc( sizeof(int) * (len_deps > 0 ? len_deps : 1) );
+
+	for (int i = 0; i < len_deps; ++i)
+		dep_offsets[ deps_ptr->from_indices[i] + 1 ]++;
+	for (int i = 0; i < len_sets; ++i)
+		dep_offsets[i + 1] += dep_offsets[i];
+
+	int *dep_ends = malloc( sizeof(int) * len_alloc );
+	memcpy(dep_ends, dep_offsets, sizeof(int) * len_sets);
+	for (int i = 0; i < len_deps; ++i)
+		dep_targets[ dep_ends[ deps_ptr->from_indices[i] ]++ ] = deps_ptr->to_indices[i];
+
+	// Visit order of each set, 0 if not yet visited
+	int *order = calloc(len_alloc, sizeof(int));
+	int *low_link = malloc( sizeof(int) * len_alloc );
+	char *flag_on_stack = calloc(len_alloc, sizeof(char));
+	int *component_stack = malloc( sizeof(int) * len_alloc );
+	int len_component_stack = 0;
+	// Explicit call stack of sets and their next dependency to visit
+	int *call_stack = malloc( sizeof(int) * len_alloc );
+	int *call_dep_index = malloc( sizeof(int) * len_alloc );
+	int len_call_stack = 0;
+	int next_order = 1;
+
+	// Components in order of completion, and component and level of each
+	int *members = malloc( sizeof(int) * len_alloc );
+	int *member_offsets = malloc( sizeof(int) * (len_sets + 1) );
+	int *component_of_set = malloc( sizeof(int) * len_alloc );
+	int *component_levels = malloc( sizeof(int) * len_alloc );
+	int len_components = 0;
+	int len_levels = 0;
+	member_offsets[0] = 0;
+
+	for (int root = 0; root < len_sets; ++root){
+		if(order[root] != 0)
+			continue;
+
+		call_stack[0] = root;
+		call_dep_index[0] = dep_offsets[root];
+		len_call_stack = 1;
+		order[root] = low_link[root] = next_order++;
+		component_stack[len_component_stack++] = root;
+		flag_on_stack[root] = 1;
+
+		while(len_call_stack > 0){
+			int set_index = call_stack[len_call_stack - 1];
+
+			if(call_dep_index[len_call_stack - 1] < dep_offsets[set_index + 1]){
+				// Visit next dependency
+				int target_index = dep_targets[ call_dep_index[len_call_stack - 1]++ ];
+
+				if(order[target_index] == 0){
+					order[target_index] = low_link[target_index] = next_order++;
+					component_stack[len_component_stack++] = target_index;
+					flag_on_stack[target_index] = 1;
+					call_stack[len_call_stack] = target_index;
+					call_dep_index[len_call_stack] = dep_offsets[target_index];
+					len_call_stack++;
 				}
+				else if(flag_on_stack[target_index] && order[target_index] < low_link[set_index])
+					low_link[set_index] = order[target_index];
 
-				// Check if rule is nullable
-				int flag_nullable = 1;
-				for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j){
-					if( BitSet_get_bit(psr_ptr->nullable_set, rul_ptr->expansion_symbols[j]) == 0 ){
-						// Not nullable
-						flag_nullable = 0;
-						break;
-					}
-				}
+				continue;
+			}
 
-				// Add if rule is nullable
-				if( flag_nullable == 1 ){
-					// Need to add rule for each symbol in follow set as the
-					// rule is nullable
+			// All dependencies visited, return to caller
+			len_call_stack--;
+			if(len_call_stack > 0){
+				int caller_index = call_stack[len_call_stack - 1];
+				if(low_link[set_index] < low_link[caller_index])
+					low_link[caller_index] = low_link[set_index];
+			}
 
-					BitSet *exp_follow_set_ptr = HashTable_get(psr_ptr->follow_table, variable_symbol_ptr);
+			if(low_link[set_index] != order[set_index])
+				continue;
 
-					for (int j = 0; j < psr_ptr->len_terminal_symbols; ++j){
-						if( BitSet_get_bit(exp_follow_set_ptr, psr_ptr->terminal_symbols[j]) == 1 ){
-							HashTable_add(var_row_tbl_ptr, &(psr_ptr->terminal_symbols[j]), rul_ptr);
-							// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, psr_ptr->terminal_symbols[j]);
-						}
-					}
+			// Set is root of a component, and is first on the component
+			// stack among its members
+			int component_start = len_component_stack;
+			do{
+				component_start--;
+				flag_on_stack[ component_stack[component_start] ] = 0;
+			}while(component_stack[component_start] != set_index);
+
+			int component_index = len_components++;
+			int len_members = len_component_stack - component_start;
+			memcpy( members + member_offsets[component_index], component_stack + component_start, sizeof(int) * len_members );
+			member_offsets[component_index + 1] = member_offsets[component_index] + len_members;
+
+			for (int i = component_start; i < len_component_stack; ++i)
+				component_of_set[ component_stack[i] ] = component_index;
+
+			// Components depended on are already complete
+			int level = 0;
+			for (int i = component_start; i < len_component_stack; ++i){
+				int member_index = component_stack[i];
+				for (int j = dep_offsets[member_index]; j < dep_offsets[member_index + 1]; ++j){
+					int target_component_index = component_of_set[ dep_targets[j] ];
+					if(target_component_index != component_index && component_levels[target_component_index] >= level)
+						level = component_levels[target_component_index] + 1;
 				}
 			}
+			component_levels[component_index] = level;
+			if(level >= len_levels)
+				len_levels = level + 1;
 
-			rul_ptr = rul_ptr->next;
+			len_component_stack = component_start;
 		}
 	}
-}
 
-void ParserLL1_initialize_rules(ParserLL1 *psr_ptr){
-	calculate_first_table(psr_ptr);
-	calculate_follow_table(psr_ptr);
-	populate_parse_table(psr_ptr);
+	// Group components by level
+	int *level_offsets = calloc(len_levels + 1, sizeof(int));
+	int *level_components = malloc( sizeof(int) * (len_components > 0 ? len_components : 1) );
+
+	for (int i = 0; i < len_components; ++i)
+		level_offsets[ component_levels[i] + 1 ]++;
+	for (int i = 0; i < len_levels; ++i)
+		level_offsets[i + 1] += level_offsets[i];
+
+	int *level_ends = malloc( sizeof(int) * (len_levels > 0 ? len_levels : 1) );
+	memcpy(level_ends, level_offsets, sizeof(int) * len_levels);
+	for (int i = 0; i < len_components; ++i)
+		level_components[ level_ends[ component_levels[i] ]++ ] = i;
+
+	SetComponents cmp;
+	cmp.sets = sets;
+	cmp.len_set_words = len_set_words;
+	cmp.or_words = or_words;
+	cmp.dep_offsets = dep_offsets;
+	cmp.dep_targets = dep_targets;
+	cmp.members = members;
+	cmp.member_offsets = member_offsets;
+
+	for (int i = 0; i < len_levels; ++i){
+		int len_level_components = level_offsets[i + 1] - level_offsets[i];
+		cmp.level_components = level_components + level_offsets[i];
+
+		// Small levels are not worth starting threads for
+		WorkPool_run(len_level_components, len_level_components >= PARSERLL1_MIN_PARALLEL_GRAMMAR_TASKS ? num_threads : 1, solve_set_component_task, &cmp);
+	}
+
+	free(level_offsets);
+	free(level_components);
+	free(level_ends);
+	free(members);
+	free(member_offsets);
+	free(component_of_set);
+	free(component_levels);
+	free(dep_offsets);
+	free(dep_targets);
+	free(dep_ends);
+	free(order);
+	free(low_link);
+	free(flag_on_stack);
+	free(component_stack);
+	free(call_stack);
+	free(call_dep_index);
 }
 
+static void solve_set_component_task(void *ctx, int thread_index, int task_index){
+	(void)thread_index;
 
-/////////
-// Run //
-/////////
+	SetComponents *cmp_ptr = ctx;
+	int component_index = cmp_ptr->level_components[task_index];
+	int len_set_words = cmp_ptr->len_set_words;
 
-Parser_StepResult_type ParserLL1_step(ParserLL1 *psr_ptr, Token *tkn_ptr){
-	int lookahead_symbol = psr_ptr->token_to_symbol(tkn_ptr);
+	int *members = cmp_ptr->members + cmp_ptr->member_offsets[component_index];
+	int len_members = cmp_ptr->member_offsets[component_index + 1] - cmp_ptr->member_offsets[component_index];
 
-	// Check if symbol is valid terminal
-	int flag_symbol_known = 0;
-	for (int i = 0; i < psr_ptr->len_terminal_symbols; ++i){
-		if(lookahead_symbol == psr_ptr->terminal_symbols[i]){
-			// Lookahead symbol belongs to terminal set of this parser
-			flag_symbol_known = 1;
-			break;
+	// Collect union of component into root, then copy it to the other
+	// members. Sets of other components read here are on lower levels, and
+	// already final
+	int root_index = members[0];
+	uint64_t *root_set = cmp_ptr->sets + root_index * len_set_words;
+
+	for (int i = 0; i < len_members; ++i){
+		int member_index = members[i];
+
+		if(member_index != root_index)
+			cmp_ptr->or_words(root_set, cmp_ptr->sets + member_index * len_set_words, len_set_words);
+		for (int j = cmp_ptr->dep_offsets[member_index]; j < cmp_ptr->dep_offsets[member_index + 1]; ++j){
+			if(cmp_ptr->dep_targets[j] != root_index)
+				cmp_ptr->or_words(root_set, cmp_ptr->sets + cmp_ptr->dep_targets[j] * len_set_words, len_set_words);
 		}
 	}
 
-	if(flag_symbol_known == 0){
-		// Symbol is invalid
-
-		// Free token, as not added to parse tree, will be lost
-		// otherwise
-		Token_destroy(tkn_ptr);
+	// Other members only hold a subset of the union
+	for (int i = 1; i < len_members; ++i)
+		memcpy(cmp_ptr->sets + members[i] * len_set_words, root_set, sizeof(uint64_t) * len_set_words);
+}
 
-		return PARSER_STEP_RESULT_UNKNOWN_INPUT;
+static void populate_parse_table(ParserLL1_Grammar *grm_ptr, int num_threads){
+	// Allocate dense table, unless the size overflows. Each entry is
+	// initialized to -1 as no rule is present
+	int len_dense_parse_table = 0;
+	grm_ptr->dense_parse_table = NULL;
+	if( grm_ptr->len_terminal_symbols == 0 || grm_ptr->len_variable_symbols <= INT_MAX / grm_ptr->len_terminal_symbols ){
+		len_dense_parse_table = grm_ptr->len_variable_symbols * grm_ptr->len_terminal_symbols;
+		grm_ptr->dense_parse_table = malloc( sizeof(int) * (len_dense_parse_table > 0 ? len_dense_parse_table : 1) );
+	}
+	if(grm_ptr->dense_parse_table != NULL){
+		for (int i = 0; i < len_dense_parse_table; ++i)
+			grm_ptr->dense_parse_table[i] = -1;
 	}
 
+	// Rows are independent, each only adds to its own row tables
+	int len_rows = grm_ptr->len_variable_symbols;
+	WorkPool_run(len_rows, len_rows >= PARSERLL1_MIN_PARALLEL_GRAMMAR_TASKS ? num_threads : 1, populate_parse_table_row_task, grm_ptr);
+}
+
+static void populate_parse_table_row_task(void *ctx, int thread_index, int task_index){
+	(void)thread_index;
+
+	ParserLL1_Grammar *grm_ptr = ctx;
+	int variable_index = task_index;
+	int len_set_words = grm_ptr->len_set_words;
+
+	int variable_symbol = grm_ptr->variable_symbols[variable_index];
+	HashTable* var_row_tbl_ptr = HashTable_get(grm_ptr->parse_table, &variable_symbol);
+
+	// Row of variable in dense table
+	int *var_dense_row_ptr = NULL;
+	if(grm_ptr->dense_parse_table != NULL)
+		var_dense_row_ptr = grm_ptr->dense_parse_table + variable_index * grm_ptr->len_terminal_symbols;
+
+	Rule *rul_ptr = HashTable_get(grm_ptr->rule_table, (void*) &variable_symbol );
+
+	while(rul_ptr != NULL){
+		// For each expansion of the variable symbol
+
+		int expansion_symbol = rul_ptr->expansion_symbols[0];
+		// Need pointer for hashtable key
+		int *expansion_symbol_ptr = &(rul_ptr->expansion_symbols[0]);
+
+		if( get_symbol_flags(grm_ptr, expansion_symbol) & SYMBOL_FLAG_TERMINAL ){
+			// Symbol is terminal. First set is itself
+			HashTable_add(var_row_tbl_ptr, expansion_symbol_ptr, rul_ptr);
+			if(var_dense_row_ptr != NULL)
+				var_dense_row_ptr[ grm_ptr->symbol_attr_table[expansion_symbol - grm_ptr->symbols_min].index ] = rul_ptr->rule_index;
+			// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, expansion_symbol);
+		}
+
+		else{
+			// Symbol is not terminal. Need to add rule for each symbol in
+			// first set
+
+			int expansion_index = get_variable_index(grm_ptr, expansion_symbol);
+			if(expansion_index == -1){
+				// Unknown symbol, nothing can be derived from it
+				rul_ptr = rul_ptr->next;
+				continue;
+			}
+			uint64_t *exp_first_row_ptr = grm_ptr->first_rows + expansion_index * len_set_words;
+
+			for (int j = WordSet_next(exp_first_row_ptr, len_set_words, 0); j != -1; j = WordSet_next(exp_first_row_ptr, len_set_words, j + 1)){
+				HashTable_add(var_row_tbl_ptr, &(grm_ptr->terminal_symbols[j]), rul_ptr);
+				if(var_dense_row_ptr != NULL)
+					var_dense_row_ptr[j] = rul_ptr->rule_index;
+				// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, grm_ptr->terminal_symbols[j]);
+			}
+
+			// Check if rule is nullable
+			int flag_nullable = 1;
+			for (int j = 0; j < rul_ptr->len_expansion_symbols; ++j){
+				int nullable_index = get_variable_index(grm_ptr, rul_ptr->expansion_symbols[j]);
+				if( nullable_index == -1 || set_get_bit(grm_ptr->nullable_set, nullable_index) == 0 ){
+					// Not nullable
+					flag_nullable = 0;
+					break;
+				}
+			}
+
+			// Add if rule is nullable
+			if( flag_nullable == 1 ){
+				// Need to add rule for each symbol in follow set as the
+				// rule is nullable
+
+				uint64_t *exp_follow_row_ptr = grm_ptr->follow_rows + variable_index * len_set_words;
+
+				for (int j = WordSet_next(exp_follow_row_ptr, len_set_words, 0); j != -1; j = WordSet_next(exp_follow_row_ptr, len_set_words, j + 1)){
+					HashTable_add(var_row_tbl_ptr, &(grm_ptr->terminal_symbols[j]), rul_ptr);
+					if(var_dense_row_ptr != NULL)
+						var_dense_row_ptr[j] = rul_ptr->rule_index;
+					// printf("populate_parse_table : \t\t\t\t\t[%d,%d]\n", variable_symbol, grm_ptr->terminal_symbols[j]);
+				}
+			}
+		}
+
+		rul_ptr = rul_ptr->next;
+	}
+}
+
+static void compile_rules(ParserLL1_Grammar *grm_ptr){
+	grm_ptr->len_compiled_rules = grm_ptr->len_rule_list;
+	grm_ptr->compiled_rules = malloc( sizeof(CompiledRule) * (grm_ptr->len_rule_list > 0 ? grm_ptr->len_rule_list : 1) );
+
+	grm_ptr->len_expansion_pool = 0;
+	for (int i = 0; i < grm_ptr->len_rule_list; ++i)
+		grm_ptr->len_expansion_pool += grm_ptr->rule_list[i]->len_expansion_symbols;
+	grm_ptr->expansion_pool = malloc( sizeof(int) * (grm_ptr->len_expansion_pool > 0 ? grm_ptr->len_expansion_pool : 1) );
+
+	// Lay out expansions one after another
+	int offset = 0;
+	for (int i = 0; i < grm_ptr->len_rule_list; ++i){
+		Rule *rul_ptr = grm_ptr->rule_list[i];
+		CompiledRule *crl_ptr = &(grm_ptr->compiled_rules[i]);
+
+		crl_ptr->rule_num = rul_ptr->rule_num;
+		crl_ptr->variable_symbol = rul_ptr->variable_symbol;
+		crl_ptr->expansion_offset = offset;
+		crl_ptr->len_expansion_symbols = rul_ptr->len_expansion_symbols;
+
+		memcpy( grm_ptr->expansion_pool + offset, rul_ptr->expansion_symbols, sizeof(int) * rul_ptr->len_expansion_symbols );
+		offset += rul_ptr->len_expansion_symbols;
+	}
+}
+
+static int get_parse_table_entry(ParserLL1_Grammar *grm_ptr, int variable_symbol, int terminal_symbol){
+	if(grm_ptr->dense_parse_table != NULL){
+		// Both symbols are known, index directly
+		int variable_index = grm_ptr->symbol_attr_table[variable_symbol - grm_ptr->symbols_min].index;
+		int terminal_index = grm_ptr->symbol_attr_table[terminal_symbol - grm_ptr->symbols_min].index;
+		return grm_ptr->dense_parse_table[variable_index * grm_ptr->len_terminal_symbols + terminal_index];
+	}
+
+	else{
+		// Fall back to hash table lookup
+		HashTable *var_row_tbl_ptr = HashTable_get(grm_ptr->parse_table, (void *) &variable_symbol);
+		Rule *rul_ptr = HashTable_get(var_row_tbl_ptr, (void *) &terminal_symbol);
+
+		if(rul_ptr == NULL)
+			return -1;
+		return rul_ptr->rule_index;
+	}
+}
+
+static int get_symbol_flags(ParserLL1_Grammar *grm_ptr, int symbol){
+	if(symbol < grm_ptr->symbols_min || symbol > grm_ptr->symbols_max)
+		return 0;
+	return grm_ptr->symbol_attr_table[symbol - grm_ptr->symbols_min].flags;
+}
+
+static void calculate_symbol_ranges(ParserLL1_Grammar *grm_ptr){
+	grm_ptr->variable_symbols_min = INT_MAX;
+	grm_ptr->variable_symbols_max = INT_MIN;
+	grm_ptr->terminal_symbols_min = INT_MAX;
+	grm_ptr->terminal_symbols_max = INT_MIN;
+
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		if(grm_ptr->variable_symbols[i] < grm_ptr->variable_symbols_min)
+			grm_ptr->variable_symbols_min = grm_ptr->variable_symbols[i];
+		if(grm_ptr->variable_symbols[i] > grm_ptr->variable_symbols_max)
+			grm_ptr->variable_symbols_max = grm_ptr->variable_symbols[i];
+	}
+
+	for (int i = 0; i < grm_ptr->len_terminal_symbols; ++i){
+		if(grm_ptr->terminal_symbols[i] < grm_ptr->terminal_symbols_min)
+			grm_ptr->terminal_symbols_min = grm_ptr->terminal_symbols[i];
+		if(grm_ptr->terminal_symbols[i] > grm_ptr->terminal_symbols_max)
+			grm_ptr->terminal_symbols_max = grm_ptr->terminal_symbols[i];
+	}
+
+	if(grm_ptr->terminal_symbols_min < grm_ptr->variable_symbols_min)
+		grm_ptr->symbols_min = grm_ptr->terminal_symbols_min;
+	else
+		grm_ptr->symbols_min = grm_ptr->variable_symbols_min;
+
+	if(grm_ptr->terminal_symbols_max > grm_ptr->variable_symbols_max)
+		grm_ptr->symbols_max = grm_ptr->terminal_symbols_max;
+	else
+		grm_ptr->symbols_max = grm_ptr->variable_symbols_max;
+}
+
+static int check_special_symbols(ParserLL1_Grammar *grm_ptr){
+	int symbols_min = grm_ptr->symbols_min;
+	int symbols_max = grm_ptr->symbols_max;
+
+	int flag_invalid = grm_ptr->len_variable_symbols <= 0 || grm_ptr->len_terminal_symbols <= 0;
+	flag_invalid |= grm_ptr->start_symbol < symbols_min || grm_ptr->start_symbol > symbols_max;
+	flag_invalid |= grm_ptr->empty_symbol < symbols_min || grm_ptr->empty_symbol > symbols_max;
+	flag_invalid |= grm_ptr->end_symbol < symbols_min || grm_ptr->end_symbol > symbols_max;
+	for (int i = 0; i < grm_ptr->len_forget_terminal_symbols; ++i)
+		flag_invalid |= grm_ptr->forget_terminal_symbols[i] < symbols_min || grm_ptr->forget_terminal_symbols[i] > symbols_max;
+
+	return flag_invalid ? -1 : 0;
+}
+
+static SymbolAttr *new_symbol_attr_table(ParserLL1_Grammar *grm_ptr){
+	int symbols_min = grm_ptr->symbols_min;
+
+	SymbolAttr *attr_tbl = malloc( sizeof(SymbolAttr) * (grm_ptr->symbols_max - symbols_min + 1) );
+	for (int i = 0; i < grm_ptr->symbols_max - symbols_min + 1; ++i){
+		attr_tbl[i].index = -1;
+		attr_tbl[i].flags = 0;
+	}
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		attr_tbl[grm_ptr->variable_symbols[i] - symbols_min].index = i;
+		attr_tbl[grm_ptr->variable_symbols[i] - symbols_min].flags |= SYMBOL_FLAG_KNOWN;
+	}
+	for (int i = 0; i < grm_ptr->len_terminal_symbols; ++i){
+		attr_tbl[grm_ptr->terminal_symbols[i] - symbols_min].index = i;
+		attr_tbl[grm_ptr->terminal_symbols[i] - symbols_min].flags |= SYMBOL_FLAG_KNOWN | SYMBOL_FLAG_TERMINAL;
+	}
+	for (int i = 0; i < grm_ptr->len_forget_terminal_symbols; ++i)
+		attr_tbl[grm_ptr->forget_terminal_symbols[i] - symbols_min].flags |= SYMBOL_FLAG_FORGET;
+	attr_tbl[grm_ptr->end_symbol - symbols_min].flags |= SYMBOL_FLAG_END;
+	attr_tbl[grm_ptr->empty_symbol - symbols_min].flags |= SYMBOL_FLAG_EMPTY | SYMBOL_FLAG_NULLABLE;
+
+	return attr_tbl;
+}
+
+void ParserLL1_initialize_rules(ParserLL1 *psr_ptr){
+	ParserLL1_Grammar_initialize_rules(psr_ptr->grm_ptr);
+
+#ifdef PARSERLL1_STATS
+	// Parser was created before rules were known
+	if(psr_ptr->stats.len_rule_expansions != psr_ptr->grm_ptr->len_compiled_rules){
+		free(psr_ptr->stats.rule_expansions);
+		psr_ptr->stats.len_rule_expansions = psr_ptr->grm_ptr->len_compiled_rules;
+		psr_ptr->stats.rule_expansions = calloc( psr_ptr->stats.len_rule_expansions > 0 ? psr_ptr->stats.len_rule_expansions : 1, sizeof(long long) );
+	}
+#endif
+}
+
+void ParserLL1_Grammar_initialize_rules(ParserLL1_Grammar *grm_ptr){
+	ParserLL1_Grammar_initialize_rules_parallel(grm_ptr, 1);
+}
+
+void ParserLL1_Grammar_initialize_rules_parallel(ParserLL1_Grammar *grm_ptr, int num_threads){
+	if(grm_ptr->flag_rules_initialized == 1)
+		return;
+	grm_ptr->flag_rules_initialized = 1;
+
+	calculate_first_table(grm_ptr, num_threads);
+	calculate_follow_table(grm_ptr, num_threads);
+	populate_parse_table(grm_ptr, num_threads);
+	compile_rules(grm_ptr);
+	build_sync_rows(grm_ptr);
+
+	// Copy nullable set into symbol attributes
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		if( set_get_bit(grm_ptr->nullable_set, i) == 1 )
+			grm_ptr->symbol_attr_table[grm_ptr->variable_symbols[i] - grm_ptr->symbols_min].flags |= SYMBOL_FLAG_NULLABLE;
+	}
+}
+
+
+////////////////
+// Dense sets //
+////////////////
+
+static inline int set_get_bit(uint64_t *set, int index){
+	return (set[index >> 6] >> (index & 63)) & 1;
+}
+
+static inline void set_set_bit(uint64_t *set, int index){
+	set[index >> 6] |= (uint64_t)1 << (index & 63);
+}
+
+
+////////////////////
+// Grammar images //
+////////////////////
+
+int ParserLL1_Grammar_save(ParserLL1_Grammar *grm_ptr, const char *path){
+	if(grm_ptr->flag_rules_initialized == 0 || grm_ptr->dense_parse_table == NULL)
+		return -1;
+
+	FILE *file_ptr = fopen(path, "wb");
+	if(file_ptr == NULL)
+		return -1;
+
+	int flag_failed = write_image(grm_ptr, file_ptr);
+
+	if( fclose(file_ptr) != 0 )
+		flag_failed = 1;
+
+	return flag_failed ? -1 : 0;
+}
+
+static int write_image(ParserLL1_Grammar *grm_ptr, FILE *file_ptr){
+	GrammarImageHeader hdr;
+	memset(&hdr, 0, sizeof(GrammarImageHeader));
+
+	memcpy(hdr.magic, GRAMMAR_IMAGE_MAGIC, sizeof(GRAMMAR_IMAGE_MAGIC));
+	hdr.version = GRAMMAR_IMAGE_VERSION;
+	hdr.byte_order = GRAMMAR_IMAGE_BYTE_ORDER;
+	hdr.size_symbol_attr = sizeof(SymbolAttr);
+	hdr.size_compiled_rule = sizeof(CompiledRule);
+
+	hdr.len_variable_symbols = grm_ptr->len_variable_symbols;
+	hdr.len_terminal_symbols = grm_ptr->len_terminal_symbols;
+	hdr.len_forget_terminal_symbols = grm_ptr->len_forget_terminal_symbols;
+	hdr.variable_symbols_min = grm_ptr->variable_symbols_min;
+	hdr.variable_symbols_max = grm_ptr->variable_symbols_max;
+	hdr.terminal_symbols_min = grm_ptr->terminal_symbols_min;
+	hdr.terminal_symbols_max = grm_ptr->terminal_symbols_max;
+	hdr.symbols_min = grm_ptr->symbols_min;
+	hdr.symbols_max = grm_ptr->symbols_max;
+	hdr.start_symbol = grm_ptr->start_symbol;
+	hdr.empty_symbol = grm_ptr->empty_symbol;
+	hdr.end_symbol = grm_ptr->end_symbol;
+	hdr.len_compiled_rules = grm_ptr->len_compiled_rules;
+	hdr.len_expansion_pool = grm_ptr->len_expansion_pool;
+	hdr.len_set_words = grm_ptr->len_set_words;
+
+	// Header is written again once offsets are known
+	uint64_t offset = 0;
+	int flag_failed = write_image_section(file_ptr, &offset, &hdr, sizeof(GrammarImageHeader));
+
+	int len_rows = grm_ptr->len_variable_symbols * grm_ptr->len_set_words;
+
+	hdr.variable_symbols_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->variable_symbols, sizeof(int) * grm_ptr->len_variable_symbols);
+	hdr.terminal_symbols_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->terminal_symbols, sizeof(int) * grm_ptr->len_terminal_symbols);
+	hdr.forget_terminal_symbols_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->forget_terminal_symbols, sizeof(int) * grm_ptr->len_forget_terminal_symbols);
+	hdr.symbol_attr_table_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->symbol_attr_table, sizeof(SymbolAttr) * (grm_ptr->symbols_max - grm_ptr->symbols_min + 1));
+	hdr.compiled_rules_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->compiled_rules, sizeof(CompiledRule) * grm_ptr->len_compiled_rules);
+	hdr.expansion_pool_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->expansion_pool, sizeof(int) * grm_ptr->len_expansion_pool);
+	hdr.first_rows_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->first_rows, sizeof(uint64_t) * len_rows);
+	hdr.follow_rows_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->follow_rows, sizeof(uint64_t) * len_rows);
+	hdr.dense_parse_table_offset = offset;
+	flag_failed |= write_image_section(file_ptr, &offset, grm_ptr->dense_parse_table, sizeof(int) * grm_ptr->len_variable_symbols * grm_ptr->len_terminal_symbols);
+
+	hdr.len_image = offset;
+
+	// Rewrite header with offsets
+	if( fseek(file_ptr, 0, SEEK_SET) != 0 || fwrite(&hdr, sizeof(GrammarImageHeader), 1, file_ptr) != 1 )
+		flag_failed = 1;
+
+	return flag_failed;
+}
+
+ParserLL1_Grammar *ParserLL1_Grammar_load(const char *path, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){
+	int fd = open(path, O_RDONLY);
+	if(fd == -1)
+		return NULL;
+
+	struct stat st;
+	if( fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(GrammarImageHeader) ){
+		close(fd);
+		return NULL;
+	}
+
+	// Mapping stays valid after file is closed
+	size_t len_image = st.st_size;
+	void *image_ptr = mmap(NULL, len_image, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(image_ptr == MAP_FAILED)
+		return NULL;
+
+	ParserLL1_Grammar *grm_ptr = ParserLL1_Grammar_from_image(image_ptr, len_image, token_to_symbol, symbol_to_string, token_to_value);
+	if(grm_ptr == NULL){
+		munmap(image_ptr, len_image);
+		return NULL;
+	}
+
+	// Unmapped when grammar is destroyed
+	grm_ptr->flag_image_mapped = 1;
+
+	return grm_ptr;
+}
+
+ParserLL1_Grammar *ParserLL1_Grammar_from_image(const void *image_ptr, size_t len_image, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){
+	if(len_image < sizeof(GrammarImageHeader) || (uintptr_t)image_ptr % 8 != 0)
+		return NULL;
+
+	// Validate header and sections
+	const GrammarImageHeader *hdr_ptr = image_ptr;
+	uint64_t len_rows = (uint64_t)hdr_ptr->len_variable_symbols * (uint64_t)hdr_ptr->len_set_words;
+	if(
+		memcmp(hdr_ptr->magic, GRAMMAR_IMAGE_MAGIC, sizeof(GRAMMAR_IMAGE_MAGIC)) != 0 ||
+		hdr_ptr->version != GRAMMAR_IMAGE_VERSION ||
+		hdr_ptr->byte_order != GRAMMAR_IMAGE_BYTE_ORDER ||
+		hdr_ptr->size_symbol_attr != sizeof(SymbolAttr) ||
+		hdr_ptr->size_compiled_rule != sizeof(CompiledRule) ||
+		hdr_ptr->len_image != len_image ||
+		hdr_ptr->len_variable_symbols <= 0 || hdr_ptr->len_terminal_symbols <= 0 ||
+		hdr_ptr->len_forget_terminal_symbols < 0 ||
+		hdr_ptr->len_compiled_rules < 0 || hdr_ptr->len_expansion_pool < 0 ||
+		hdr_ptr->symbols_max < hdr_ptr->symbols_min ||
+		hdr_ptr->len_set_words != (hdr_ptr->len_terminal_symbols + 63) / 64 ||
+		check_image_section(hdr_ptr, hdr_ptr->variable_symbols_offset, hdr_ptr->len_variable_symbols, sizeof(int)) ||
+		check_image_section(hdr_ptr, hdr_ptr->terminal_symbols_offset, hdr_ptr->len_terminal_symbols, sizeof(int)) ||
+		check_image_section(hdr_ptr, hdr_ptr->forget_terminal_symbols_offset, hdr_ptr->len_forget_terminal_symbols, sizeof(int)) ||
+		check_image_section(hdr_ptr, hdr_ptr->symbol_attr_table_offset, (uint64_t)hdr_ptr->symbols_max - hdr_ptr->symbols_min + 1, sizeof(SymbolAttr)) ||
+		check_image_section(hdr_ptr, hdr_ptr->compiled_rules_offset, hdr_ptr->len_compiled_rules, sizeof(CompiledRule)) ||
+		check_image_section(hdr_ptr, hdr_ptr->expansion_pool_offset, hdr_ptr->len_expansion_pool, sizeof(int)) ||
+		check_image_section(hdr_ptr, hdr_ptr->first_rows_offset, len_rows, sizeof(uint64_t)) ||
+		check_image_section(hdr_ptr, hdr_ptr->follow_rows_offset, len_rows, sizeof(uint64_t)) ||
+		check_image_section(hdr_ptr, hdr_ptr->dense_parse_table_offset, (uint64_t)hdr_ptr->len_variable_symbols * hdr_ptr->len_terminal_symbols, sizeof(int))
+	)
+		return NULL;
+
+	// Tables are only read, so image may be in read only memory
+	char *base_ptr = (char *)image_ptr;
+	ParserLL1_Grammar *grm_ptr = malloc( sizeof(ParserLL1_Grammar) );
+	if(grm_ptr == NULL)
+		return NULL;
+
+	grm_ptr->variable_symbols = (int *)(base_ptr + hdr_ptr->variable_symbols_offset);
+	grm_ptr->len_variable_symbols = hdr_ptr->len_variable_symbols;
+	grm_ptr->variable_symbols_min = hdr_ptr->variable_symbols_min;
+	grm_ptr->variable_symbols_max = hdr_ptr->variable_symbols_max;
+	grm_ptr->terminal_symbols = (int *)(base_ptr + hdr_ptr->terminal_symbols_offset);
+	grm_ptr->len_terminal_symbols = hdr_ptr->len_terminal_symbols;
+	grm_ptr->terminal_symbols_min = hdr_ptr->terminal_symbols_min;
+	grm_ptr->terminal_symbols_max = hdr_ptr->terminal_symbols_max;
+	grm_ptr->symbols_min = hdr_ptr->symbols_min;
+	grm_ptr->symbols_max = hdr_ptr->symbols_max;
+	grm_ptr->symbol_attr_table = (SymbolAttr *)(base_ptr + hdr_ptr->symbol_attr_table_offset);
+	grm_ptr->start_symbol = hdr_ptr->start_symbol;
+	grm_ptr->empty_symbol = hdr_ptr->empty_symbol;
+	grm_ptr->end_symbol = hdr_ptr->end_symbol;
+	grm_ptr->forget_terminal_symbols = (int *)(base_ptr + hdr_ptr->forget_terminal_symbols_offset);
+	grm_ptr->len_forget_terminal_symbols = hdr_ptr->len_forget_terminal_symbols;
+
+	// Only needed to build tables
+	grm_ptr->rule_table = NULL;
+	grm_ptr->rule_list = NULL;
+	grm_ptr->len_rule_list = 0;
+	grm_ptr->cap_rule_list = 0;
+	grm_ptr->nullable_set = NULL;
+	grm_ptr->parse_table = NULL;
+
+	grm_ptr->dense_parse_table = (int *)(base_ptr + hdr_ptr->dense_parse_table_offset);
+	grm_ptr->compiled_rules = (CompiledRule *)(base_ptr + hdr_ptr->compiled_rules_offset);
+	grm_ptr->len_compiled_rules = hdr_ptr->len_compiled_rules;
+	grm_ptr->expansion_pool = (int *)(base_ptr + hdr_ptr->expansion_pool_offset);
+	grm_ptr->len_expansion_pool = hdr_ptr->len_expansion_pool;
+	grm_ptr->first_rows = (uint64_t *)(base_ptr + hdr_ptr->first_rows_offset);
+	grm_ptr->follow_rows = (uint64_t *)(base_ptr + hdr_ptr->follow_rows_offset);
+	grm_ptr->len_set_words = hdr_ptr->len_set_words;
+	grm_ptr->or_words = WordSet_get_or();
+
+	// Step loop indexes tables with their contents without checks
+	if( check_grammar_tables(grm_ptr) != 0 ){
+		free(grm_ptr);
+		return NULL;
+	}
+
+	// Follow from first and follow sets, not stored
+	build_sync_rows(grm_ptr);
+	if(grm_ptr->sync_rows == NULL){
+		free(grm_ptr);
+		return NULL;
+	}
+
+	grm_ptr->image_ptr = base_ptr;
+	grm_ptr->len_image = len_image;
+	grm_ptr->flag_image_mapped = 0;
+	grm_ptr->tables_ptr = NULL;
+
+	grm_ptr->token_to_symbol = token_to_symbol;
+	grm_ptr->symbol_to_string = symbol_to_string;
+	grm_ptr->token_to_value = token_to_value;
+
+	// Tables are complete, no rules can be added
+	grm_ptr->flag_rules_initialized = 1;
+
+	return grm_ptr;
+}
+
+static int write_image_section(FILE *file_ptr, uint64_t *offset_ptr, void *data, size_t len_data){
+	static const char padding[8] = {0};
+
+	if( len_data > 0 && fwrite(data, len_data, 1, file_ptr) != 1 )
+		return 1;
+	*offset_ptr += len_data;
+
+	// Align next section to 8 bytes
+	size_t len_padding = (8 - (*offset_ptr % 8)) % 8;
+	if( len_padding > 0 && fwrite(padding, len_padding, 1, file_ptr) != 1 )
+		return 1;
+	*offset_ptr += len_padding;
+
+	return 0;
+}
+
+static int check_image_section(const GrammarImageHeader *hdr_ptr, uint64_t offset, uint64_t len_elements, size_t size_element){
+	// Nonzero if section is misaligned or exceeds image
+	if(offset % 8 != 0 || offset < sizeof(GrammarImageHeader) || offset > hdr_ptr->len_image)
+		return 1;
+	if(len_elements > (hdr_ptr->len_image - offset) / size_element)
+		return 1;
+	return 0;
+}
+
+static int check_grammar_tables(ParserLL1_Grammar *grm_ptr){
+	// Nonzero if a table refers to a symbol, rule or position that does not
+	// exist. Tables are known to have the sizes given in the grammar
+	SymbolAttr *attr_tbl = grm_ptr->symbol_attr_table;
+	int symbols_min = grm_ptr->symbols_min;
+	int symbols_max = grm_ptr->symbols_max;
+	int len_variable_symbols = grm_ptr->len_variable_symbols;
+	int len_terminal_symbols = grm_ptr->len_terminal_symbols;
+
+	// Listed symbols are in range and their attributes point back to them
+	for (int i = 0; i < len_variable_symbols; ++i){
+		int symbol = grm_ptr->variable_symbols[i];
+		if(symbol < symbols_min || symbol > symbols_max)
+			return 1;
+		SymbolAttr *attr_ptr = &(attr_tbl[symbol - symbols_min]);
+		if(attr_ptr->index != i || (attr_ptr->flags & SYMBOL_FLAG_TERMINAL) != 0)
+			return 1;
+	}
+	for (int i = 0; i < len_terminal_symbols; ++i){
+		int symbol = grm_ptr->terminal_symbols[i];
+		if(symbol < symbols_min || symbol > symbols_max)
+			return 1;
+		SymbolAttr *attr_ptr = &(attr_tbl[symbol - symbols_min]);
+		if(attr_ptr->index != i || (attr_ptr->flags & SYMBOL_FLAG_TERMINAL) == 0)
+			return 1;
+	}
+	for (int i = 0; i < grm_ptr->len_forget_terminal_symbols; ++i){
+		if(grm_ptr->forget_terminal_symbols[i] < symbols_min || grm_ptr->forget_terminal_symbols[i] > symbols_max)
+			return 1;
+	}
+
+	// Any other attribute with an index is one of the listed symbols
+	for (int64_t i = 0; i <= (int64_t)symbols_max - symbols_min; ++i){
+		SymbolAttr *attr_ptr = &(attr_tbl[i]);
+		if(attr_ptr->flags & SYMBOL_FLAG_TERMINAL){
+			if(attr_ptr->index < 0 || attr_ptr->index >= len_terminal_symbols || grm_ptr->terminal_symbols[attr_ptr->index] - symbols_min != i)
+				return 1;
+		}
+		else if(attr_ptr->index != -1){
+			if(attr_ptr->index < 0 || attr_ptr->index >= len_variable_symbols || grm_ptr->variable_symbols[attr_ptr->index] - symbols_min != i)
+				return 1;
+		}
+	}
+
+	// Start symbol is a variable, end symbol a terminal
+	int special_symbols[] = {grm_ptr->start_symbol, grm_ptr->end_symbol, grm_ptr->empty_symbol};
+	for (int i = 0; i < 3; ++i){
+		if(special_symbols[i] < symbols_min || special_symbols[i] > symbols_max)
+			return 1;
+	}
+	SymbolAttr *start_attr_ptr = &(attr_tbl[grm_ptr->start_symbol - symbols_min]);
+	if(start_attr_ptr->index == -1 || (start_attr_ptr->flags & SYMBOL_FLAG_TERMINAL) != 0)
+		return 1;
+	if( (attr_tbl[grm_ptr->end_symbol - symbols_min].flags & (SYMBOL_FLAG_TERMINAL | SYMBOL_FLAG_END)) != (SYMBOL_FLAG_TERMINAL | SYMBOL_FLAG_END) )
+		return 1;
+
+	// Expansions lie in the pool, and each of their symbols is empty, a
+	// terminal or a listed variable
+	for (int i = 0; i < grm_ptr->len_compiled_rules; ++i){
+		CompiledRule *crl_ptr = &(grm_ptr->compiled_rules[i]);
+		if(crl_ptr->expansion_offset < 0 || crl_ptr->len_expansion_symbols < 0)
+			return 1;
+		if( (int64_t)crl_ptr->expansion_offset + crl_ptr->len_expansion_symbols > grm_ptr->len_expansion_pool )
+			return 1;
+	}
+	for (int i = 0; i < grm_ptr->len_expansion_pool; ++i){
+		int symbol = grm_ptr->expansion_pool[i];
+		if(symbol < symbols_min || symbol > symbols_max)
+			return 1;
+		SymbolAttr *attr_ptr = &(attr_tbl[symbol - symbols_min]);
+		if( (attr_ptr->flags & (SYMBOL_FLAG_EMPTY | SYMBOL_FLAG_TERMINAL)) == 0 && attr_ptr->index == -1 )
+			return 1;
+	}
+
+	// Parse table entries are rules or -1
+	uint64_t len_entries = (uint64_t)len_variable_symbols * len_terminal_symbols;
+	for (uint64_t i = 0; i < len_entries; ++i){
+		if(grm_ptr->dense_parse_table[i] < -1 || grm_ptr->dense_parse_table[i] >= grm_ptr->len_compiled_rules)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+////////////////////////
+// Generated grammars //
+////////////////////////
+
+ParserLL1_Grammar *ParserLL1_Grammar_from_tables(const ParserLL1_GrammarTables *tbl_ptr, int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){
+	// Arrays of nonzero length must exist
+	if(
+		tbl_ptr->len_variable_symbols <= 0 || tbl_ptr->variable_symbols == NULL ||
+		tbl_ptr->len_terminal_symbols <= 0 || tbl_ptr->terminal_symbols == NULL ||
+		tbl_ptr->len_forget_terminal_symbols < 0 || (tbl_ptr->len_forget_terminal_symbols > 0 && tbl_ptr->forget_terminal_symbols == NULL) ||
+		tbl_ptr->len_rules < 0 || (tbl_ptr->len_rules > 0 && (tbl_ptr->rule_nums == NULL || tbl_ptr->rule_variable_symbols == NULL || tbl_ptr->rule_expansion_offsets == NULL || tbl_ptr->rule_expansion_lengths == NULL)) ||
+		tbl_ptr->len_expansion_symbols < 0 || (tbl_ptr->len_expansion_symbols > 0 && tbl_ptr->expansion_symbols == NULL) ||
+		tbl_ptr->parse_table == NULL || tbl_ptr->first_rows == NULL || tbl_ptr->follow_rows == NULL
+	)
+		return NULL;
+
+	ParserLL1_Grammar *grm_ptr = malloc( sizeof(ParserLL1_Grammar) );
+	if(grm_ptr == NULL)
+		return NULL;
+
+	// Tables are only read, so they may be in read only memory
+	grm_ptr->variable_symbols = (int *)tbl_ptr->variable_symbols;
+	grm_ptr->len_variable_symbols = tbl_ptr->len_variable_symbols;
+	grm_ptr->terminal_symbols = (int *)tbl_ptr->terminal_symbols;
+	grm_ptr->len_terminal_symbols = tbl_ptr->len_terminal_symbols;
+	grm_ptr->start_symbol = tbl_ptr->start_symbol;
+	grm_ptr->empty_symbol = tbl_ptr->empty_symbol;
+	grm_ptr->end_symbol = tbl_ptr->end_symbol;
+	grm_ptr->forget_terminal_symbols = (int *)tbl_ptr->forget_terminal_symbols;
+	grm_ptr->len_forget_terminal_symbols = tbl_ptr->len_forget_terminal_symbols;
+
+	// Only needed to build tables
+	grm_ptr->rule_table = NULL;
+	grm_ptr->rule_list = NULL;
+	grm_ptr->len_rule_list = 0;
+	grm_ptr->cap_rule_list = 0;
+	grm_ptr->nullable_set = NULL;
+	grm_ptr->parse_table = NULL;
+
+	grm_ptr->dense_parse_table = (int *)tbl_ptr->parse_table;
+	grm_ptr->expansion_pool = (int *)tbl_ptr->expansion_symbols;
+	grm_ptr->len_expansion_pool = tbl_ptr->len_expansion_symbols;
+	grm_ptr->first_rows = (uint64_t *)tbl_ptr->first_rows;
+	grm_ptr->follow_rows = (uint64_t *)tbl_ptr->follow_rows;
+	grm_ptr->len_set_words = (tbl_ptr->len_terminal_symbols + 63) / 64;
+	grm_ptr->or_words = WordSet_get_or();
+
+	grm_ptr->image_ptr = NULL;
+	grm_ptr->len_image = 0;
+	grm_ptr->flag_image_mapped = 0;
+	grm_ptr->tables_ptr = tbl_ptr;
+
+	grm_ptr->token_to_symbol = token_to_symbol;
+	grm_ptr->symbol_to_string = symbol_to_string;
+	grm_ptr->token_to_value = token_to_value;
+
+	// Tables are complete, no rules can be added
+	grm_ptr->flag_rules_initialized = 1;
+
+	// Freed on failure by ParserLL1_Grammar_destroy
+	grm_ptr->symbol_attr_table = NULL;
+	grm_ptr->compiled_rules = NULL;
+	grm_ptr->len_compiled_rules = tbl_ptr->len_rules;
+	grm_ptr->sync_rows = NULL;
+
+	calculate_symbol_ranges(grm_ptr);
+	if( check_special_symbols(grm_ptr) != 0 ){
+		ParserLL1_Grammar_destroy(grm_ptr);
+		return NULL;
+	}
+
+	// Nullable flags are not needed while parsing
+	grm_ptr->symbol_attr_table = new_symbol_attr_table(grm_ptr);
+
+	grm_ptr->compiled_rules = malloc( sizeof(CompiledRule) * (tbl_ptr->len_rules > 0 ? tbl_ptr->len_rules : 1) );
+	for (int i = 0; i < tbl_ptr->len_rules; ++i){
+		grm_ptr->compiled_rules[i].rule_num = tbl_ptr->rule_nums[i];
+		grm_ptr->compiled_rules[i].variable_symbol = tbl_ptr->rule_variable_symbols[i];
+		grm_ptr->compiled_rules[i].expansion_offset = tbl_ptr->rule_expansion_offsets[i];
+		grm_ptr->compiled_rules[i].len_expansion_symbols = tbl_ptr->rule_expansion_lengths[i];
+	}
+
+	// Step loop indexes tables with their contents without checks
+	if( check_grammar_tables(grm_ptr) != 0 ){
+		ParserLL1_Grammar_destroy(grm_ptr);
+		return NULL;
+	}
+
+	build_sync_rows(grm_ptr);
+	if(grm_ptr->sync_rows == NULL){
+		ParserLL1_Grammar_destroy(grm_ptr);
+		return NULL;
+	}
+
+	return grm_ptr;
+}
+
+int ParserLL1_Grammar_generate_c(ParserLL1_Grammar *grm_ptr, const char *path, const char *name){
+	if(grm_ptr->flag_rules_initialized == 0 || grm_ptr->dense_parse_table == NULL)
+		return -1;
+
+	FILE *file_ptr = fopen(path, "w");
+	if(file_ptr == NULL)
+		return -1;
+
+	fprintf(file_ptr, "// Generated by ParserLL1_Grammar_generate_c, do not edit\n");
+	fprintf(file_ptr, "//\n");
+	fprintf(file_ptr, "// Declare in user code as:\n");
+	fprintf(file_ptr, "// ParserLL1_Grammar *%s_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));\n", name);
+	fprintf(file_ptr, "// Parser_StepResult_type %s_step(ParserLL1 *psr_ptr, Token *tkn_ptr);\n", name);
+	fprintf(file_ptr, "// Parser_StepResult_type %s_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);\n", name);
+	fprintf(file_ptr, "//\n");
+	fprintf(file_ptr, "// Build with the headers of the ParserLL1 library it is linked with, and with\n");
+	fprintf(file_ptr, "// PARSERLL1_STATS defined if the library is. Define\n");
+	fprintf(file_ptr, "// PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptr) to replace calls to the\n");
+	fprintf(file_ptr, "// token_to_symbol callback by the same mapping written inline\n\n");
+	fprintf(file_ptr, "#include <stdint.h>\n\n");
+	fprintf(file_ptr, "#include \"ParserLL1.h\"\n");
+	fprintf(file_ptr, "#include \"ParserLL1_internal.h\"\n\n");
+
+	// List rules for readers of the generated file
+	fprintf(file_ptr, "// Rules:\n");
+	for (int i = 0; i < grm_ptr->len_compiled_rules; ++i){
+		fprintf(file_ptr, "// %d: ", grm_ptr->compiled_rules[i].rule_num);
+		write_rule(grm_ptr, file_ptr, &(grm_ptr->compiled_rules[i]));
+		fprintf(file_ptr, "\n");
+	}
+
+	// Split compiled rules into one array per field
+	int len_rules = grm_ptr->len_compiled_rules;
+	int *rule_fields = malloc( sizeof(int) * 4 * (len_rules > 0 ? len_rules : 1) );
+	if(rule_fields == NULL){
+		fclose(file_ptr);
+		return -1;
+	}
+	for (int i = 0; i < len_rules; ++i){
+		rule_fields[i] = grm_ptr->compiled_rules[i].rule_num;
+		rule_fields[len_rules + i] = grm_ptr->compiled_rules[i].variable_symbol;
+		rule_fields[2 * len_rules + i] = grm_ptr->compiled_rules[i].expansion_offset;
+		rule_fields[3 * len_rules + i] = grm_ptr->compiled_rules[i].len_expansion_symbols;
+	}
+
+	size_t len_rows = (size_t)grm_ptr->len_variable_symbols * grm_ptr->len_set_words;
+
+	write_int_array(file_ptr, name, "variable_symbols", grm_ptr->variable_symbols, grm_ptr->len_variable_symbols);
+	write_int_array(file_ptr, name, "terminal_symbols", grm_ptr->terminal_symbols, grm_ptr->len_terminal_symbols);
+	write_int_array(file_ptr, name, "forget_terminal_symbols", grm_ptr->forget_terminal_symbols, grm_ptr->len_forget_terminal_symbols);
+	write_int_array(file_ptr, name, "rule_nums", rule_fields, len_rules);
+	write_int_array(file_ptr, name, "rule_variable_symbols", rule_fields + len_rules, len_rules);
+	write_int_array(file_ptr, name, "rule_expansion_offsets", rule_fields + 2 * len_rules, len_rules);
+	write_int_array(file_ptr, name, "rule_expansion_lengths", rule_fields + 3 * len_rules, len_rules);
+	write_int_array(file_ptr, name, "expansion_symbols", grm_ptr->expansion_pool, grm_ptr->len_expansion_pool);
+	write_int_array(file_ptr, name, "parse_table", grm_ptr->dense_parse_table, grm_ptr->len_variable_symbols * grm_ptr->len_terminal_symbols);
+	write_word_array(file_ptr, name, "first_rows", grm_ptr->first_rows, len_rows);
+	write_word_array(file_ptr, name, "follow_rows", grm_ptr->follow_rows, len_rows);
+
+	free(rule_fields);
+
+	fprintf(file_ptr, "\nstatic const ParserLL1_GrammarTables %s_tables = {\n", name);
+	write_table_field(file_ptr, name, "variable_symbols", grm_ptr->len_variable_symbols);
+	fprintf(file_ptr, "\t.len_variable_symbols = %d,\n", grm_ptr->len_variable_symbols);
+	write_table_field(file_ptr, name, "terminal_symbols", grm_ptr->len_terminal_symbols);
+	fprintf(file_ptr, "\t.len_terminal_symbols = %d,\n", grm_ptr->len_terminal_symbols);
+	fprintf(file_ptr, "\t.start_symbol = %d,\n", grm_ptr->start_symbol);
+	fprintf(file_ptr, "\t.empty_symbol = %d,\n", grm_ptr->empty_symbol);
+	fprintf(file_ptr, "\t.end_symbol = %d,\n", grm_ptr->end_symbol);
+	write_table_field(file_ptr, name, "forget_terminal_symbols", grm_ptr->len_forget_terminal_symbols);
+	fprintf(file_ptr, "\t.len_forget_terminal_symbols = %d,\n", grm_ptr->len_forget_terminal_symbols);
+	write_table_field(file_ptr, name, "rule_nums", len_rules);
+	write_table_field(file_ptr, name, "rule_variable_symbols", len_rules);
+	write_table_field(file_ptr, name, "rule_expansion_offsets", len_rules);
+	write_table_field(file_ptr, name, "rule_expansion_lengths", len_rules);
+	fprintf(file_ptr, "\t.len_rules = %d,\n", len_rules);
+	write_table_field(file_ptr, name, "expansion_symbols", grm_ptr->len_expansion_pool);
+	fprintf(file_ptr, "\t.len_expansion_symbols = %d,\n", grm_ptr->len_expansion_pool);
+	write_table_field(file_ptr, name, "parse_table", grm_ptr->len_variable_symbols * grm_ptr->len_terminal_symbols);
+	write_table_field(file_ptr, name, "first_rows", (int)len_rows);
+	write_table_field(file_ptr, name, "follow_rows", (int)len_rows);
+	fprintf(file_ptr, "};\n\n");
+
+	fprintf(file_ptr, "ParserLL1_Grammar *%s_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int)){\n", name);
+	fprintf(file_ptr, "\treturn ParserLL1_Grammar_from_tables(&%s_tables, token_to_symbol, symbol_to_string, token_to_value);\n", name);
+	fprintf(file_ptr, "}\n");
+
+	write_step_symbol(grm_ptr, file_ptr, name);
+	write_entry_points(file_ptr, name);
+
+	int flag_failed = 0;
+	if( ferror(file_ptr) )
+		flag_failed = 1;
+	if( fclose(file_ptr) != 0 )
+		flag_failed = 1;
+
+	return flag_failed ? -1 : 0;
+}
+
+static void write_int_array(FILE *file_ptr, const char *name, const char *suffix, const int *values, int len_values){
+	// Empty arrays are not valid C
+	if(len_values <= 0)
+		return;
+
+	fprintf(file_ptr, "\nstatic const int %s_%s[%d] = {", name, suffix, len_values);
+	for (int i = 0; i < len_values; ++i){
+		if(i % 16 == 0)
+			fprintf(file_ptr, "\n\t");
+		fprintf(file_ptr, "%d,%s", values[i], (i % 16 == 15 || i == len_values - 1) ? "" : " ");
+	}
+	fprintf(file_ptr, "\n};\n");
+}
+
+static void write_table_field(FILE *file_ptr, const char *name, const char *field, int len_values){
+	// Arrays are named after their field, and empty ones are not written
+	if(len_values > 0)
+		fprintf(file_ptr, "\t.%s = %s_%s,\n", field, name, field);
+	else
+		fprintf(file_ptr, "\t.%s = NULL,\n", field);
+}
+
+static void write_word_array(FILE *file_ptr, const char *name, const char *suffix, const uint64_t *words, size_t len_words){
+	if(len_words == 0)
+		return;
+
+	// Words are values, so they are the same in any byte order
+	fprintf(file_ptr, "\nstatic const uint64_t %s_%s[%zu] = {", name, suffix, len_words);
+	for (size_t i = 0; i < len_words; ++i){
+		if(i % 4 == 0)
+			fprintf(file_ptr, "\n\t");
+		fprintf(file_ptr, "UINT64_C(0x%016llx),%s", (unsigned long long) words[i], (i % 4 == 3 || i == len_words - 1) ? "" : " ");
+	}
+	fprintf(file_ptr, "\n};\n");
+}
+
+static void write_step_symbol(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, const char *name){
+	// Same steps as step_symbol, with the symbol attributes, parse table and
+	// rule expansions of the grammar written as switches and constants
+	int len_terminal_symbols = grm_ptr->len_terminal_symbols;
+
+	fprintf(file_ptr, "\n#ifndef PARSERLL1_TOKEN_TO_SYMBOL\n");
+	fprintf(file_ptr, "#define PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptr) ((psr_ptr)->grm_ptr->token_to_symbol(tkn_ptr))\n");
+	fprintf(file_ptr, "#endif\n");
+
+	fprintf(file_ptr, "\nstatic inline Parser_StepResult_type %s_step_symbol(ParserLL1 *psr_ptr, int lookahead_symbol, Token *tkn_ptr){\n", name);
+	fprintf(file_ptr, "\tParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;\n");
+	fprintf(file_ptr, "\tParser_StepResult_type result;\n");
+	fprintf(file_ptr, "\tvoid *parent_node_ptr;\n\n");
+	fprintf(file_ptr, "\tpsr_ptr->num_tokens++;\n");
+	fprintf(file_ptr, "\tSTATS_ADD(psr_ptr, tokens_consumed, 1);\n\n");
+
+	// Lookahead must be a terminal
+	fprintf(file_ptr, "\tswitch(lookahead_symbol){\n");
+	for (int i = 0; i < len_terminal_symbols; ++i)
+		fprintf(file_ptr, "\tcase %d:\n", grm_ptr->terminal_symbols[i]);
+	fprintf(file_ptr, "\t\tbreak;\n");
+	fprintf(file_ptr, "\tdefault:\n");
+	fprintf(file_ptr, "\t\treturn step_unknown_input(psr_ptr, tkn_ptr);\n");
+	fprintf(file_ptr, "\t}\n\n");
+
+	fprintf(file_ptr, "\twhile(1){\n");
+	fprintf(file_ptr, "\t\tif(psr_ptr->len_stack == 0)\n");
+	fprintf(file_ptr, "\t\t\treturn step_halted(psr_ptr, tkn_ptr);\n\n");
+	fprintf(file_ptr, "\t\tStackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);\n");
+	fprintf(file_ptr, "\t\tif(top_ent_ptr->symbol_index == STACK_ENTRY_EXIT){\n");
+	fprintf(file_ptr, "\t\t\tstep_exit(psr_ptr, top_ent_ptr);\n");
+	fprintf(file_ptr, "\t\t\tcontinue;\n");
+	fprintf(file_ptr, "\t\t}\n\n");
+	fprintf(file_ptr, "\t\tswitch(top_ent_ptr->symbol){\n");
+
+	// Terminals on top match the lookahead or are handled as errors
+	for (int i = 0; i < len_terminal_symbols; ++i){
+		int symbol = grm_ptr->terminal_symbols[i];
+		int flags = grm_ptr->symbol_attr_table[symbol - grm_ptr->symbols_min].flags;
+
+		fprintf(file_ptr, "\t\tcase %d: // ", symbol);
+		write_symbol_name(grm_ptr, file_ptr, symbol);
+		fprintf(file_ptr, "\n");
+		fprintf(file_ptr, "\t\t\tif(lookahead_symbol == %d)\n", symbol);
+		if(flags & SYMBOL_FLAG_END)
+			fprintf(file_ptr, "\t\t\t\treturn ParserLL1_step_end(psr_ptr, tkn_ptr);\n");
+		else
+			fprintf(file_ptr, "\t\t\t\treturn step_match(psr_ptr, top_ent_ptr, tkn_ptr);\n");
+		fprintf(file_ptr, "\t\t\tif( ParserLL1_step_mismatch(psr_ptr, ");
+		write_symbol_flags(file_ptr, flags);
+		fprintf(file_ptr, ", tkn_ptr, &result) == 0 )\n");
+		fprintf(file_ptr, "\t\t\t\treturn result;\n");
+		fprintf(file_ptr, "\t\t\tcontinue;\n");
+	}
+
+	// Variables on top expand by the rule in their parse table row, cases
+	// for the same rule are grouped
+	int *flags_written = malloc( sizeof(int) * len_terminal_symbols );
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i){
+		int symbol = grm_ptr->variable_symbols[i];
+		if(symbol == grm_ptr->empty_symbol)
+			continue;
+
+		int *row = grm_ptr->dense_parse_table + (size_t)i * len_terminal_symbols;
+
+		fprintf(file_ptr, "\t\tcase %d: // ", symbol);
+		write_symbol_name(grm_ptr, file_ptr, symbol);
+		fprintf(file_ptr, "\n");
+		fprintf(file_ptr, "\t\t\tswitch(lookahead_symbol){\n");
+
+		memset(flags_written, 0, sizeof(int) * len_terminal_symbols);
+		for (int j = 0; j < len_terminal_symbols; ++j){
+			int rule_index = row[j];
+			if(rule_index == -1 || flags_written[j] == 1)
+				continue;
+
+			for (int k = j; k < len_terminal_symbols; ++k){
+				if(row[k] == rule_index){
+					fprintf(file_ptr, "\t\t\tcase %d:\n", grm_ptr->terminal_symbols[k]);
+					flags_written[k] = 1;
+				}
+			}
+
+			CompiledRule *crl_ptr = &(grm_ptr->compiled_rules[rule_index]);
+			fprintf(file_ptr, "\t\t\t\t// ");
+			write_rule(grm_ptr, file_ptr, crl_ptr);
+			fprintf(file_ptr, "\n");
+			fprintf(file_ptr, "\t\t\t\tif( psr_ptr->flag_limits == 1 && ParserLL1_expansion_exceeds_limits(psr_ptr, &(grm_ptr->compiled_rules[%d])) )\n", rule_index);
+			fprintf(file_ptr, "\t\t\t\t\treturn stop_parsing(psr_ptr, tkn_ptr, PARSER_STEP_RESULT_LIMIT_EXCEEDED);\n");
+
+			// Children pushed in reverse, no need to push empty symbol
+			int len_pushed = 0;
+			int *expansion_symbols = grm_ptr->expansion_pool + crl_ptr->expansion_offset;
+			for (int k = crl_ptr->len_expansion_symbols - 1; k >= 0; --k){
+				if(grm_ptr->symbol_attr_table[expansion_symbols[k] - grm_ptr->symbols_min].flags & SYMBOL_FLAG_EMPTY)
+					continue;
+
+				if(len_pushed == 0)
+					fprintf(file_ptr, "\t\t\t\tparent_node_ptr = step_expand(psr_ptr, top_ent_ptr, %d, %d);\n", crl_ptr->rule_num, rule_index);
+				fprintf(file_ptr, "\t\t\t\tstep_push_child(psr_ptr, parent_node_ptr, %d, %d);\n", expansion_symbols[k], k);
+				len_pushed++;
+			}
+			if(len_pushed == 0){
+				fprintf(file_ptr, "\t\t\t\tstep_expand(psr_ptr, top_ent_ptr, %d, %d);\n", crl_ptr->rule_num, rule_index);
+				fprintf(file_ptr, "\t\t\t\tSTATS_ADD(psr_ptr, epsilon_expansions, 1);\n");
+			}
+			fprintf(file_ptr, "\t\t\t\tcontinue;\n");
+		}
+
+		fprintf(file_ptr, "\t\t\t}\n");
+		fprintf(file_ptr, "\t\t\tif( ParserLL1_step_no_rule(psr_ptr, lookahead_symbol, tkn_ptr, &result) == 0 )\n");
+		fprintf(file_ptr, "\t\t\t\treturn result;\n");
+		fprintf(file_ptr, "\t\t\tcontinue;\n");
+	}
+	free(flags_written);
+
+	fprintf(file_ptr, "\t\t}\n");
+	fprintf(file_ptr, "\t}\n");
+	fprintf(file_ptr, "}\n");
+}
+
+static void write_symbol_flags(FILE *file_ptr, int flags){
+	// Only the flags mismatches depend on
+	fprintf(file_ptr, "SYMBOL_FLAG_TERMINAL");
+	if(flags & SYMBOL_FLAG_FORGET)
+		fprintf(file_ptr, " | SYMBOL_FLAG_FORGET");
+	if(flags & SYMBOL_FLAG_END)
+		fprintf(file_ptr, " | SYMBOL_FLAG_END");
+}
+
+static void write_entry_points(FILE *file_ptr, const char *name){
+	// Parsers of other grammars, and parsers in incremental mode, which keep
+	// every token, go through the library
+	const char *check = "\tif(psr_ptr->grm_ptr->tables_ptr != &%s_tables || psr_ptr->flag_incremental_mode == 1)\n";
+
+	fprintf(file_ptr, "\nParser_StepResult_type %s_step(ParserLL1 *psr_ptr, Token *tkn_ptr){\n", name);
+	fprintf(file_ptr, check, name);
+	fprintf(file_ptr, "\t\treturn ParserLL1_step(psr_ptr, tkn_ptr);\n\n");
+	fprintf(file_ptr, "\treturn %s_step_symbol(psr_ptr, PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptr), tkn_ptr);\n", name);
+	fprintf(file_ptr, "}\n");
+
+	fprintf(file_ptr, "\nParser_StepResult_type %s_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index){\n", name);
+	fprintf(file_ptr, check, name);
+	fprintf(file_ptr, "\t\treturn ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_tkn_ptrs, stop_index);\n\n");
+	fprintf(file_ptr, "\tParser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;\n\n");
+	fprintf(file_ptr, "\tint i = 0;\n");
+	fprintf(file_ptr, "\twhile(i < len_tkn_ptrs){\n");
+	fprintf(file_ptr, "\t\tif(psr_ptr->flag_error_recovery == 1){\n");
+	fprintf(file_ptr, "\t\t\tint len_skipped = ParserLL1_skip_recovery_tokens(psr_ptr, tkn_ptrs + i, len_tkn_ptrs - i);\n");
+	fprintf(file_ptr, "\t\t\tif(len_skipped > 0){\n");
+	fprintf(file_ptr, "\t\t\t\ti += len_skipped;\n");
+	fprintf(file_ptr, "\t\t\t\tresult = PARSER_STEP_RESULT_FAIL;\n");
+	fprintf(file_ptr, "\t\t\t\tcontinue;\n");
+	fprintf(file_ptr, "\t\t\t}\n");
+	fprintf(file_ptr, "\t\t}\n\n");
+	fprintf(file_ptr, "\t\tresult = %s_step_symbol(psr_ptr, PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptrs[i]), tkn_ptrs[i]);\n", name);
+	fprintf(file_ptr, "\t\ti++;\n\n");
+	fprintf(file_ptr, "\t\tif(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED)\n");
+	fprintf(file_ptr, "\t\t\tbreak;\n");
+	fprintf(file_ptr, "\t}\n\n");
+	fprintf(file_ptr, "\tif(stop_index != NULL)\n");
+	fprintf(file_ptr, "\t\t*stop_index = i;\n\n");
+	fprintf(file_ptr, "\treturn result;\n");
+	fprintf(file_ptr, "}\n");
+}
+
+static void write_rule(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, CompiledRule *crl_ptr){
+	write_symbol_name(grm_ptr, file_ptr, crl_ptr->variable_symbol);
+	fprintf(file_ptr, " ->");
+	for (int i = 0; i < crl_ptr->len_expansion_symbols; ++i){
+		fprintf(file_ptr, " ");
+		write_symbol_name(grm_ptr, file_ptr, grm_ptr->expansion_pool[crl_ptr->expansion_offset + i]);
+	}
+}
+
+static void write_symbol_name(ParserLL1_Grammar *grm_ptr, FILE *file_ptr, int symbol){
+	char *name = grm_ptr->symbol_to_string(symbol);
+
+	// Keep comment on one line whatever the name contains
+	if(name == NULL || strpbrk(name, "\r\n") != NULL)
+		fprintf(file_ptr, "%d", symbol);
+	else
+		fprintf(file_ptr, "%s", name);
+}
+
+
+/////////
+// Run //
+/////////
+
+Parser_StepResult_type ParserLL1_step(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	return step(psr_ptr, tkn_ptr);
+}
+
+Parser_StepResult_type ParserLL1_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index){
+	Parser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;
+
+	int i = 0;
+	while(i < len_tkn_ptrs){
+		if(psr_ptr->flag_error_recovery == 1){
+			// Discard tokens error recovery would skip in one pass
+			int len_skipped = skip_recovery_input(psr_ptr, tkn_ptrs + i, NULL, len_tkn_ptrs - i);
+			if(len_skipped > 0){
+				i += len_skipped;
+				result = PARSER_STEP_RESULT_FAIL;
+				continue;
+			}
+		}
+
+		result = step(psr_ptr, tkn_ptrs[i]);
+		i++;
+
+		if(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED){
+			// Parsing over, or caller needs to handle input
+			break;
+		}
+	}
+
+	if(stop_index != NULL)
+		*stop_index = i;
+
+	return result;
+}
+
+Parser_StepResult_type ParserLL1_parse_records(ParserLL1 *psr_ptr, const ParserLL1_TokenRecord *records, int len_records, const char *source, int *stop_index){
+	if(psr_ptr->flag_arena_mode == 0 && psr_ptr->flag_event_mode == 0){
+		// ParseTree nodes have no place for the record position
+		if(stop_index != NULL)
+			*stop_index = 0;
+		return PARSER_STEP_RESULT_FAIL;
+	}
+
+	if(psr_ptr->flag_incremental_mode == 1){
+		// Input must be kept as tokens for reparsing
+		if(stop_index != NULL)
+			*stop_index = 0;
+		return PARSER_STEP_RESULT_FAIL;
+	}
+
+	Parser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;
+	psr_ptr->record_source = source;
+
+	int i = 0;
+	while(i < len_records){
+		if(psr_ptr->flag_error_recovery == 1){
+			// Discard records error recovery would skip in one pass
+			int len_skipped = skip_recovery_input(psr_ptr, NULL, records + i, len_records - i);
+			if(len_skipped > 0){
+				i += len_skipped;
+				result = PARSER_STEP_RESULT_FAIL;
+				continue;
+			}
+		}
+
+		// Only read when recording an error
+		psr_ptr->record_ptr = &(records[i]);
+		result = step_symbol(psr_ptr, records[i].symbol, NULL);
+		i++;
+
+		if(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED){
+			// Parsing over, or caller needs to handle input
+			break;
+		}
+	}
+
+	// Records are not kept after returning
+	psr_ptr->record_ptr = NULL;
+	psr_ptr->record_source = NULL;
+
+	if(stop_index != NULL)
+		*stop_index = i;
+
+	return result;
+}
+
+Parser_StepResult_type ParserLL1_run(ParserLL1 *psr_ptr, int (*next_tokens)(void *, Token **, int), void *ctx){
+	if(psr_ptr->run_buffer == NULL){
+		if( psr_ptr->flag_limits == 1 && growth_exceeds_memory_limit(psr_ptr, sizeof(Token *) * PARSERLL1_RUN_CHUNK_SIZE) ){
+			// No token pulled yet, stop as stop_parsing would
+			psr_ptr->len_stack = 0;
+			psr_ptr->flag_halted = 1;
+			return PARSER_STEP_RESULT_LIMIT_EXCEEDED;
+		}
+		psr_ptr->run_buffer = malloc( sizeof(Token *) * PARSERLL1_RUN_CHUNK_SIZE );
+	}
+
+	while(1){
+		if(psr_ptr->pos_run_buffer == psr_ptr->len_run_buffer){
+			// Buffer used up, pull next chunk
+			psr_ptr->pos_run_buffer = 0;
+			psr_ptr->len_run_buffer = next_tokens(ctx, psr_ptr->run_buffer, PARSERLL1_RUN_CHUNK_SIZE);
+
+			if(psr_ptr->len_run_buffer <= 0){
+				// Source exhausted for now
+				psr_ptr->len_run_buffer = 0;
+				return PARSER_STEP_RESULT_MORE_INPUT;
+			}
+		}
+
+		if(psr_ptr->flag_error_recovery == 1){
+			// Discard tokens error recovery would skip in one pass. No
+			// errors are recorded for them
+			psr_ptr->pos_run_buffer += skip_recovery_input(psr_ptr, psr_ptr->run_buffer + psr_ptr->pos_run_buffer, NULL, psr_ptr->len_run_buffer - psr_ptr->pos_run_buffer);
+			if(psr_ptr->pos_run_buffer == psr_ptr->len_run_buffer)
+				continue;
+		}
+
+		Parser_StepResult_type result = step(psr_ptr, psr_ptr->run_buffer[psr_ptr->pos_run_buffer++]);
+
+		if(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED){
+			// Parsing over, or caller needs to handle input
+			return result;
+		}
+	}
+}
+
+static inline Parser_StepResult_type step(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	if(psr_ptr->flag_incremental_mode == 1){
+		// Input records double when full
+		int cap_input_records = psr_ptr->cap_input_records > 0 ? psr_ptr->cap_input_records : PARSERLL1_INITIAL_STACK_SIZE;
+		if( psr_ptr->flag_limits == 1 && psr_ptr->num_tokens == psr_ptr->cap_input_records && growth_exceeds_memory_limit(psr_ptr, sizeof(InputRecord) * cap_input_records) ){
+			// Token is not kept in input
+			if(psr_ptr->flag_borrowed_tokens == 0)
+				Token_destroy(tkn_ptr);
+			if(psr_ptr->flag_halted == 1)
+				return PARSER_STEP_RESULT_HALTED;
+			return stop_parsing(psr_ptr, NULL, PARSER_STEP_RESULT_LIMIT_EXCEEDED);
+		}
+
+		record_input_token(psr_ptr, tkn_ptr);
+	}
+
+	return step_symbol(psr_ptr, psr_ptr->grm_ptr->token_to_symbol(tkn_ptr), tkn_ptr);
+}
+
+static inline Parser_StepResult_type step_symbol(ParserLL1 *psr_ptr, int lookahead_symbol, Token *tkn_ptr){
+	// tkn_ptr is NULL if input is given as records. Cases other than matches
+	// and expansions are in functions shared with generated parsers
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+	Parser_StepResult_type result;
+
+	psr_ptr->num_tokens++;
+	STATS_ADD(psr_ptr, tokens_consumed, 1);
+
+	// Check if symbol is valid terminal
+	if( (get_symbol_flags(grm_ptr, lookahead_symbol) & SYMBOL_FLAG_TERMINAL) == 0 )
+		return step_unknown_input(psr_ptr, tkn_ptr);
+
 	while(1){
 		// Loop until top of the stack is a terminal
 
-		ParseTree_Node *top_node_ptr = LinkedList_peek(psr_ptr->stack);
+		if(psr_ptr->len_stack == 0)
+			return step_halted(psr_ptr, tkn_ptr);
+
+		StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+		int top_symbol = top_ent_ptr->symbol;
+
+		if(top_ent_ptr->symbol_index == STACK_ENTRY_EXIT){
+			step_exit(psr_ptr, top_ent_ptr);
+			continue;
+		}
+
+		// Symbols on stack are always known
+		int top_symbol_flags = grm_ptr->symbol_attr_table[top_symbol - grm_ptr->symbols_min].flags;
+
+		if( top_symbol_flags & SYMBOL_FLAG_TERMINAL ){
+			// Top of the stack is a terminal
+
+			if(lookahead_symbol == top_symbol){
+				if( top_symbol_flags & SYMBOL_FLAG_END )
+					return ParserLL1_step_end(psr_ptr, tkn_ptr);
+				return step_match(psr_ptr, top_ent_ptr, tkn_ptr);
+			}
+
+			if( ParserLL1_step_mismatch(psr_ptr, top_symbol_flags, tkn_ptr, &result) == 0 )
+				return result;
+		}
+
+		else{
+			// Top of stack is non terminal, need to expand
+
+			// Get the rule corresponding to top symbol and lookahead
+			int rule_index = get_parse_table_entry(grm_ptr, top_symbol, lookahead_symbol);
+
+			if(rule_index == -1){
+				if( ParserLL1_step_no_rule(psr_ptr, lookahead_symbol, tkn_ptr, &result) == 0 )
+					return result;
+				continue;
+			}
+
+			CompiledRule *crl_ptr = &(grm_ptr->compiled_rules[rule_index]);
+			if( psr_ptr->flag_limits == 1 && ParserLL1_expansion_exceeds_limits(psr_ptr, crl_ptr) )
+				return stop_parsing(psr_ptr, tkn_ptr, PARSER_STEP_RESULT_LIMIT_EXCEEDED);
+
+			void *parent_node_ptr = step_expand(psr_ptr, top_ent_ptr, crl_ptr->rule_num, rule_index);
+#ifdef PARSERLL1_STATS
+			int len_stack_before_expansion = psr_ptr->len_stack;
+#endif
+
+			// Traverse rule list in reverse
+			int *expansion_symbols = grm_ptr->expansion_pool + crl_ptr->expansion_offset;
+			for (int i = crl_ptr->len_expansion_symbols - 1; i >= 0; --i){
+				int expansion_symbol = expansion_symbols[i];
+
+				// No need to push empty symbol onto stack
+				if( (grm_ptr->symbol_attr_table[expansion_symbol - grm_ptr->symbols_min].flags & SYMBOL_FLAG_EMPTY) == 0 )
+					step_push_child(psr_ptr, parent_node_ptr, expansion_symbol, i);
+			}
+
+#ifdef PARSERLL1_STATS
+			// Nothing pushed if rule expands to empty symbol only
+			if(psr_ptr->len_stack == len_stack_before_expansion)
+				psr_ptr->stats.epsilon_expansions++;
+#endif
+		}
+	}
+}
+
+
+///////////
+// Steps //
+///////////
+
+Parser_StepResult_type ParserLL1_step_end(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	// This step was successful
+	psr_ptr->flag_error_recovery = 0;
+	STATS_ADD(psr_ptr, terminal_matches, 1);
+
+	// End symbol has no node, token does not belong to tree
+	discard_token(psr_ptr, tkn_ptr);
+	psr_ptr->len_stack--;
+
+	if(psr_ptr->flag_incremental_mode == 1)
+		psr_ptr->end_token_index = psr_ptr->num_tokens - 1;
+
+	// User can access parse tree now
+	psr_ptr->flag_halted = 1;
+
+	if(psr_ptr->flag_errors_found == 0){
+		// Return success only if no errors were detected
+		return PARSER_STEP_RESULT_SUCCESS;
+	}
+	else{
+		return PARSER_STEP_RESULT_HALTED;
+	}
+}
+
+int ParserLL1_step_mismatch(ParserLL1 *psr_ptr, int top_symbol_flags, Token *tkn_ptr, Parser_StepResult_type *result_ptr){
+	// Parsing error, lookahead does not match top of stack
+	StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+	int top_symbol = top_ent_ptr->symbol;
+
+	psr_ptr->flag_errors_found = 1;
+
+	if( (top_symbol_flags & SYMBOL_FLAG_FORGET) == 0 ){
+		// Pop the top, if it is not end symbol, and discard lookahead as if
+		// they had matched.
+
+		if( (top_symbol_flags & SYMBOL_FLAG_END) == 0 ){
+			// No need to free popped node, as it is not end symbol
+			node_skip(psr_ptr, top_ent_ptr);
+			psr_ptr->len_stack--;
+		}
+
+		if(psr_ptr->flag_error_recovery == 1){
+			// Error recovery active, not need to record error
+		}
+
+		else{
+			// Enable error recovery and record error
+			psr_ptr->flag_error_recovery = 1;
+			if( add_error(psr_ptr, tkn_ptr, top_symbol) == 1 ){
+				*result_ptr = stop_parsing(psr_ptr, tkn_ptr, PARSER_STEP_RESULT_MAX_ERRORS);
+				return 0;
+			}
+		}
+
+		// Discard token
+		discard_token(psr_ptr, tkn_ptr);
+		STATS_ADD(psr_ptr, tokens_discarded, 1);
+
+		*result_ptr = PARSER_STEP_RESULT_FAIL;
+		return 0;
+	}
+
+	else{
+		// Assume user wanted to put the top before lookahead here. Pop top as
+		// if match was found before lookahead. Continue to search a match
+		// for lookahead
+
+		// No need to free popped node
+		node_skip(psr_ptr, top_ent_ptr);
+		psr_ptr->len_stack--;
+
+		// Disable error recovery, as action taken
+		psr_ptr->flag_error_recovery = 0;
+
+		if( add_error(psr_ptr, tkn_ptr, top_symbol) == 1 ){
+			*result_ptr = stop_parsing(psr_ptr, tkn_ptr, PARSER_STEP_RESULT_MAX_ERRORS);
+			return 0;
+		}
+
+		// Continue to search for a match
+		return 1;
+	}
+}
+
+int ParserLL1_step_no_rule(ParserLL1 *psr_ptr, int lookahead_symbol, Token *tkn_ptr, Parser_StepResult_type *result_ptr){
+	// Parsing error, no entry in parse table
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+	StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+	int top_symbol = top_ent_ptr->symbol;
+
+	psr_ptr->flag_errors_found = 1;
+
+	if(psr_ptr->flag_error_recovery == 1){
+		// Error recovery is active, do not record additional error
+		// No need to destroy token
+	}
+	else{
+		// Enable error recovery and record error
+		psr_ptr->flag_error_recovery = 1;
+		if( add_error(psr_ptr, tkn_ptr, top_symbol) == 1 ){
+			*result_ptr = stop_parsing(psr_ptr, tkn_ptr, PARSER_STEP_RESULT_MAX_ERRORS);
+			return 0;
+		}
+	}
+
+	// Try to recover
+	// Check if input is in follow set of top symbol
+
+	uint64_t *top_follow_row_ptr = grm_ptr->follow_rows + grm_ptr->symbol_attr_table[top_symbol - grm_ptr->symbols_min].index * grm_ptr->len_set_words;
+	int lookahead_index = grm_ptr->symbol_attr_table[lookahead_symbol - grm_ptr->symbols_min].index;
+
+	if( set_get_bit(top_follow_row_ptr, lookahead_index) == 1 ){
+		// Pop the top symbol. No need to free
+		node_skip(psr_ptr, top_ent_ptr);
+		psr_ptr->len_stack--;
+		// Disable error recovery as action taken
+		psr_ptr->flag_error_recovery = 0;
+
+		// Contnue to search
+		return 1;
+	}
+
+	else if( psr_ptr->flag_sync_recovery == 1 && set_get_bit(get_recovery_row(psr_ptr), lookahead_index) == 1 ){
+		// Lookahead is a sync terminal, or a symbol further down the stack
+		// can use it
+		if( unwind_to_sync(psr_ptr, lookahead_symbol, lookahead_index) == 0 ){
+			// Nothing on the stack uses it. Recovery ends with it, so the
+			// next error is recorded
+			psr_ptr->flag_error_recovery = 0;
+
+			discard_token(psr_ptr, tkn_ptr);
+			STATS_ADD(psr_ptr, tokens_discarded, 1);
+
+			*result_ptr = PARSER_STEP_RESULT_FAIL;
+			return 0;
+		}
+
+		// Recovery stays active until the symbol uses lookahead. If
+		// lookahead only follows it, it is popped without a second error for
+		// the same token
+
+		// Continue with the symbol that can use lookahead
+		return 1;
+	}
+
+	else{
+		// Wait until a symbol in follow set appears, or match is found
+		psr_ptr->flag_error_recovery = 1;
+
+		// Discard token
+		discard_token(psr_ptr, tkn_ptr);
+		STATS_ADD(psr_ptr, tokens_discarded, 1);
+
+		*result_ptr = PARSER_STEP_RESULT_FAIL;
+		return 0;
+	}
+}
+
+int ParserLL1_skip_recovery_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs){
+	return skip_recovery_input(psr_ptr, tkn_ptrs, NULL, len_tkn_ptrs);
+}
+
+ParseTree *ParserLL1_get_parse_tree(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_event_mode == 1 || psr_ptr->flag_incremental_mode == 1)
+		return NULL;
+
+	if(psr_ptr->flag_arena_mode == 1){
+		// Copy out of arena once. Tokens are moved to the copy, so later
+		// calls hand out the same copy
+		if(psr_ptr->tree == NULL && psr_ptr->arena_tree != NULL)
+			psr_ptr->tree = arena_tree_to_parse_tree(psr_ptr->arena_tree);
+		return psr_ptr->tree;
+	}
+
+	psr_ptr->flag_free_parse_tree = 0;
+	return psr_ptr->tree;
+}
+
+
+////////////////
+// Arena mode //
+////////////////
+
+void ParserLL1_set_arena_mode(ParserLL1 *psr_ptr, int block_size){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
+	if(psr_ptr->flag_arena_mode == 1 || psr_ptr->flag_event_mode == 1 || psr_ptr->len_stack != 2 || psr_ptr->stack[1].node_ptr != psr_ptr->tree){
+		// Already enabled, event mode used or parsing has started
+		return;
+	}
+
+	if(block_size > 0)
+		psr_ptr->arena_block_size = block_size;
+
+	// Replace root node with arena node
+	ParseTree_Node_destroy(psr_ptr->tree);
+	psr_ptr->tree = NULL;
+
+	psr_ptr->flag_arena_mode = 1;
+
+	psr_ptr->arena_tree = arena_node_new(psr_ptr, grm_ptr->start_symbol, NULL);
+	psr_ptr->stack[1].node_ptr = psr_ptr->arena_tree;
+}
+
+ParserLL1_Node *ParserLL1_get_arena_tree(ParserLL1 *psr_ptr){
+	return psr_ptr->arena_tree;
+}
+
+void ParserLL1_release_arena_tree(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_arena_mode == 0)
+		return;
+
+	arena_destroy(psr_ptr);
+	psr_ptr->arena_tree = NULL;
+
+	// Tokens of tree are kept with the input in incremental mode
+	clear_input_records(psr_ptr);
+
+	// Stack referred to freed nodes
+	psr_ptr->len_stack = 0;
+}
+
+static void arena_destroy(ParserLL1 *psr_ptr){
+	NodeBlock *blk_ptr = psr_ptr->arena_block_list;
+
+	while(blk_ptr != NULL){
+		// Nodes are freed with the block, only tokens need to be destroyed.
+		// Tokens are not owned by nodes in incremental mode, or if borrowed
+		for (int i = 0; psr_ptr->flag_incremental_mode == 0 && psr_ptr->flag_borrowed_tokens == 0 && i < blk_ptr->len_nodes; ++i){
+			if(blk_ptr->nodes[i].tkn_ptr != NULL)
+				Token_destroy(blk_ptr->nodes[i].tkn_ptr);
+		}
+
+		NodeBlock *next_blk_ptr = blk_ptr->next;
+		free(blk_ptr);
+		blk_ptr = next_blk_ptr;
+	}
+
+	psr_ptr->arena_block_list = NULL;
+	psr_ptr->len_arena_blocks = 0;
+	psr_ptr->arena_free_list = NULL;
+}
+
+static void arena_truncate(ParserLL1 *psr_ptr, NodeBlock *blk_ptr, int len_nodes){
+	// Free blocks started after blk_ptr, along with tokens of their nodes
+	while(psr_ptr->arena_block_list != blk_ptr){
+		NodeBlock *last_blk_ptr = psr_ptr->arena_block_list;
+
+		for (int i = 0; i < last_blk_ptr->len_nodes; ++i){
+			if(last_blk_ptr->nodes[i].tkn_ptr != NULL)
+				Token_destroy(last_blk_ptr->nodes[i].tkn_ptr);
+		}
+
+		psr_ptr->arena_block_list = last_blk_ptr->next;
+		psr_ptr->len_arena_blocks--;
+		free(last_blk_ptr);
+	}
+
+	if(blk_ptr == NULL)
+		return;
+
+	// Nodes past len_nodes are reused
+	for (int i = len_nodes; i < blk_ptr->len_nodes; ++i){
+		if(blk_ptr->nodes[i].tkn_ptr != NULL)
+			Token_destroy(blk_ptr->nodes[i].tkn_ptr);
+	}
+	blk_ptr->len_nodes = len_nodes;
+}
+
+static void arena_free_old_parse(ParserLL1 *psr_ptr, RestoredLink *links, int len_links){
+	// Siblings split off by restore_parse_state hold the old parse after the
+	// resume point. Their subtrees go to the free list, except for nodes
+	// marked as adopted. Children of a freed node are put in front of the
+	// siblings still to visit, so deep trees need no stack. Tokens stay with
+	// the input records
+	for (int j = 0; j < len_links; ++j){
+		ParserLL1_Node *node_ptr = links[j].next_sibling;
+
+		while(node_ptr != NULL){
+			ParserLL1_Node *next_ptr = node_ptr->next_sibling;
+
+			if(node_ptr->symbol_index == NODE_ADOPTED){
+				node_ptr = next_ptr;
+				continue;
+			}
+
+			if(node_ptr->first_child != NULL){
+				ParserLL1_Node *last_ptr = node_ptr->first_child;
+				while(last_ptr->next_sibling != NULL)
+					last_ptr = last_ptr->next_sibling;
+
+				last_ptr->next_sibling = next_ptr;
+				next_ptr = node_ptr->first_child;
+			}
+
+			node_ptr->tkn_ptr = NULL;
+			node_ptr->next_sibling = psr_ptr->arena_free_list;
+			psr_ptr->arena_free_list = node_ptr;
+
+			node_ptr = next_ptr;
+		}
+	}
+}
+
+static ParseTree_Node *arena_tree_to_parse_tree(ParserLL1_Node *root_node_ptr){
+	// Nodes still to copy, with the copy of their parent. Kept on an explicit
+	// stack, as long lists make trees too deep for recursion
+	int len_pending = 0;
+	int cap_pending = PARSERLL1_INITIAL_STACK_SIZE;
+	ParserLL1_Node **pending_node_ptrs = malloc( sizeof(ParserLL1_Node *) * cap_pending );
+	ParseTree_Node **pending_parent_ptrs = malloc( sizeof(ParseTree_Node *) * cap_pending );
+
+	pending_node_ptrs[len_pending] = root_node_ptr;
+	pending_parent_ptrs[len_pending] = NULL;
+	len_pending++;
+
+	ParseTree_Node *dst_root_node_ptr = NULL;
+
+	while(len_pending > 0){
+		len_pending--;
+		ParserLL1_Node *src_node_ptr = pending_node_ptrs[len_pending];
+		ParseTree_Node *dst_parent_node_ptr = pending_parent_ptrs[len_pending];
+		ParseTree_Node *dst_node_ptr;
+
+		// Move token to new node
+		if(dst_parent_node_ptr == NULL){
+			dst_node_ptr = ParseTree_Node_new(src_node_ptr->symbol, src_node_ptr->tkn_ptr);
+			dst_root_node_ptr = dst_node_ptr;
+		}
+		else{
+			dst_node_ptr = ParseTree_Node_create_child_left_end(dst_parent_node_ptr, src_node_ptr->symbol, src_node_ptr->tkn_ptr);
+			dst_node_ptr->symbol_index = src_node_ptr->symbol_index;
+		}
+		dst_node_ptr->rule_num = src_node_ptr->rule_num;
+		src_node_ptr->tkn_ptr = NULL;
+
+		// Children are added at the left end, so the last child must be
+		// copied first. It is pushed last
+		for (ParserLL1_Node *chd_ptr = src_node_ptr->first_child; chd_ptr != NULL; chd_ptr = chd_ptr->next_sibling){
+			if(len_pending == cap_pending){
+				cap_pending *= 2;
+				pending_node_ptrs = realloc( pending_node_ptrs, sizeof(ParserLL1_Node *) * cap_pending );
+				pending_parent_ptrs = realloc( pending_parent_ptrs, sizeof(ParseTree_Node *) * cap_pending );
+			}
+
+			pending_node_ptrs[len_pending] = chd_ptr;
+			pending_parent_ptrs[len_pending] = dst_node_ptr;
+			len_pending++;
+		}
+	}
+
+	free(pending_node_ptrs);
+	free(pending_parent_ptrs);
+
+	return dst_root_node_ptr;
+}
+
+
+////////////////
+// Event mode //
+////////////////
+
+void ParserLL1_set_event_mode(ParserLL1 *psr_ptr, void (*event_callback)(ParserLL1_Event *, void *), void *ctx){
+	if(psr_ptr->flag_event_mode == 1 || psr_ptr->flag_arena_mode == 1 || psr_ptr->len_stack != 2 || psr_ptr->stack[1].node_ptr != psr_ptr->tree){
+		// Already enabled, arena mode used or parsing has started
+		return;
+	}
+
+	// Root node is not needed
+	ParseTree_Node_destroy(psr_ptr->tree);
+	psr_ptr->tree = NULL;
+	psr_ptr->stack[1].node_ptr = NULL;
+	STATS_ADD(psr_ptr, nodes_allocated, -1);
+
+	psr_ptr->flag_event_mode = 1;
+	psr_ptr->event_callback = event_callback;
+	psr_ptr->event_ctx = ctx;
+}
+
+
+///////////////
+// Flat mode //
+///////////////
+
+void ParserLL1_set_flat_mode(ParserLL1 *psr_ptr){
+	ParserLL1_set_event_mode(psr_ptr, flat_tree_add_event, psr_ptr);
+	if(psr_ptr->event_callback != flat_tree_add_event || psr_ptr->flag_flat_mode == 1){
+		// Event mode could not be enabled, or already used by user
+		return;
+	}
+
+	psr_ptr->flag_flat_mode = 1;
+
+	psr_ptr->cap_flat_nodes = PARSERLL1_INITIAL_FLAT_TREE_SIZE;
+	psr_ptr->flat_tree = flat_tree_new(psr_ptr->cap_flat_nodes);
+
+	psr_ptr->cap_flat_open_nodes = PARSERLL1_INITIAL_STACK_SIZE;
+	psr_ptr->flat_open_nodes = malloc( sizeof(int) * psr_ptr->cap_flat_open_nodes );
+	psr_ptr->len_flat_open_nodes = 0;
+}
+
+ParserLL1_FlatTree *ParserLL1_get_flat_tree(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_flat_mode == 0 || psr_ptr->flag_halted == 0)
+		return NULL;
+
+	ParserLL1_FlatTree *ft_ptr = psr_ptr->flat_tree;
+	if(ft_ptr == NULL)
+		return NULL;
+
+	// Variables still open when parsing stopped end with the last node
+	for (int i = 0; i < psr_ptr->len_flat_open_nodes; ++i){
+		int node_index = psr_ptr->flat_open_nodes[i];
+		ft_ptr->subtree_sizes[node_index] = ft_ptr->len_nodes - node_index;
+	}
+	psr_ptr->len_flat_open_nodes = 0;
+
+	// Owned by user now
+	psr_ptr->flat_tree = NULL;
+
+	return ft_ptr;
+}
+
+void ParserLL1_FlatTree_destroy(ParserLL1_FlatTree *ft_ptr){
+	if(ft_ptr == NULL)
+		return;
+
+	for (int i = 0; i < ft_ptr->len_nodes; ++i){
+		if(ft_ptr->tkn_ptrs[i] != NULL)
+			Token_destroy(ft_ptr->tkn_ptrs[i]);
+	}
+
+	free(ft_ptr->symbols);
+	free(ft_ptr->rule_nums);
+	free(ft_ptr->symbol_indices);
+	free(ft_ptr->tkn_ptrs);
+	free(ft_ptr->token_indices);
+	free(ft_ptr->subtree_sizes);
+	free(ft_ptr->parents);
+	free(ft_ptr);
+}
+
+static ParserLL1_FlatTree *flat_tree_new(int cap_nodes){
+	ParserLL1_FlatTree *ft_ptr = malloc( sizeof(ParserLL1_FlatTree) );
+
+	ft_ptr->len_nodes = 0;
+	ft_ptr->symbols = malloc( sizeof(int) * cap_nodes );
+	ft_ptr->rule_nums = malloc( sizeof(int) * cap_nodes );
+	ft_ptr->symbol_indices = malloc( sizeof(int) * cap_nodes );
+	ft_ptr->tkn_ptrs = malloc( sizeof(Token *) * cap_nodes );
+	ft_ptr->token_indices = malloc( sizeof(int) * cap_nodes );
+	ft_ptr->subtree_sizes = malloc( sizeof(int) * cap_nodes );
+	ft_ptr->parents = malloc( sizeof(int) * cap_nodes );
 
-		if(top_node_ptr == NULL){
-			// No symbols on the stack are left, parsing has ended
+	return ft_ptr;
+}
+
+static void flat_tree_add_event(ParserLL1_Event *evt_ptr, void *ctx){
+	ParserLL1 *psr_ptr = ctx;
+	ParserLL1_FlatTree *ft_ptr = psr_ptr->flat_tree;
+
+	if(evt_ptr->type == PARSERLL1_EVENT_EXIT){
+		// Subtree of innermost open variable is complete
+		int node_index = psr_ptr->flat_open_nodes[--psr_ptr->len_flat_open_nodes];
+		ft_ptr->subtree_sizes[node_index] = ft_ptr->len_nodes - node_index;
+		return;
+	}
 
-			// Free token, as not added to parse tree, will be lost
-			// otherwise
-			Token_destroy(tkn_ptr);
+	if(ft_ptr->len_nodes == psr_ptr->cap_flat_nodes){
+		// Grow all arrays. Capacity is kept for the next parse
+		psr_ptr->cap_flat_nodes *= 2;
+		ft_ptr->symbols = realloc( ft_ptr->symbols, sizeof(int) * psr_ptr->cap_flat_nodes );
+		ft_ptr->rule_nums = realloc( ft_ptr->rule_nums, sizeof(int) * psr_ptr->cap_flat_nodes );
+		ft_ptr->symbol_indices = realloc( ft_ptr->symbol_indices, sizeof(int) * psr_ptr->cap_flat_nodes );
+		ft_ptr->tkn_ptrs = realloc( ft_ptr->tkn_ptrs, sizeof(Token *) * psr_ptr->cap_flat_nodes );
+		ft_ptr->token_indices = realloc( ft_ptr->token_indices, sizeof(int) * psr_ptr->cap_flat_nodes );
+		ft_ptr->subtree_sizes = realloc( ft_ptr->subtree_sizes, sizeof(int) * psr_ptr->cap_flat_nodes );
+		ft_ptr->parents = realloc( ft_ptr->parents, sizeof(int) * psr_ptr->cap_flat_nodes );
+	}
 
-			return PARSER_STEP_RESULT_HALTED;
+	// Nodes are entered in preorder
+	int node_index = ft_ptr->len_nodes++;
+	ft_ptr->symbols[node_index] = evt_ptr->symbol;
+	ft_ptr->rule_nums[node_index] = evt_ptr->rule_num;
+	ft_ptr->symbol_indices[node_index] = evt_ptr->symbol_index;
+	ft_ptr->tkn_ptrs[node_index] = evt_ptr->tkn_ptr;
+	// Only matched terminals have a token
+	ft_ptr->token_indices[node_index] = evt_ptr->type == PARSERLL1_EVENT_TOKEN && evt_ptr->rule_num == 0 ? evt_ptr->token_index : -1;
+	ft_ptr->subtree_sizes[node_index] = 1;
+	ft_ptr->parents[node_index] = psr_ptr->len_flat_open_nodes > 0 ? psr_ptr->flat_open_nodes[psr_ptr->len_flat_open_nodes - 1] : -1;
+	STATS_ADD(psr_ptr, nodes_allocated, 1);
+
+	if(evt_ptr->type == PARSERLL1_EVENT_ENTER){
+		// Children follow until exit
+		if(psr_ptr->len_flat_open_nodes == psr_ptr->cap_flat_open_nodes){
+			psr_ptr->cap_flat_open_nodes *= 2;
+			psr_ptr->flat_open_nodes = realloc( psr_ptr->flat_open_nodes, sizeof(int) * psr_ptr->cap_flat_open_nodes );
 		}
+		psr_ptr->flat_open_nodes[psr_ptr->len_flat_open_nodes++] = node_index;
+	}
+}
 
-		int top_symbol = top_node_ptr->symbol;
 
-		// printf("top=%d\t", top_symbol);
+/////////////////
+// Checkpoints //
+/////////////////
 
-		if( BitSet_get_bit(psr_ptr->symbol_class_set, top_symbol) == 1 ){
-			// Top of the stack is a terminal
+ParserLL1_Checkpoint *ParserLL1_checkpoint(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_incremental_mode == 1)
+		return NULL;
 
-			if(lookahead_symbol == top_symbol){
-				// Match
-				// printf("Match\n");
-				top_node_ptr->tkn_ptr = tkn_ptr;
+	if(psr_ptr->flag_arena_mode == 1){
+		if(psr_ptr->arena_tree == NULL)
+			return NULL;
+	}
+	else if(psr_ptr->flag_flat_mode == 1){
+		if(psr_ptr->flat_tree == NULL)
+			return NULL;
+	}
+	else{
+		// Tree nodes and events already passed on cannot be taken back
+		return NULL;
+	}
+
+	ParserLL1_Checkpoint *chk_ptr = malloc( sizeof(ParserLL1_Checkpoint) );
+
+	chk_ptr->len_stack = psr_ptr->len_stack;
+	chk_ptr->stack = malloc( sizeof(StackEntry) * (psr_ptr->len_stack > 0 ? psr_ptr->len_stack : 1) );
+	memcpy(chk_ptr->stack, psr_ptr->stack, sizeof(StackEntry) * psr_ptr->len_stack);
+
+	chk_ptr->num_tokens = psr_ptr->num_tokens;
+	chk_ptr->num_tree_nodes = psr_ptr->num_tree_nodes;
+	chk_ptr->num_errors = psr_ptr->num_errors;
+	chk_ptr->flag_errors_found = psr_ptr->flag_errors_found;
+	chk_ptr->flag_errors_dropped = psr_ptr->flag_errors_dropped;
+	chk_ptr->flag_error_recovery = psr_ptr->flag_error_recovery;
+	chk_ptr->flag_halted = psr_ptr->flag_halted;
+
+	chk_ptr->arena_block_ptr = psr_ptr->arena_block_list;
+	chk_ptr->len_arena_block_nodes = psr_ptr->arena_block_list != NULL ? psr_ptr->arena_block_list->len_nodes : 0;
+
+	chk_ptr->flat_open_nodes = NULL;
+	chk_ptr->len_flat_nodes = 0;
+	chk_ptr->len_flat_open_nodes = 0;
+	if(psr_ptr->flag_flat_mode == 1){
+		chk_ptr->len_flat_nodes = psr_ptr->flat_tree->len_nodes;
+		chk_ptr->len_flat_open_nodes = psr_ptr->len_flat_open_nodes;
+		chk_ptr->flat_open_nodes = malloc( sizeof(int) * (psr_ptr->len_flat_open_nodes > 0 ? psr_ptr->len_flat_open_nodes : 1) );
+		memcpy(chk_ptr->flat_open_nodes, psr_ptr->flat_open_nodes, sizeof(int) * psr_ptr->len_flat_open_nodes);
+	}
 
-				// Terminal rule number is 0
-				top_node_ptr->rule_num = 0;
+	return chk_ptr;
+}
 
-				// This step was successful
-				psr_ptr->flag_error_recovery = 0;
+void ParserLL1_restore(ParserLL1 *psr_ptr, ParserLL1_Checkpoint *chk_ptr){
+	if(psr_ptr->flag_arena_mode == 1){
+		if(psr_ptr->arena_tree == NULL)
+			return;
 
-				if(top_symbol == psr_ptr->end_symbol){
-					// End of stack reached, parsing over
+		// Nodes on the saved stack may have been expanded or matched since.
+		// Their new children are freed with the arena below
+		for (int i = 0; i < chk_ptr->len_stack; ++i){
+			ParserLL1_Node *node_ptr = chk_ptr->stack[i].node_ptr;
+			if(node_ptr == NULL)
+				continue;
 
-					// Need to free end node, as it does not belong to tree
-					ParseTree_Node_destroy( LinkedList_pop(psr_ptr->stack) );
+			if(node_ptr->tkn_ptr != NULL)
+				Token_destroy(node_ptr->tkn_ptr);
+			node_ptr->tkn_ptr = NULL;
+			node_ptr->token_index = -1;
+			node_ptr->rule_num = -1;
+			node_ptr->first_child = NULL;
+		}
 
-					// User can access parse tree now
-					psr_ptr->flag_halted = 1;
+		arena_truncate(psr_ptr, chk_ptr->arena_block_ptr, chk_ptr->len_arena_block_nodes);
+	}
 
-					if(psr_ptr->flag_errors_found == 0){
-						// Return success only if no errors were detected
-						return PARSER_STEP_RESULT_SUCCESS;
-					}
-					else{
-						return PARSER_STEP_RESULT_HALTED;
-					}
-				}
+	else if(psr_ptr->flag_flat_mode == 1){
+		ParserLL1_FlatTree *ft_ptr = psr_ptr->flat_tree;
+		if(ft_ptr == NULL)
+			return;
 
-				else{
-					// Stack not empty, require more input
+		// Nodes are only appended, drop those added since
+		for (int i = chk_ptr->len_flat_nodes; i < ft_ptr->len_nodes; ++i){
+			if(ft_ptr->tkn_ptrs[i] != NULL)
+				Token_destroy(ft_ptr->tkn_ptrs[i]);
+		}
+		ft_ptr->len_nodes = chk_ptr->len_flat_nodes;
 
-					// No need to free popped node, already exists in tree
-					LinkedList_pop(psr_ptr->stack);
-					return PARSER_STEP_RESULT_MORE_INPUT;
-				}
-			}
+		// Open list only grows, so it has room for the saved one
+		memcpy(psr_ptr->flat_open_nodes, chk_ptr->flat_open_nodes, sizeof(int) * chk_ptr->len_flat_open_nodes);
+		psr_ptr->len_flat_open_nodes = chk_ptr->len_flat_open_nodes;
+	}
 
-			else{
-				// Parsing error, lookahead does not match top of stack
+	else{
+		return;
+	}
 
-				psr_ptr->flag_errors_found = 1;
+	// Stack only grows, so it has room for the saved one
+	memcpy(psr_ptr->stack, chk_ptr->stack, sizeof(StackEntry) * chk_ptr->len_stack);
+	psr_ptr->len_stack = chk_ptr->len_stack;
+	psr_ptr->len_recovery_rows = 0;
+
+	// Error records after the saved count are reused
+	psr_ptr->num_tokens = chk_ptr->num_tokens;
+	psr_ptr->num_tree_nodes = chk_ptr->num_tree_nodes;
+	psr_ptr->num_errors = chk_ptr->num_errors;
+	psr_ptr->flag_errors_found = chk_ptr->flag_errors_found;
+	psr_ptr->flag_errors_dropped = chk_ptr->flag_errors_dropped;
+	psr_ptr->flag_error_recovery = chk_ptr->flag_error_recovery;
+	psr_ptr->flag_halted = chk_ptr->flag_halted;
+}
 
+void ParserLL1_Checkpoint_destroy(ParserLL1_Checkpoint *chk_ptr){
+	if(chk_ptr == NULL)
+		return;
 
-				if( BitSet_get_bit(psr_ptr->forget_terminal_symbol_set, top_symbol) == 0 ){
-					// Pop the top, if it is not end symbol, and discard
-					// lookahead as if they had matched.
+	free(chk_ptr->stack);
+	free(chk_ptr->flat_open_nodes);
+	free(chk_ptr);
+}
 
-					if(top_symbol != psr_ptr->end_symbol){
-						// No need to free popped node, as it is not end symbol
-						LinkedList_pop(psr_ptr->stack);
-					}
 
-					if(psr_ptr->flag_error_recovery == 1){
-						// Error recovery active, not need to record error
-					}
+/////////////////////////
+// Incremental parsing //
+/////////////////////////
 
-					else{
-						// Enable error recovery and record error
-						psr_ptr->flag_error_recovery = 1;
-						add_error(psr_ptr, tkn_ptr, top_symbol);
-					}
+void ParserLL1_set_incremental_mode(ParserLL1 *psr_ptr){
+	if(psr_ptr->flag_incremental_mode == 1 || psr_ptr->flag_event_mode == 1 || psr_ptr->num_tokens != 0){
+		// Already enabled, event mode used or parsing has started
+		return;
+	}
 
-					// Discard token
-					Token_destroy(tkn_ptr);
+	// Tree is kept in arena
+	ParserLL1_set_arena_mode(psr_ptr, 0);
+	if(psr_ptr->flag_arena_mode == 0)
+		return;
 
-					return PARSER_STEP_RESULT_FAIL;
-				}
+	psr_ptr->flag_incremental_mode = 1;
+}
 
-				else{
-					// Assume user wanted to put the top before lookahead
-					// here. Pop top as if match was found before lookahead.
-					// Continue to search a match for lookahead
+Parser_StepResult_type ParserLL1_reparse(ParserLL1 *psr_ptr, int edit_index, int len_removed, Token **tkn_ptrs, int len_tkn_ptrs){
+	int len_old_records = psr_ptr->len_input_records;
 
-					// No need to free popped node
-					LinkedList_pop(psr_ptr->stack);
+	if(psr_ptr->flag_incremental_mode == 0 || edit_index < 0 || len_removed < 0 || len_tkn_ptrs < 0 || edit_index + len_removed > len_old_records){
+		// Not in incremental mode, or edit outside input
+		return PARSER_STEP_RESULT_FAIL;
+	}
+
+	// Tokens from the end of the edit on are the same as in the old input,
+	// shifted by shift positions
+	int old_edit_end = edit_index + len_removed;
+	int new_edit_end = edit_index + len_tkn_ptrs;
+	int shift = len_tkn_ptrs - len_removed;
+	int len_new_records = len_old_records + shift;
+
+	// Old parse can only be taken over if it was complete
+	int old_end_token_index = psr_ptr->end_token_index;
+	int old_flag_error_recovery = psr_ptr->flag_error_recovery;
+	// Kept for the new parse too, as errors dropped before the edit are not
+	// found again
+	int old_flag_errors_dropped = psr_ptr->flag_errors_dropped;
+
+	// Resume right after the last token before the edit that was matched, as
+	// the parser state there can be recovered from the tree. At least the
+	// last token is processed again, for its status
+	int resume_index = edit_index < len_new_records - 1 ? edit_index : len_new_records - 1;
+	while(resume_index > 0 && psr_ptr->input_records[resume_index - 1].leaf_node_ptr == NULL)
+		resume_index--;
+	if(resume_index < 0)
+		resume_index = 0;
+
+	// Stack length at resume point, the current one if all tokens were matched
+	int resume_len_stack = resume_index < len_old_records ? psr_ptr->input_records[resume_index].len_stack : psr_ptr->len_stack;
+
+	// Keep errors before resume point. Those after the edit are kept aside
+	// in case the old parse is taken over, the rest are found again. Errors
+	// are in input order
+	int len_kept_errors = 0;
+	while(len_kept_errors < psr_ptr->num_errors && psr_ptr->errors[len_kept_errors].token_index < resume_index)
+		len_kept_errors++;
+
+	int pos_old_errors = len_kept_errors;
+	while(pos_old_errors < psr_ptr->num_errors && psr_ptr->errors[pos_old_errors].token_index < old_edit_end)
+		pos_old_errors++;
+
+	int len_old_errors = psr_ptr->num_errors - pos_old_errors;
+	ErrorBuffer *old_errors = malloc( sizeof(ErrorBuffer) * (len_old_errors > 0 ? len_old_errors : 1) );
+	if(len_old_errors > 0)
+		memcpy(old_errors, psr_ptr->errors + pos_old_errors, sizeof(ErrorBuffer) * len_old_errors);
+
+	psr_ptr->num_errors = len_kept_errors;
+
+	// Replace removed tokens by new ones
+	for (int i = edit_index; i < old_edit_end; ++i)
+		Token_destroy(psr_ptr->input_records[i].tkn_ptr);
+
+	if(len_new_records > psr_ptr->cap_input_records){
+		psr_ptr->cap_input_records = len_new_records;
+		psr_ptr->input_records = realloc( psr_ptr->input_records, sizeof(InputRecord) * psr_ptr->cap_input_records );
+	}
 
-					// Disable error recovery, as action taken
-					psr_ptr->flag_error_recovery = 0;
+	if(shift != 0)
+		memmove(psr_ptr->input_records + new_edit_end, psr_ptr->input_records + old_edit_end, sizeof(InputRecord) * (len_old_records - old_edit_end));
+	for (int i = 0; i < len_tkn_ptrs; ++i){
+		psr_ptr->input_records[edit_index + i].tkn_ptr = tkn_ptrs[i];
+		psr_ptr->input_records[edit_index + i].leaf_node_ptr = NULL;
+		psr_ptr->input_records[edit_index + i].len_stack = -1;
+	}
+	psr_ptr->len_input_records = len_new_records;
+
+	// At most one changed link for each pending symbol, or the old root
+	RestoredLink *links = malloc( sizeof(RestoredLink) * (resume_len_stack > 0 ? resume_len_stack : 1) );
+	int len_links = restore_parse_state(psr_ptr, resume_index, resume_len_stack, links);
+
+	// Process tokens again until the parser reaches the same state as the old
+	// parse at the same token after the edit. The rest of the old parse is
+	// then the same and is taken over
+	Parser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;
+	ParserLL1_Node *old_leaf_node_ptr = NULL;
+	int flag_adopted = 0;
+	int adopt_index = len_new_records;
+
+	for (int i = resume_index; i < len_new_records; ++i){
+		InputRecord *rec_ptr = &(psr_ptr->input_records[i]);
+
+		if(i > new_edit_end && old_end_token_index >= 0 && i - shift <= old_end_token_index && old_leaf_node_ptr != NULL && psr_ptr->input_records[i - 1].leaf_node_ptr != NULL){
+			// Both parses matched the previous token, compare states. Errors
+			// taken over must not reach a limit that stops parsing. If the old
+			// parse dropped errors, they must be dropped again
+			int len_adopted_errors = 0;
+			for (int j = 0; psr_ptr->max_errors > 0 && j < len_old_errors; ++j)
+				len_adopted_errors += old_errors[j].token_index + shift >= i;
+
+			int flag_errors_allowed = 1;
+			if(psr_ptr->flag_stop_at_max_errors == 1 && psr_ptr->num_errors + len_adopted_errors >= psr_ptr->max_errors)
+				flag_errors_allowed = 0;
+			if(old_flag_errors_dropped == 1 && psr_ptr->num_errors + len_adopted_errors < psr_ptr->max_errors)
+				flag_errors_allowed = 0;
+
+			if(flag_errors_allowed == 1 && adopt_old_parse(psr_ptr, old_leaf_node_ptr, rec_ptr->len_stack, links, len_links) == 1){
+				flag_adopted = 1;
+				adopt_index = i;
+				break;
+			}
+		}
 
-					add_error(psr_ptr, tkn_ptr, top_symbol);
+		// Records after the edit still describe the old parse until processed
+		old_leaf_node_ptr = rec_ptr->leaf_node_ptr;
 
-					// No return, continue to search for a match
-				}
+		result = step(psr_ptr, rec_ptr->tkn_ptr);
+	}
+
+	if(flag_adopted == 1){
+		// Old parse ran to the end symbol, so does this one
+		psr_ptr->len_stack = 0;
+		psr_ptr->flag_halted = 1;
+		psr_ptr->flag_error_recovery = old_flag_error_recovery;
+		psr_ptr->num_tokens = len_new_records;
+		psr_ptr->end_token_index = old_end_token_index + shift;
+
+		// Errors found by the old parse from there on still hold, as far as
+		// the limit allows
+		for (int i = 0; i < len_old_errors; ++i){
+			ErrorBuffer *err_ptr = &(old_errors[i]);
+			err_ptr->token_index += shift;
+
+			if(err_ptr->token_index < adopt_index){
+				// Found again
+				continue;
+			}
+
+			psr_ptr->flag_errors_found = 1;
+
+			if(psr_ptr->max_errors > 0 && psr_ptr->num_errors >= psr_ptr->max_errors){
+				psr_ptr->flag_errors_dropped = 1;
+				break;
+			}
+
+			if(psr_ptr->num_errors == psr_ptr->cap_errors){
+				psr_ptr->cap_errors = psr_ptr->cap_errors > 0 ? psr_ptr->cap_errors * 2 : PARSERLL1_INITIAL_ERRORS_SIZE;
+				psr_ptr->errors = realloc( psr_ptr->errors, sizeof(ErrorBuffer) * psr_ptr->cap_errors );
 			}
+
+			// Token may have moved
+			Token *tkn_ptr = psr_ptr->input_records[err_ptr->token_index].tkn_ptr;
+			err_ptr->line = tkn_ptr->line;
+			err_ptr->column = tkn_ptr->column;
+
+			psr_ptr->errors[psr_ptr->num_errors++] = *err_ptr;
 		}
 
-		else{
-			// Top of stack is non terminal, need to expand
+		// Status of the last token, as the old parse would give it now
+		int last_index = len_new_records - 1;
+		if(last_index == psr_ptr->end_token_index)
+			result = psr_ptr->flag_errors_found == 0 ? PARSER_STEP_RESULT_SUCCESS : PARSER_STEP_RESULT_HALTED;
+		else if( get_symbol_flags(psr_ptr->grm_ptr, psr_ptr->grm_ptr->token_to_symbol(psr_ptr->input_records[last_index].tkn_ptr)) & SYMBOL_FLAG_TERMINAL )
+			result = PARSER_STEP_RESULT_HALTED;
+		else
+			result = PARSER_STEP_RESULT_UNKNOWN_INPUT;
+	}
+
+	else{
+		// Nothing of the old parse after the resume point is left
+		arena_free_old_parse(psr_ptr, links, len_links);
+	}
+
+	free(old_errors);
+	free(links);
 
-			// Get the row corresponding to top symbol
-			HashTable *var_row_tbl_ptr = HashTable_get(psr_ptr->parse_table, (void *) &top_symbol);
+	return result;
+}
+
+static void record_input_token(ParserLL1 *psr_ptr, Token *tkn_ptr){
+	int index = psr_ptr->num_tokens;
 
-			// Get the rule correspond to lookahead from row
-			Rule *rul_ptr = HashTable_get(var_row_tbl_ptr, (void *) &lookahead_symbol);
+	if(index == psr_ptr->cap_input_records){
+		// Full, double capacity
+		psr_ptr->cap_input_records = psr_ptr->cap_input_records > 0 ? psr_ptr->cap_input_records * 2 : PARSERLL1_INITIAL_STACK_SIZE;
+		psr_ptr->input_records = realloc( psr_ptr->input_records, sizeof(InputRecord) * psr_ptr->cap_input_records );
+	}
 
-			if(rul_ptr != NULL){
-				// Rule exists, expand rule
+	InputRecord *rec_ptr = &(psr_ptr->input_records[index]);
+	rec_ptr->tkn_ptr = tkn_ptr;
+	rec_ptr->leaf_node_ptr = NULL;
+	rec_ptr->len_stack = psr_ptr->len_stack;
 
-				// This step was successful
-				psr_ptr->flag_error_recovery = 0;
+	if(index >= psr_ptr->len_input_records)
+		psr_ptr->len_input_records = index + 1;
+}
 
-				// No need to free popped node, already exists in tree
-				ParseTree_Node *parent_node_ptr = LinkedList_pop(psr_ptr->stack);
-				// Add rule number to popped node
-				parent_node_ptr->rule_num = rul_ptr->rule_num;
+static void clear_input_records(ParserLL1 *psr_ptr){
+	for (int i = 0; i < psr_ptr->len_input_records; ++i)
+		Token_destroy(psr_ptr->input_records[i].tkn_ptr);
 
-				// Traverse rule list in reverse
-				for (int i = rul_ptr->len_expansion_symbols - 1; i >= 0; --i){
-					int expansion_symbol = rul_ptr->expansion_symbols[i];
+	psr_ptr->len_input_records = 0;
+	psr_ptr->end_token_index = -1;
+}
 
-					if( expansion_symbol == psr_ptr->empty_symbol ){
-						// No need to push empty symbol onto stack
-						continue;
-					}
+static int restore_parse_state(ParserLL1 *psr_ptr, int resume_index, int resume_len_stack, RestoredLink *links){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
 
-					else{
-						// Add a new node to tree
-						ParseTree_Node *child_node_ptr = ParseTree_Node_create_child_left_end(top_node_ptr, expansion_symbol, NULL);
-						child_node_ptr->symbol_index = i;
-						// Also push node onto stack
-						LinkedList_push(psr_ptr->stack, child_node_ptr);
-					}
-				}
+	// Last token before resume point was matched, so error recovery is over
+	psr_ptr->flag_halted = 0;
+	psr_ptr->flag_error_recovery = 0;
+	psr_ptr->flag_errors_found = psr_ptr->num_errors > 0;
+	psr_ptr->num_tokens = resume_index;
+	psr_ptr->end_token_index = -1;
+
+	psr_ptr->len_stack = 0;
+	stack_push(psr_ptr, grm_ptr->end_symbol, -1, NULL);
+
+	if(resume_index == 0){
+		// Nothing to keep, start a new tree. The old one is linked from no
+		// node
+		links[0].node_ptr = NULL;
+		links[0].next_sibling = psr_ptr->arena_tree;
+
+		psr_ptr->arena_tree = arena_node_new(psr_ptr, grm_ptr->start_symbol, NULL);
+		stack_push(psr_ptr, grm_ptr->start_symbol, -1, psr_ptr->arena_tree);
+		STATS_ADD(psr_ptr, nodes_allocated, 1);
+		return 1;
+	}
+
+	// After a match, the stack holds the siblings following the leaf and each
+	// of its ancestors, innermost on top, above the end symbol. These were
+	// expanded by the old parse, and are replaced by new unexpanded nodes. The
+	// old ones are kept for adopt_old_parse, along with the sibling links
+	// that are changed
+	int len_pending = resume_len_stack - 1;
+	ParserLL1_Node **pending = malloc( sizeof(ParserLL1_Node *) * (len_pending > 0 ? len_pending : 1) );
+	int len_links = 0;
+
+	int i = 0;
+	for (ParserLL1_Node *node_ptr = psr_ptr->input_records[resume_index - 1].leaf_node_ptr; i < len_pending; node_ptr = node_ptr->parent){
+		if(node_ptr->next_sibling == NULL)
+			continue;
+
+		links[len_links].node_ptr = node_ptr;
+		links[len_links].next_sibling = node_ptr->next_sibling;
+		len_links++;
+
+		ParserLL1_Node *prev_ptr = node_ptr;
+		for (ParserLL1_Node *sib_ptr = node_ptr->next_sibling; sib_ptr != NULL; sib_ptr = sib_ptr->next_sibling){
+			ParserLL1_Node *new_ptr = arena_node_new(psr_ptr, sib_ptr->symbol, sib_ptr->parent);
+			new_ptr->symbol_index = sib_ptr->symbol_index;
+			STATS_ADD(psr_ptr, nodes_allocated, 1);
+
+			prev_ptr->next_sibling = new_ptr;
+			prev_ptr = new_ptr;
+			pending[i++] = new_ptr;
+		}
+	}
+
+	// Innermost first, push in reverse
+	for (i = len_pending - 1; i >= 0; --i)
+		stack_push(psr_ptr, pending[i]->symbol, pending[i]->symbol_index, pending[i]);
+
+	free(pending);
+
+	return len_links;
+}
+
+static int adopt_old_parse(ParserLL1 *psr_ptr, ParserLL1_Node *old_leaf_node_ptr, int old_len_stack, RestoredLink *links, int len_links){
+	if(psr_ptr->len_stack != old_len_stack || psr_ptr->flag_error_recovery == 1)
+		return 0;
+
+	// Collect the pending siblings of the old parse, as in
+	// restore_parse_state, and compare with current stack. Links changed by
+	// restore_parse_state are followed as they were
+	int len_pending = old_len_stack - 1;
+	ParserLL1_Node **old_pending = malloc( sizeof(ParserLL1_Node *) * (len_pending > 0 ? len_pending : 1) );
+
+	int i = 0;
+	for (ParserLL1_Node *node_ptr = old_leaf_node_ptr; node_ptr != NULL && i < len_pending; node_ptr = node_ptr->parent){
+		ParserLL1_Node *sib_ptr = node_ptr->next_sibling;
+		if(sib_ptr == NULL)
+			continue;
+
+		for (int j = 0; j < len_links; ++j){
+			if(links[j].node_ptr == node_ptr)
+				sib_ptr = links[j].next_sibling;
+		}
+
+		for ( ; sib_ptr != NULL; sib_ptr = sib_ptr->next_sibling){
+			if(i == len_pending || sib_ptr->symbol != psr_ptr->stack[len_pending - i].symbol){
+				free(old_pending);
+				return 0;
 			}
+			old_pending[i++] = sib_ptr;
+		}
+	}
+
+	if(i != len_pending){
+		free(old_pending);
+		return 0;
+	}
 
+	// Same state and same remaining input. The rest of the old parse is freed,
+	// apart from the old nodes, which are put with everything they were
+	// expanded into in place of the pending nodes of the new tree. Pending
+	// children of a node follow each other on the stack, and are the last
+	// children
+	for (i = 0; i < len_pending; ++i)
+		old_pending[i]->symbol_index = NODE_ADOPTED;
+	arena_free_old_parse(psr_ptr, links, len_links);
+
+	ParserLL1_Node *prev_ptr = NULL;
+	for (i = 0; i < len_pending; ++i){
+		ParserLL1_Node *new_ptr = psr_ptr->stack[len_pending - i].node_ptr;
+		ParserLL1_Node *old_ptr = old_pending[i];
+
+		if(prev_ptr == NULL || prev_ptr->parent != new_ptr->parent){
+			// First pending child, find the one before it
+			ParserLL1_Node *prt_ptr = new_ptr->parent;
+
+			if(prt_ptr->first_child == new_ptr){
+				prt_ptr->first_child = old_ptr;
+			}
 			else{
-				// Parsing error, no entry in parse table
+				ParserLL1_Node *chd_ptr = prt_ptr->first_child;
+				while(chd_ptr->next_sibling != new_ptr)
+					chd_ptr = chd_ptr->next_sibling;
+				chd_ptr->next_sibling = old_ptr;
+			}
+		}
+		else{
+			prev_ptr->next_sibling = old_ptr;
+		}
 
-				psr_ptr->flag_errors_found = 1;
+		old_ptr->parent = new_ptr->parent;
+		old_ptr->symbol_index = new_ptr->symbol_index;
+		old_ptr->next_sibling = NULL;
+		prev_ptr = old_ptr;
 
-				if(psr_ptr->flag_error_recovery == 1){
-					// Error recovery is active, do not record additional error
-					// No need to destroy token
-				}
-				else{
-					// Enable error recovery and record error
-					add_error(psr_ptr, tkn_ptr, top_symbol);
-					psr_ptr->flag_error_recovery = 1;
-				}
+		// Pending nodes are unexpanded
+		new_ptr->next_sibling = psr_ptr->arena_free_list;
+		psr_ptr->arena_free_list = new_ptr;
+	}
+
+	free(old_pending);
 
-				// Try to recover
-				// Check if input is in follow set of top symbol
+	return 1;
+}
 
-				BitSet *top_follow_set_ptr = HashTable_get(psr_ptr->follow_table, (void *)&top_symbol);
+///////////
+// Stack //
+///////////
 
-				if( BitSet_get_bit(top_follow_set_ptr, lookahead_symbol) == 1){
-					// Pop the top symbol. No need to free
-					LinkedList_pop(psr_ptr->stack);
-					// Disable error recovery as action taken
-					psr_ptr->flag_error_recovery = 0;
+int ParserLL1_get_peak_stack_depth(ParserLL1 *psr_ptr){
+	return psr_ptr->peak_stack_depth;
+}
 
-					// Contnue to search, no return
-				}
 
-				else{
-					// Wait until a symbol in follow set appears, or match is found
-					psr_ptr->flag_error_recovery = 1;
+////////////////
+// Statistics //
+////////////////
 
-					// Discard token
-					Token_destroy(tkn_ptr);
+int ParserLL1_get_stats(ParserLL1 *psr_ptr, ParserLL1_Stats *stats_ptr){
+	*stats_ptr = psr_ptr->stats;
 
-					return PARSER_STEP_RESULT_FAIL;
-				}
-			}
+	// Always tracked
+	stats_ptr->peak_stack_depth = psr_ptr->peak_stack_depth;
+
+#ifdef PARSERLL1_STATS
+	return 1;
+#else
+	return 0;
+#endif
+}
+
+
+/////////////////////
+// Memory & limits //
+/////////////////////
+
+void ParserLL1_get_memory_usage(ParserLL1 *psr_ptr, ParserLL1_MemoryUsage *usg_ptr){
+	get_grammar_memory_usage(psr_ptr->grm_ptr, usg_ptr);
+	usg_ptr->parse_total = get_parse_memory_usage(psr_ptr, usg_ptr);
+
+	usg_ptr->total = usg_ptr->grammar_symbols + usg_ptr->grammar_rules + usg_ptr->grammar_sets + usg_ptr->grammar_parse_table + usg_ptr->parse_total;
+}
+
+void ParserLL1_set_limits(ParserLL1 *psr_ptr, long long max_tree_nodes, int max_stack_depth, size_t max_memory){
+	psr_ptr->max_tree_nodes = max_tree_nodes > 0 ? max_tree_nodes : 0;
+	psr_ptr->max_stack_depth = max_stack_depth > 0 ? max_stack_depth : 0;
+	psr_ptr->max_memory = max_memory;
+
+	psr_ptr->flag_limits = psr_ptr->max_tree_nodes > 0 || psr_ptr->max_stack_depth > 0 || psr_ptr->max_memory > 0;
+}
+
+static void get_grammar_memory_usage(ParserLL1_Grammar *grm_ptr, ParserLL1_MemoryUsage *usg_ptr){
+	// Sizes follow from the table dimensions, also for tables in an image
+	usg_ptr->grammar_symbols = sizeof(int) * (grm_ptr->len_variable_symbols + grm_ptr->len_terminal_symbols + grm_ptr->len_forget_terminal_symbols);
+	usg_ptr->grammar_symbols += sizeof(SymbolAttr) * (grm_ptr->symbols_max - grm_ptr->symbols_min + 1);
+
+	// Rules as added are freed with a loaded grammar
+	usg_ptr->grammar_rules = sizeof(Rule *) * grm_ptr->cap_rule_list;
+	for (int i = 0; i < grm_ptr->len_rule_list; ++i)
+		usg_ptr->grammar_rules += sizeof(Rule) + sizeof(int) * grm_ptr->rule_list[i]->len_expansion_symbols;
+	usg_ptr->grammar_rules += sizeof(CompiledRule) * grm_ptr->len_compiled_rules + sizeof(int) * grm_ptr->len_expansion_pool;
+
+	usg_ptr->grammar_sets = sizeof(uint64_t) * 2 * grm_ptr->len_variable_symbols * grm_ptr->len_set_words;
+	if(grm_ptr->sync_rows != NULL)
+		usg_ptr->grammar_sets += sizeof(uint64_t) * grm_ptr->len_variable_symbols * grm_ptr->len_set_words;
+	if(grm_ptr->nullable_set != NULL)
+		usg_ptr->grammar_sets += sizeof(uint64_t) * ( (grm_ptr->len_variable_symbols + 63) / 64 );
+
+	usg_ptr->grammar_parse_table = 0;
+	if(grm_ptr->dense_parse_table != NULL)
+		usg_ptr->grammar_parse_table = sizeof(int) * grm_ptr->len_variable_symbols * grm_ptr->len_terminal_symbols;
+}
+
+static size_t get_parse_memory_usage(ParserLL1 *psr_ptr, ParserLL1_MemoryUsage *usg_ptr){
+	size_t stack = sizeof(StackEntry) * psr_ptr->cap_stack;
+
+	size_t tree = 0;
+	if(psr_ptr->flag_event_mode == 1){
+		// Only flat mode builds a tree, until it is taken by user
+		if(psr_ptr->flat_tree != NULL)
+			tree = FLAT_NODE_SIZE * psr_ptr->cap_flat_nodes;
+		tree += sizeof(int) * psr_ptr->cap_flat_open_nodes;
+	}
+	else if(psr_ptr->flag_arena_mode == 1)
+		tree = ( sizeof(NodeBlock) + sizeof(ParserLL1_Node) * psr_ptr->arena_block_size ) * psr_ptr->len_arena_blocks;
+	else if(psr_ptr->flag_free_parse_tree == 1)
+		tree = sizeof(ParseTree_Node) * psr_ptr->num_tree_nodes;
+
+	size_t errors = sizeof(ErrorBuffer) * psr_ptr->cap_errors;
+	if(psr_ptr->sync_terminal_row != NULL)
+		errors += sizeof(uint64_t) * (1 + psr_ptr->cap_recovery_rows) * psr_ptr->grm_ptr->len_set_words;
+
+	size_t input = sizeof(InputRecord) * psr_ptr->cap_input_records;
+	if(psr_ptr->run_buffer != NULL)
+		input += sizeof(Token *) * PARSERLL1_RUN_CHUNK_SIZE;
+
+	if(usg_ptr != NULL){
+		usg_ptr->stack = stack;
+		usg_ptr->tree = tree;
+		usg_ptr->errors = errors;
+		usg_ptr->input = input;
+	}
+
+	return stack + tree + errors + input;
+}
+
+int ParserLL1_expansion_exceeds_limits(ParserLL1 *psr_ptr, const CompiledRule *crl_ptr){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
+	// Each symbol of the expansion other than the empty symbol becomes a node
+	// and a stack entry
+	int len_new_nodes = 0;
+	int *expansion_symbols = grm_ptr->expansion_pool + crl_ptr->expansion_offset;
+	for (int i = 0; i < crl_ptr->len_expansion_symbols; ++i){
+		if( (grm_ptr->symbol_attr_table[expansion_symbols[i] - grm_ptr->symbols_min].flags & SYMBOL_FLAG_EMPTY) == 0 )
+			len_new_nodes++;
+	}
+
+	// Variable is popped, and its exit marker pushed in event mode
+	int len_stack = psr_ptr->len_stack - 1 + len_new_nodes + (psr_ptr->flag_event_mode == 1 ? 1 : 0);
+
+	if(psr_ptr->max_stack_depth > 0 && len_stack > psr_ptr->max_stack_depth)
+		return 1;
+
+	if(psr_ptr->max_tree_nodes > 0 && psr_ptr->num_tree_nodes + len_new_nodes > psr_ptr->max_tree_nodes)
+		return 1;
+
+	if(psr_ptr->max_memory > 0){
+		// Growth of the stack and tree by the expansion
+		size_t memory = 0;
+		if(len_stack > psr_ptr->cap_stack)
+			memory += sizeof(StackEntry) * psr_ptr->cap_stack;
+
+		if(psr_ptr->flag_event_mode == 1){
+			// Flat tree gets a node for the variable's children as they are
+			// matched or expanded, the arrays double when full
+			if(psr_ptr->flat_tree != NULL && psr_ptr->flat_tree->len_nodes + len_new_nodes > psr_ptr->cap_flat_nodes)
+				memory += FLAT_NODE_SIZE * psr_ptr->cap_flat_nodes;
+		}
+		else if(psr_ptr->flag_arena_mode == 1){
+			NodeBlock *blk_ptr = psr_ptr->arena_block_list;
+			if(blk_ptr != NULL && blk_ptr->len_nodes + len_new_nodes > blk_ptr->cap_nodes)
+				memory += sizeof(NodeBlock) + sizeof(ParserLL1_Node) * psr_ptr->arena_block_size;
 		}
+		else
+			memory += sizeof(ParseTree_Node) * len_new_nodes;
+
+		if( growth_exceeds_memory_limit(psr_ptr, memory) )
+			return 1;
 	}
+
+	return 0;
 }
 
-ParseTree *ParserLL1_get_parse_tree(ParserLL1 *psr_ptr){
-	psr_ptr->flag_free_parse_tree = 0;
-	return psr_ptr->tree;
+static int growth_exceeds_memory_limit(ParserLL1 *psr_ptr, size_t len_growth){
+	return psr_ptr->max_memory > 0 && get_parse_memory_usage(psr_ptr, NULL) + len_growth > psr_ptr->max_memory;
+}
+
+
+///////////
+// Nodes //
+///////////
+
+static void node_skip(ParserLL1 *psr_ptr, StackEntry *ent_ptr){
+	// Symbol popped by error recovery. Its tree node stays empty, report the
+	// same in event mode
+	if(psr_ptr->flag_event_mode == 0)
+		return;
+
+	if( psr_ptr->grm_ptr->symbol_attr_table[ent_ptr->symbol - psr_ptr->grm_ptr->symbols_min].flags & SYMBOL_FLAG_TERMINAL ){
+		emit_event(psr_ptr, PARSERLL1_EVENT_TOKEN, ent_ptr->symbol, -1, ent_ptr->symbol_index, NULL);
+	}
+	else{
+		emit_event(psr_ptr, PARSERLL1_EVENT_ENTER, ent_ptr->symbol, -1, ent_ptr->symbol_index, NULL);
+		emit_event(psr_ptr, PARSERLL1_EVENT_EXIT, ent_ptr->symbol, 0, -1, NULL);
+	}
+}
+
+
+//////////////////////
+// Parallel parsing //
+//////////////////////
+
+void ParserLL1_parse_documents(ParserLL1_Grammar *grm_ptr, ParserLL1_Document *documents, int len_documents, int num_threads){
+	if(num_threads < 1)
+		num_threads = 1;
+	if(num_threads > len_documents)
+		num_threads = len_documents;
+
+	DocumentBatch bat;
+	bat.documents = documents;
+	bat.parsers = malloc( sizeof(ParserLL1 *) * (num_threads > 0 ? num_threads : 1) );
+
+	// Each thread reuses one parser for all documents it parses
+	for (int i = 0; i < num_threads; ++i)
+		bat.parsers[i] = ParserLL1_new_session(grm_ptr);
+
+	WorkPool_run(len_documents, num_threads, parse_document_task, &bat);
+
+	for (int i = 0; i < num_threads; ++i)
+		ParserLL1_destroy(bat.parsers[i]);
+	free(bat.parsers);
+}
+
+void ParserLL1_parse_document_chunked(ParserLL1_Grammar *grm_ptr, ParserLL1_Document *doc_ptr, int list_symbol, int sync_symbol, int num_threads){
+	Token **tkn_ptrs = doc_ptr->tkn_ptrs;
+	int len_tkn_ptrs = doc_ptr->len_tkn_ptrs;
+
+	if(num_threads < 1)
+		num_threads = 1;
+
+	int max_chunks = num_threads > 1 ? num_threads * PARSERLL1_CHUNKS_PER_THREAD : 1;
+	if(max_chunks > len_tkn_ptrs / PARSERLL1_MIN_CHUNK_TOKENS)
+		max_chunks = len_tkn_ptrs / PARSERLL1_MIN_CHUNK_TOKENS;
+
+	// Chunks start after the first sync token at or past evenly spaced
+	// positions. Ranges without sync token are merged into previous chunk
+	int *chunk_starts = malloc( sizeof(int) * (max_chunks + 2) );
+	int len_chunks = 0;
+	chunk_starts[len_chunks++] = 0;
+
+	for (int i = 1; i < max_chunks; ++i){
+		int j = (int)( (long long)len_tkn_ptrs * i / max_chunks );
+		int end = (int)( (long long)len_tkn_ptrs * (i + 1) / max_chunks );
+		if(j < chunk_starts[len_chunks - 1])
+			j = chunk_starts[len_chunks - 1];
+
+		while(j < end && grm_ptr->token_to_symbol(tkn_ptrs[j]) != sync_symbol)
+			j++;
+
+		if(j + 1 < end)
+			chunk_starts[len_chunks++] = j + 1;
+	}
+	chunk_starts[len_chunks] = len_tkn_ptrs;
+
+	if(len_chunks == 1){
+		// Nothing to split, parse directly into a tree without the arena
+		free(chunk_starts);
+		ParserLL1_parse_documents(grm_ptr, doc_ptr, 1, 1);
+		return;
+	}
+
+	ChunkBatch bat;
+	bat.tkn_ptrs = tkn_ptrs;
+	bat.chunk_starts = chunk_starts;
+	bat.list_symbol = list_symbol;
+	bat.parsers = calloc(len_chunks, sizeof(ParserLL1 *));
+	bat.flag_chunk_valid = calloc(len_chunks, sizeof(int));
+
+	// Document parser builds an arena tree, so that chunk trees can be
+	// linked into it
+	bat.parsers[0] = ParserLL1_new_session(grm_ptr);
+	ParserLL1_set_arena_mode(bat.parsers[0], 0);
+
+	// First chunk and all but the last chunk are parsed in parallel. Last
+	// chunk holds the end of the list and the end symbol, and is parsed by
+	// the document parser afterwards
+	int len_tasks = len_chunks - 1;
+	WorkPool_run(len_tasks, num_threads < len_tasks ? num_threads : len_tasks, parse_chunk_task, &bat);
+
+	ParserLL1 *psr_ptr = bat.parsers[0];
+	Parser_StepResult_type result = bat.first_result;
+	int stop_index = bat.first_stop_index;
+
+	for (int i = 1; i < len_chunks; ++i){
+		if(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED){
+			// Parsing over, rest of input stays with caller
+			break;
+		}
+
+		int len_chunk = chunk_starts[i+1] - chunk_starts[i];
+
+		// Chunk was parsed from the list symbol. Valid if the document parse
+		// has reached the list symbol too, and is not recovering from an
+		// error, as the parse then goes on exactly as it did in the chunk
+		StackEntry *top_ent_ptr = psr_ptr->len_stack > 0 ? &(psr_ptr->stack[psr_ptr->len_stack - 1]) : NULL;
+		if(bat.flag_chunk_valid[i] == 1 && psr_ptr->flag_error_recovery == 0 && top_ent_ptr != NULL && top_ent_ptr->symbol == list_symbol){
+			splice_chunk(psr_ptr, bat.parsers[i]);
+			psr_ptr->num_tokens += len_chunk;
+			stop_index += len_chunk;
+			result = PARSER_STEP_RESULT_MORE_INPUT;
+		}
+
+		else{
+			// Guess was wrong, parse chunk again in sequence
+			int len_parsed;
+			result = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs + chunk_starts[i], len_chunk, &len_parsed);
+			stop_index += len_parsed;
+		}
+	}
+
+	doc_ptr->result = result;
+	doc_ptr->stop_index = stop_index;
+
+	// Tokens are moved to the tree, including those of chunk trees
+	doc_ptr->tree = ParserLL1_get_parse_tree(psr_ptr);
+
+	doc_ptr->len_errors = ParserLL1_get_num_errors(psr_ptr);
+	doc_ptr->errors = NULL;
+	if(doc_ptr->len_errors > 0){
+		doc_ptr->errors = malloc( sizeof(ParserLL1_Error) * doc_ptr->len_errors );
+		ParserLL1_get_errors(psr_ptr, doc_ptr->errors, doc_ptr->len_errors);
+	}
+
+	// Chunk parsers are kept until now, as their nodes are part of the tree
+	for (int i = 0; i < len_chunks; ++i){
+		if(bat.parsers[i] != NULL)
+			ParserLL1_destroy(bat.parsers[i]);
+	}
+	free(bat.parsers);
+	free(bat.flag_chunk_valid);
+	free(chunk_starts);
+}
+
+void ParserLL1_Document_clear(ParserLL1_Document *doc_ptr){
+	if(doc_ptr->tree != NULL)
+		ParseTree_Node_destroy(doc_ptr->tree);
+	doc_ptr->tree = NULL;
+
+	free(doc_ptr->errors);
+	doc_ptr->errors = NULL;
+	doc_ptr->len_errors = 0;
+}
+
+static void parse_document_task(void *ctx, int thread_index, int task_index){
+	DocumentBatch *bat_ptr = ctx;
+	ParserLL1 *psr_ptr = bat_ptr->parsers[thread_index];
+	ParserLL1_Document *doc_ptr = &(bat_ptr->documents[task_index]);
+
+	// Discard state of previous document
+	ParserLL1_reset(psr_ptr);
+
+	doc_ptr->result = ParserLL1_parse_tokens(psr_ptr, doc_ptr->tkn_ptrs, doc_ptr->len_tkn_ptrs, &(doc_ptr->stop_index));
+
+	// Tree is now owned by document
+	doc_ptr->tree = ParserLL1_get_parse_tree(psr_ptr);
+
+	doc_ptr->len_errors = ParserLL1_get_num_errors(psr_ptr);
+	doc_ptr->errors = NULL;
+	if(doc_ptr->len_errors > 0){
+		doc_ptr->errors = malloc( sizeof(ParserLL1_Error) * doc_ptr->len_errors );
+		ParserLL1_get_errors(psr_ptr, doc_ptr->errors, doc_ptr->len_errors);
+	}
+}
+
+static void parse_chunk_task(void *ctx, int thread_index, int task_index){
+	(void)thread_index;
+
+	ChunkBatch *bat_ptr = ctx;
+	int start = bat_ptr->chunk_starts[task_index];
+	int end = bat_ptr->chunk_starts[task_index + 1];
+
+	if(task_index == 0){
+		// Start of the document, parsed as usual
+		bat_ptr->first_result = ParserLL1_parse_tokens(bat_ptr->parsers[0], bat_ptr->tkn_ptrs, end, &(bat_ptr->first_stop_index));
+		return;
+	}
+
+	// Parse from the list symbol instead of the start symbol. Tokens are
+	// borrowed, as they are parsed again if the chunk is not used
+	ParserLL1 *psr_ptr = ParserLL1_new_session(bat_ptr->parsers[0]->grm_ptr);
+	ParserLL1_set_arena_mode(psr_ptr, 0);
+	psr_ptr->flag_borrowed_tokens = 1;
+	psr_ptr->stack[1].symbol = bat_ptr->list_symbol;
+	psr_ptr->arena_tree->symbol = bat_ptr->list_symbol;
+	bat_ptr->parsers[task_index] = psr_ptr;
+
+	for (int i = start; i < end; ++i){
+		if(step(psr_ptr, bat_ptr->tkn_ptrs[i]) != PARSER_STEP_RESULT_MORE_INPUT || psr_ptr->flag_errors_found == 1){
+			// Chunk does not start at a list item, or has errors
+			return;
+		}
+	}
+
+	// Next item of the list is expected, and nothing else is left
+	if(psr_ptr->len_stack == 2 && psr_ptr->stack[1].symbol == bat_ptr->list_symbol)
+		bat_ptr->flag_chunk_valid[task_index] = 1;
+}
+
+static void splice_chunk(ParserLL1 *psr_ptr, ParserLL1 *chunk_psr_ptr){
+	// List symbol on top of stack takes the expansion of the chunk's root
+	StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+	ParserLL1_Node *node_ptr = top_ent_ptr->node_ptr;
+	ParserLL1_Node *chunk_root_node_ptr = chunk_psr_ptr->arena_tree;
+
+	node_ptr->rule_num = chunk_root_node_ptr->rule_num;
+	node_ptr->first_child = chunk_root_node_ptr->first_child;
+	for (ParserLL1_Node *chd_ptr = node_ptr->first_child; chd_ptr != NULL; chd_ptr = chd_ptr->next_sibling)
+		chd_ptr->parent = node_ptr;
+	chunk_root_node_ptr->first_child = NULL;
+	psr_ptr->num_tree_nodes += chunk_psr_ptr->num_tree_nodes - 1;
+
+	// Parsing goes on from the list symbol the chunk ended with
+	*top_ent_ptr = chunk_psr_ptr->stack[1];
+	if(psr_ptr->len_recovery_rows >= psr_ptr->len_stack)
+		psr_ptr->len_recovery_rows = psr_ptr->len_stack - 1;
 }
 
 
@@ -900,36 +3886,75 @@ ParseTree *ParserLL1_get_parse_tree(ParserLL1 *psr_ptr){
 ////////////
 
 void ParserLL1_print_errors(ParserLL1 *psr_ptr){
-	LinkedListIterator *itr_ptr = LinkedListIterator_new(psr_ptr->error_list);
-	LinkedListIterator_move_to_first(itr_ptr);
+	for (int i = 0; i < psr_ptr->num_errors; ++i)
+		print_error(psr_ptr, &(psr_ptr->errors[i]));
+}
 
-	ErrorBuffer *err_ptr = LinkedListIterator_get_item(itr_ptr);
-	while(err_ptr){
-		print_error(psr_ptr, err_ptr);
-		LinkedListIterator_move_to_next(itr_ptr);
-		err_ptr = LinkedListIterator_get_item(itr_ptr);
+void ParserLL1_set_immediate_print_error(ParserLL1 *psr_ptr, int val){
+	psr_ptr->flag_immediate_print_error = val;
+}
+
+void ParserLL1_set_max_errors(ParserLL1 *psr_ptr, int max_errors, int flag_stop){
+	if(max_errors < 0)
+		max_errors = 0;
+
+	psr_ptr->max_errors = max_errors;
+	psr_ptr->flag_stop_at_max_errors = max_errors > 0 && flag_stop != 0;
+
+	if(max_errors > psr_ptr->cap_errors){
+		// Allocate all records now, none are allocated while parsing
+		psr_ptr->cap_errors = max_errors;
+		psr_ptr->errors = realloc( psr_ptr->errors, sizeof(ErrorBuffer) * psr_ptr->cap_errors );
 	}
+}
 
-	LinkedListIterator_destroy(itr_ptr);
+int ParserLL1_get_num_errors(ParserLL1 *psr_ptr){
+	return psr_ptr->num_errors;
 }
 
-void ParserLL1_set_immediate_print_error(ParserLL1 *psr_ptr, int val){
-	psr_ptr->flag_immediate_print_error = val;
+int ParserLL1_get_errors(ParserLL1 *psr_ptr, ParserLL1_Error *errors, int len_errors){
+	int i;
+
+	for (i = 0; i < psr_ptr->num_errors && i < len_errors; ++i){
+		ErrorBuffer *err_ptr = &(psr_ptr->errors[i]);
+
+		errors[i].line = err_ptr->line;
+		errors[i].column = err_ptr->column;
+		errors[i].lookahead_symbol = err_ptr->lookahead_symbol;
+		errors[i].top_symbol = err_ptr->top_symbol;
+		errors[i].token_index = err_ptr->token_index;
+
+		// Buffer has an extra character to detect truncation
+		memcpy(errors[i].value, err_ptr->buffer, PARSERLL1_LITERAL_MAX_CHAR);
+		errors[i].value[PARSERLL1_LITERAL_MAX_CHAR] = '\0';
+		errors[i].flag_value_truncated = err_ptr->buffer[err_ptr->len_buffer-2] != '\0';
+	}
+
+	return i;
 }
 
-static void add_error(ParserLL1 *psr_ptr, Token* tkn_ptr, int top_symbol){
+static int add_error(ParserLL1 *psr_ptr, Token* tkn_ptr, int top_symbol){
 	ErrorBuffer *err_ptr = ErrorBuffer_new(psr_ptr, tkn_ptr, top_symbol);
+	if(err_ptr == NULL){
+		// Limit reached earlier, parsing goes on without recording
+		return 0;
+	}
 
 	if(psr_ptr->flag_immediate_print_error)
 		print_error(psr_ptr, err_ptr);
 
-	LinkedList_pushback(psr_ptr->error_list, err_ptr);
+	STATS_ADD(psr_ptr, errors_recorded, 1);
+
+	// Parsing stops if this was the last error allowed
+	return psr_ptr->flag_stop_at_max_errors == 1 && psr_ptr->num_errors == psr_ptr->max_errors;
 }
 
 static void print_error(ParserLL1 *psr_ptr, ErrorBuffer *err_ptr){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
 	int top_symbol = err_ptr->top_symbol;
 	int lookahead_symbol = err_ptr->lookahead_symbol;
-	char *lookahead_symbol_string = psr_ptr->symbol_to_string(lookahead_symbol);
+	char *lookahead_symbol_string = grm_ptr->symbol_to_string(lookahead_symbol);
 	char *buffer = err_ptr->buffer;
 	int len_buffer = err_ptr->len_buffer;
 
@@ -962,20 +3987,18 @@ static void print_error(ParserLL1 *psr_ptr, ErrorBuffer *err_ptr){
 
 	// Print token expected
 	printf("Expected ");
-	if( BitSet_get_bit(psr_ptr->symbol_class_set, top_symbol) == 1){
+	if( get_symbol_flags(grm_ptr, top_symbol) & SYMBOL_FLAG_TERMINAL ){
 		// Top symbol is terminal
-		char *top_symbol_string = psr_ptr->symbol_to_string(top_symbol);
+		char *top_symbol_string = grm_ptr->symbol_to_string(top_symbol);
 		printf("\"" TEXT_BLD TEXT_GRN "%s" TEXT_RST "\"" , top_symbol_string);
 	}
 	else{
-		HashTable *var_row_tbl_ptr = HashTable_get(psr_ptr->parse_table, (void *)&top_symbol);
-
-		for (int i = 0; i < psr_ptr->len_terminal_symbols; ++i){
+		for (int i = 0; i < grm_ptr->len_terminal_symbols; ++i){
 			// Check each terminal
 
-			if( HashTable_get(var_row_tbl_ptr, (void *)&(psr_ptr->terminal_symbols[i]) ) != NULL ){
+			if( get_parse_table_entry(grm_ptr, top_symbol, grm_ptr->terminal_symbols[i]) != -1 ){
 				// Entry exists in parse table
-				char *terminal_symbol_string = psr_ptr->symbol_to_string(psr_ptr->terminal_symbols[i]);
+				char *terminal_symbol_string = grm_ptr->symbol_to_string(grm_ptr->terminal_symbols[i]);
 				printf("\"" TEXT_BLD TEXT_GRN "%s" TEXT_RST "\" " , terminal_symbol_string);
 			}
 		}
@@ -984,6 +4007,172 @@ static void print_error(ParserLL1 *psr_ptr, ErrorBuffer *err_ptr){
 }
 
 
+////////////////////
+// Error recovery //
+////////////////////
+
+void ParserLL1_set_sync_recovery(ParserLL1 *psr_ptr, int val, const int *sync_symbols, int len_sync_symbols){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+	int len_set_words = grm_ptr->len_set_words;
+
+	psr_ptr->flag_sync_recovery = val != 0;
+
+	if(psr_ptr->sync_terminal_row == NULL)
+		psr_ptr->sync_terminal_row = malloc( sizeof(uint64_t) * (len_set_words > 0 ? len_set_words : 1) );
+
+	// Recovery rows start from the declared terminals
+	psr_ptr->len_recovery_rows = 0;
+
+	// Replaces terminals declared earlier
+	memset(psr_ptr->sync_terminal_row, 0, sizeof(uint64_t) * len_set_words);
+	for (int i = 0; i < len_sync_symbols; ++i){
+		if( get_symbol_flags(grm_ptr, sync_symbols[i]) & SYMBOL_FLAG_TERMINAL )
+			set_set_bit(psr_ptr->sync_terminal_row, grm_ptr->symbol_attr_table[sync_symbols[i] - grm_ptr->symbols_min].index);
+	}
+}
+
+static void build_sync_rows(ParserLL1_Grammar *grm_ptr){
+	int len_set_words = grm_ptr->len_set_words;
+	size_t len_rows = (size_t)grm_ptr->len_variable_symbols * len_set_words;
+
+	// Parse table entries of a variable are all in its first or follow set,
+	// so recovery with the variable on top discards any other terminal
+	grm_ptr->sync_rows = malloc( sizeof(uint64_t) * (len_rows > 0 ? len_rows : 1) );
+	if(grm_ptr->sync_rows == NULL)
+		return;
+	memcpy(grm_ptr->sync_rows, grm_ptr->first_rows, sizeof(uint64_t) * len_rows);
+	for (int i = 0; i < grm_ptr->len_variable_symbols; ++i)
+		grm_ptr->or_words(grm_ptr->sync_rows + i * len_set_words, grm_ptr->follow_rows + i * len_set_words, len_set_words);
+}
+
+static inline int skip_recovery_input(ParserLL1 *psr_ptr, Token **tkn_ptrs, const ParserLL1_TokenRecord *records, int len_input){
+	// Input is tokens, or records if tkn_ptrs is NULL. Skips the tokens that
+	// ParserLL1_step would discard one by one without changing the stack,
+	// with the same effect. Incremental mode keeps a record of every step, so
+	// it is left to step
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
+	if(psr_ptr->flag_error_recovery == 0 || psr_ptr->flag_incremental_mode == 1 || psr_ptr->len_stack == 0)
+		return 0;
+
+	StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+	if(top_ent_ptr->symbol_index == STACK_ENTRY_EXIT)
+		return 0;
+
+	// Terminals other than the end symbol are popped by the first token that
+	// does not match. The end symbol stays on top until matched
+	SymbolAttr *top_attr_ptr = &(grm_ptr->symbol_attr_table[top_ent_ptr->symbol - grm_ptr->symbols_min]);
+	uint64_t *sync_row_ptr = NULL;
+	if(top_attr_ptr->flags & SYMBOL_FLAG_TERMINAL){
+		if( (top_attr_ptr->flags & (SYMBOL_FLAG_END | SYMBOL_FLAG_FORGET)) != SYMBOL_FLAG_END )
+			return 0;
+	}
+	else if(psr_ptr->flag_sync_recovery == 1){
+		// Sync recovery stops at more tokens, including all that top stops at
+		sync_row_ptr = get_recovery_row(psr_ptr);
+	}
+	else
+		sync_row_ptr = grm_ptr->sync_rows + top_attr_ptr->index * grm_ptr->len_set_words;
+
+	int i;
+	for (i = 0; i < len_input; ++i){
+		Token *tkn_ptr = tkn_ptrs != NULL ? tkn_ptrs[i] : NULL;
+		int symbol = tkn_ptrs != NULL ? grm_ptr->token_to_symbol(tkn_ptr) : records[i].symbol;
+
+		// Unknown symbols are reported by step
+		if( (get_symbol_flags(grm_ptr, symbol) & SYMBOL_FLAG_TERMINAL) == 0 )
+			break;
+		if(sync_row_ptr == NULL){
+			if(symbol == top_ent_ptr->symbol)
+				break;
+		}
+		else if( set_get_bit(sync_row_ptr, grm_ptr->symbol_attr_table[symbol - grm_ptr->symbols_min].index) == 1 )
+			break;
+
+		psr_ptr->num_tokens++;
+		STATS_ADD(psr_ptr, tokens_consumed, 1);
+		discard_token(psr_ptr, tkn_ptr);
+		STATS_ADD(psr_ptr, tokens_discarded, 1);
+	}
+
+	return i;
+}
+
+static uint64_t *get_recovery_row(ParserLL1 *psr_ptr){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+	int len_set_words = grm_ptr->len_set_words;
+	int len_stack = psr_ptr->len_stack;
+
+	if(len_stack == 0)
+		return psr_ptr->sync_terminal_row;
+
+	if(len_stack > psr_ptr->cap_recovery_rows){
+		// Full, double capacity. Valid rows are kept
+		while(psr_ptr->cap_recovery_rows < len_stack)
+			psr_ptr->cap_recovery_rows = psr_ptr->cap_recovery_rows > 0 ? psr_ptr->cap_recovery_rows * 2 : PARSERLL1_INITIAL_STACK_SIZE;
+		psr_ptr->recovery_rows = realloc( psr_ptr->recovery_rows, sizeof(uint64_t) * len_set_words * psr_ptr->cap_recovery_rows );
+	}
+
+	// Only rows of entries pushed since the last call are built. Recovery
+	// pops, so rows are usually all valid already
+	for (int i = psr_ptr->len_recovery_rows; i < len_stack; ++i){
+		uint64_t *row_ptr = psr_ptr->recovery_rows + (size_t)i * len_set_words;
+		memcpy(row_ptr, i > 0 ? row_ptr - len_set_words : psr_ptr->sync_terminal_row, sizeof(uint64_t) * len_set_words);
+
+		StackEntry *ent_ptr = &(psr_ptr->stack[i]);
+		if(ent_ptr->symbol_index == STACK_ENTRY_EXIT)
+			continue;
+
+		SymbolAttr *attr_ptr = &(grm_ptr->symbol_attr_table[ent_ptr->symbol - grm_ptr->symbols_min]);
+		if(attr_ptr->flags & SYMBOL_FLAG_TERMINAL)
+			set_set_bit(row_ptr, attr_ptr->index);
+		else
+			grm_ptr->or_words(row_ptr, grm_ptr->sync_rows + attr_ptr->index * len_set_words, len_set_words);
+	}
+	if(len_stack > psr_ptr->len_recovery_rows)
+		psr_ptr->len_recovery_rows = len_stack;
+
+	return psr_ptr->recovery_rows + (size_t)(len_stack - 1) * len_set_words;
+}
+
+static int unwind_to_sync(ParserLL1 *psr_ptr, int lookahead_symbol, int lookahead_index){
+	ParserLL1_Grammar *grm_ptr = psr_ptr->grm_ptr;
+
+	// Find topmost symbol that can use lookahead
+	int sync_index;
+	for (sync_index = psr_ptr->len_stack - 1; sync_index >= 0; --sync_index){
+		StackEntry *ent_ptr = &(psr_ptr->stack[sync_index]);
+		if(ent_ptr->symbol_index == STACK_ENTRY_EXIT)
+			continue;
+
+		SymbolAttr *attr_ptr = &(grm_ptr->symbol_attr_table[ent_ptr->symbol - grm_ptr->symbols_min]);
+		if(attr_ptr->flags & SYMBOL_FLAG_TERMINAL){
+			if(ent_ptr->symbol == lookahead_symbol)
+				break;
+		}
+		else if( set_get_bit(grm_ptr->sync_rows + attr_ptr->index * grm_ptr->len_set_words, lookahead_index) == 1 )
+			break;
+	}
+
+	if(sync_index == -1){
+		// Only a declared sync terminal, stack is kept
+		return 0;
+	}
+
+	// Symbols above are missing from input. No need to free popped nodes
+	while(psr_ptr->len_stack > sync_index + 1){
+		StackEntry *top_ent_ptr = &(psr_ptr->stack[psr_ptr->len_stack - 1]);
+		if(top_ent_ptr->symbol_index == STACK_ENTRY_EXIT)
+			emit_event(psr_ptr, PARSERLL1_EVENT_EXIT, top_ent_ptr->symbol, 0, -1, NULL);
+		else
+			node_skip(psr_ptr, top_ent_ptr);
+		psr_ptr->len_stack--;
+	}
+
+	return 1;
+}
+
+
 //////////
 // Hash //
 //////////
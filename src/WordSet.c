@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <pthread.h>
+
+#include "WordSet.h"
+
+#if defined(__GNUC__) && ( defined(__x86_64__) || defined(__i386__) )
+#define WORDSET_X86
+#include <immintrin.h>
+#endif
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static void select_kernels(void);
+
+static int or_words_scalar(uint64_t *dst, const uint64_t *src, int len_words);
+
+#ifdef WORDSET_X86
+static int or_words_sse2(uint64_t *dst, const uint64_t *src, int len_words) __attribute__((target("sse2")));
+
+static int or_words_avx2(uint64_t *dst, const uint64_t *src, int len_words) __attribute__((target("avx2")));
+#endif
+
+
+///////////////
+// Variables //
+///////////////
+
+// Kernel chosen for the CPU, set once by select_kernels
+static WordSet_OrFunction or_words = or_words_scalar;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+
+////////////////
+// Operations //
+////////////////
+
+WordSet_OrFunction WordSet_get_or(void){
+	pthread_once(&kernels_once, select_kernels);
+	return or_words;
+}
+
+
+/////////////
+// Kernels //
+/////////////
+
+static void select_kernels(void){
+#ifdef WORDSET_X86
+	__builtin_cpu_init();
+	if( __builtin_cpu_supports("avx2") )
+		or_words = or_words_avx2;
+	else if( __builtin_cpu_supports("sse2") )
+		or_words = or_words_sse2;
+#endif
+}
+
+static int or_words_scalar(uint64_t *dst, const uint64_t *src, int len_words){
+	// Bits added to dst
+	uint64_t added = 0;
+
+	for (int i = 0; i < len_words; ++i){
+		added |= src[i] & ~dst[i];
+		dst[i] |= src[i];
+	}
+
+	return added != 0;
+}
+
+#ifdef WORDSET_X86
+static int or_words_sse2(uint64_t *dst, const uint64_t *src, int len_words){
+	__m128i added = _mm_setzero_si128();
+	int i = 0;
+
+	for (; i + 2 <= len_words; i += 2){
+		__m128i dst_words = _mm_loadu_si128( (const __m128i *)(dst + i) );
+		__m128i src_words = _mm_loadu_si128( (const __m128i *)(src + i) );
+		added = _mm_or_si128( added, _mm_andnot_si128(dst_words, src_words) );
+		_mm_storeu_si128( (__m128i *)(dst + i), _mm_or_si128(dst_words, src_words) );
+	}
+
+	// All bytes of added are zero if nothing was added
+	int flag_changed = _mm_movemask_epi8( _mm_cmpeq_epi8(added, _mm_setzero_si128()) ) != 0xFFFF;
+
+	return or_words_scalar(dst + i, src + i, len_words - i) | flag_changed;
+}
+
+static int or_words_avx2(uint64_t *dst, const uint64_t *src, int len_words){
+	__m256i added = _mm256_setzero_si256();
+	int i = 0;
+
+	for (; i + 4 <= len_words; i += 4){
+		__m256i dst_words = _mm256_loadu_si256( (const __m256i *)(dst + i) );
+		__m256i src_words = _mm256_loadu_si256( (const __m256i *)(src + i) );
+		added = _mm256_or_si256( added, _mm256_andnot_si256(dst_words, src_words) );
+		_mm256_storeu_si256( (__m256i *)(dst + i), _mm256_or_si256(dst_words, src_words) );
+	}
+
+	int flag_changed = _mm256_testz_si256(added, added) == 0;
+
+	return or_words_scalar(dst + i, src + i, len_words - i) | flag_changed;
+}
+#endif
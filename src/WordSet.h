@@ -0,0 +1,61 @@
+#ifndef INCLUDE_GUARD_A3C81F5E27D94B06B4E9D2F7168C0E5B
+#define INCLUDE_GUARD_A3C81F5E27D94B06B4E9D2F7168C0E5B
+
+#include <stdint.h>
+
+/**
+ * Sets of small integers stored as rows of 64 bit words, where bit i of the
+ * set is bit (i % 64) of word (i / 64)
+ */
+
+/**
+ * Adds all members of @p src to @p dst
+ * @param dst       Row of @p len_words words, updated in place
+ * @param src       Row of @p len_words words
+ * @param len_words Number of words in each row
+ * @return 1 if @p dst gained a member, 0 otherwise
+ */
+typedef int (*WordSet_OrFunction)(uint64_t *dst, const uint64_t *src, int len_words);
+
+/**
+ * Returns the union kernel for the CPU, using AVX2 or SSE2 when supported.
+ * The CPU is checked once, at first call. Callers keep the kernel and call it
+ * directly, rather than calling this for each union
+ * @return Kernel adding the members of one row to another
+ */
+WordSet_OrFunction WordSet_get_or(void);
+
+/**
+ * Finds the smallest member of @p set that is at least @p from. Members can be
+ * visited in order with
+ * for(i = WordSet_next(set, len_words, 0); i != -1; i = WordSet_next(set, len_words, i + 1))
+ * @param set       Row of @p len_words words
+ * @param len_words Number of words in row
+ * @param from      Smallest member to consider
+ * @return Member, -1 if there is none
+ */
+static inline int WordSet_next(const uint64_t *set, int len_words, int from){
+	int word_index = from >> 6;
+	if(word_index >= len_words)
+		return -1;
+
+	// Ignore members below from in first word
+	uint64_t word = set[word_index] & (~(uint64_t)0 << (from & 63));
+
+	while(word == 0){
+		if(++word_index == len_words)
+			return -1;
+		word = set[word_index];
+	}
+
+#if defined(__GNUC__)
+	return (word_index << 6) + __builtin_ctzll(word);
+#else
+	int bit_index = 0;
+	while( ((word >> bit_index) & 1) == 0 )
+		bit_index++;
+	return (word_index << 6) + bit_index;
+#endif
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "WorkPool.h"
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+typedef struct WorkQueue{
+	pthread_mutex_t lock;
+
+	// Tasks in [head, tail) are pending. Owner takes from tail, thieves take
+	// from head
+	int head;
+	int tail;
+}WorkQueue;
+
+typedef struct WorkPool{
+	WorkQueue *queues;
+	int num_threads;
+
+	void (*run_task)(void *ctx, int thread_index, int task_index);
+	void *ctx;
+}WorkPool;
+
+typedef struct Worker{
+	WorkPool *pool_ptr;
+	int thread_index;
+}Worker;
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static void *worker_main(void *arg);
+
+static int take_task(WorkPool *pool_ptr, int thread_index);
+
+static int steal_tasks(WorkPool *pool_ptr, int thread_index);
+
+
+/////////
+// Run //
+/////////
+
+void WorkPool_run(int len_tasks, int num_threads, void (*run_task)(void *ctx, int thread_index, int task_index), void *ctx){
+	if(num_threads > len_tasks)
+		num_threads = len_tasks;
+
+	if(num_threads < 2){
+		// Not worth starting threads
+		for (int i = 0; i < len_tasks; ++i)
+			run_task(ctx, 0, i);
+		return;
+	}
+
+	WorkPool pool;
+	pool.num_threads = num_threads;
+	pool.run_task = run_task;
+	pool.ctx = ctx;
+
+	// Split tasks evenly
+	pool.queues = malloc( sizeof(WorkQueue) * num_threads );
+	for (int i = 0; i < num_threads; ++i){
+		pthread_mutex_init(&(pool.queues[i].lock), NULL);
+		pool.queues[i].head = (int)( (long long)len_tasks * i / num_threads );
+		pool.queues[i].tail = (int)( (long long)len_tasks * (i + 1) / num_threads );
+	}
+
+	Worker *workers = malloc( sizeof(Worker) * num_threads );
+	pthread_t *threads = malloc( sizeof(pthread_t) * num_threads );
+	char *flags_started = calloc(num_threads, sizeof(char));
+
+	for (int i = 0; i < num_threads; ++i){
+		workers[i].pool_ptr = &pool;
+		workers[i].thread_index = i;
+	}
+
+	// Calling thread is worker 0. Tasks of a thread which fails to start are
+	// stolen by the running ones
+	for (int i = 1; i < num_threads; ++i){
+		if(pthread_create(&threads[i], NULL, worker_main, &workers[i]) == 0)
+			flags_started[i] = 1;
+	}
+	worker_main(&workers[0]);
+	for (int i = 1; i < num_threads; ++i){
+		if(flags_started[i] == 1)
+			pthread_join(threads[i], NULL);
+	}
+
+	for (int i = 0; i < num_threads; ++i)
+		pthread_mutex_destroy(&(pool.queues[i].lock));
+
+	free(flags_started);
+	free(threads);
+	free(workers);
+	free(pool.queues);
+}
+
+static void *worker_main(void *arg){
+	Worker *wkr_ptr = arg;
+	WorkPool *pool_ptr = wkr_ptr->pool_ptr;
+
+	while(1){
+		int task_index = take_task(pool_ptr, wkr_ptr->thread_index);
+
+		if(task_index == -1){
+			// Own queue empty, refill from another thread
+			if(steal_tasks(pool_ptr, wkr_ptr->thread_index) == 0){
+				// Nothing left anywhere
+				break;
+			}
+			continue;
+		}
+
+		pool_ptr->run_task(pool_ptr->ctx, wkr_ptr->thread_index, task_index);
+	}
+
+	return NULL;
+}
+
+static int take_task(WorkPool *pool_ptr, int thread_index){
+	WorkQueue *que_ptr = &(pool_ptr->queues[thread_index]);
+	int task_index = -1;
+
+	pthread_mutex_lock(&(que_ptr->lock));
+	if(que_ptr->head < que_ptr->tail){
+		que_ptr->tail--;
+		task_index = que_ptr->tail;
+	}
+	pthread_mutex_unlock(&(que_ptr->lock));
+
+	return task_index;
+}
+
+static int steal_tasks(WorkPool *pool_ptr, int thread_index){
+	for (int i = 1; i < pool_ptr->num_threads; ++i){
+		// Visit other threads starting from the next one
+		WorkQueue *vic_ptr = &(pool_ptr->queues[(thread_index + i) % pool_ptr->num_threads]);
+		int head, tail;
+
+		// Take front half of remaining tasks, at least one
+		pthread_mutex_lock(&(vic_ptr->lock));
+		head = vic_ptr->head;
+		tail = head + (vic_ptr->tail - vic_ptr->head + 1) / 2;
+		vic_ptr->head = tail;
+		pthread_mutex_unlock(&(vic_ptr->lock));
+
+		if(head < tail){
+			WorkQueue *que_ptr = &(pool_ptr->queues[thread_index]);
+
+			pthread_mutex_lock(&(que_ptr->lock));
+			que_ptr->head = head;
+			que_ptr->tail = tail;
+			pthread_mutex_unlock(&(que_ptr->lock));
+
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef INCLUDE_GUARD_6D2A94C1E0B34F7D9A1E5C3B8F0D2E47
+#define INCLUDE_GUARD_6D2A94C1E0B34F7D9A1E5C3B8F0D2E47
+
+/**
+ * Runs @p run_task once for each task index in [0, @p len_tasks) on
+ * @p num_threads threads and returns when all tasks are done. Tasks are split
+ * evenly between threads, and a thread which runs out of tasks steals half of
+ * the remaining tasks of another thread. The calling thread is used as one of
+ * the threads
+ * @param len_tasks   Number of tasks
+ * @param num_threads Number of threads to use. Values less than 2 run all tasks
+ * on the calling thread
+ * @param run_task    Called with @p ctx, the index of the thread running the
+ * task in [0, @p num_threads), and the task index
+ * @param ctx         Passed to @p run_task
+ */
+void WorkPool_run(int len_tasks, int num_threads, void (*run_task)(void *ctx, int thread_index, int task_index), void *ctx);
+
+#endif
@@ -0,0 +1,52 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ParserLL1.h"
+#include "bench_grammars.h"
+
+// Writes parsers generated from the benchmark grammars, compiled into
+// test_generated.
+// Usage: generate_parsers <output directory>
+//
+// Writes <output directory>/<grammar>_parser.c for each grammar, with
+// identifiers prefixed by the grammar name. Exits with 1 if a file could not
+// be written.
+
+
+//////////
+// Main //
+//////////
+
+int main(int argc, char **argv){
+	if(argc != 2){
+		printf("Usage: generate_parsers <output directory>\n");
+		return 1;
+	}
+
+	// Same grammars as test_generated
+	BenchGrammar *bgr_ptrs[] = {
+		BenchGrammar_new_expression(),
+		BenchGrammar_new_json(),
+		BenchGrammar_new_generated(10, 1),
+		BenchGrammar_new_generated(100, 3)
+	};
+	int len_bgr_ptrs = sizeof(bgr_ptrs) / sizeof(BenchGrammar *);
+	int num_failures = 0;
+
+	for (int i = 0; i < len_bgr_ptrs; ++i){
+		ParserLL1_Grammar *grm_ptr = BenchGrammar_build(bgr_ptrs[i]);
+		ParserLL1_Grammar_initialize_rules(grm_ptr);
+
+		char path[4096];
+		snprintf(path, sizeof(path), "%s/%s_parser.c", argv[1], bgr_ptrs[i]->name);
+		if(ParserLL1_Grammar_generate_c(grm_ptr, path, bgr_ptrs[i]->name) != 0){
+			printf("%s: could not write %s\n", bgr_ptrs[i]->name, path);
+			num_failures++;
+		}
+
+		ParserLL1_Grammar_destroy(grm_ptr);
+		BenchGrammar_destroy(bgr_ptrs[i]);
+	}
+
+	return num_failures > 0;
+}
@@ -0,0 +1,6 @@
+// Generated json parser, with tokens mapped to symbols as by token_to_symbol
+// of test_generated, but without calling it
+
+#define PARSERLL1_TOKEN_TO_SYMBOL(psr_ptr, tkn_ptr) ((tkn_ptr)->column)
+
+#include "json_parser.c"
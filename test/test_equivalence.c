@@ -0,0 +1,935 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ParserLL1.h"
+#include "Token.h"
+#include "bench_grammars.h"
+
+// Parses the same inputs in two ways that must give the same result, and
+// compares status, parse tree and errors:
+// - ParserLL1_reparse after each edit, against parsing the new input from the
+//   start
+// - ParserLL1_parse_document_chunked, against ParserLL1_parse_tokens
+// - Flat mode and event mode, against arena mode
+// - Grammars loaded from an image, against the grammar that was saved
+// - ParserLL1_restore after speculative input, against parsing without it
+// - The batched error recovery of ParserLL1_parse_tokens,
+//   ParserLL1_parse_records and ParserLL1_run, against ParserLL1_step on each
+//   token
+// Usage: test_equivalence
+//
+// Prints each comparison that differs, and exits with 1 if any did.
+
+
+///////////////
+// Constants //
+///////////////
+
+// Inputs generated for each grammar and test
+#define NUM_RUNS 8
+
+// Symbols of generated inputs
+#define INPUT_SYMBOLS 2000
+
+// Edits applied to each input by the reparse test
+#define NUM_EDITS 40
+
+// Symbols of inputs to the chunked test, enough for several chunks per thread
+#define CHUNKED_INPUT_SYMBOLS 100000
+#define CHUNKED_THREADS 4
+
+// Image file written by the image test, in the working directory
+#define IMAGE_PATH "test_equivalence_image.bin"
+
+// Statement list grammar for the chunked test. Terminals first
+enum{
+	SYMBOL_ID = 1,
+	SYMBOL_ASSIGN,
+	SYMBOL_SEMICOLON,
+	SYMBOL_LEFT_BRACE,
+	SYMBOL_RIGHT_BRACE,
+	SYMBOL_LEFT_PAREN,
+	SYMBOL_RIGHT_PAREN,
+	SYMBOL_END,
+	SYMBOL_START,
+	SYMBOL_LIST,
+	SYMBOL_ITEM,
+	SYMBOL_EXPRESSION,
+	SYMBOL_EMPTY
+};
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+// Serialized tree or errors, compared as a whole
+typedef struct IntBuffer{
+	int *values;
+	int len_values;
+	int cap_values;
+}IntBuffer;
+
+// Nodes of a tree rebuilt from events, in the form of serialize_nodes
+typedef struct EventTree{
+	IntBuffer buf;
+	int depth;
+}EventTree;
+
+// Token source for ParserLL1_run
+typedef struct TokenSource{
+	Token **tkn_ptrs;
+	int len_tkn_ptrs;
+	int pos;
+}TokenSource;
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static void buffer_push(IntBuffer *buf_ptr, int value);
+static void serialize_arena_tree(ParserLL1_Node *root_node_ptr, int flag_token_index, IntBuffer *buf_ptr);
+static void serialize_parse_tree(ParseTree_Node *root_node_ptr, IntBuffer *buf_ptr);
+static void serialize_flat_tree(ParserLL1_FlatTree *ft_ptr, IntBuffer *buf_ptr);
+static void serialize_nodes(ParserLL1_Node *root_node_ptr, IntBuffer *buf_ptr);
+static void serialize_flat_nodes(ParserLL1_FlatTree *ft_ptr, IntBuffer *buf_ptr);
+static void serialize_errors(const ParserLL1_Error *errors, int len_errors, IntBuffer *buf_ptr);
+static void serialize_parser_errors(ParserLL1 *psr_ptr, IntBuffer *buf_ptr);
+static int check(int flag_same, const char *test_name, const char *grammar_name, int run);
+static int check_buffers(IntBuffer *buf_ptrs, const char *test_name, const char *grammar_name, int run);
+static int random_terminal(BenchGrammar *bgr_ptr, unsigned int *seed);
+static void corrupt(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, int interval, unsigned int *seed);
+static int next_tokens(void *ctx, Token **tkn_ptrs, int len_tkn_ptrs);
+static void add_event(ParserLL1_Event *evt_ptr, void *ctx);
+static int token_to_symbol(Token *tkn_ptr);
+static char *symbol_to_string(int symbol);
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer);
+static int generate_statements(int *symbols, int len_symbols, int depth, unsigned int *seed);
+
+static int test_reparse(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+static int test_checkpoint(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+static int test_recovery_skip(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+static int test_chunked(void);
+static int test_tree_modes(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+static int test_image(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr);
+
+
+/////////////
+// Helpers //
+/////////////
+
+static void buffer_push(IntBuffer *buf_ptr, int value){
+	if(buf_ptr->len_values == buf_ptr->cap_values){
+		buf_ptr->cap_values = buf_ptr->cap_values > 0 ? buf_ptr->cap_values * 2 : 1024;
+		buf_ptr->values = realloc( buf_ptr->values, sizeof(int) * buf_ptr->cap_values );
+	}
+
+	buf_ptr->values[buf_ptr->len_values++] = value;
+}
+
+// Nodes in preorder with their depth. Walks with parent links, as long lists
+// make trees too deep for recursion. Tokens are given by their position, or
+// by their symbol for trees edited by ParserLL1_reparse, which does not
+// update positions
+static void serialize_arena_tree(ParserLL1_Node *root_node_ptr, int flag_token_index, IntBuffer *buf_ptr){
+	ParserLL1_Node *node_ptr = root_node_ptr;
+	int depth = 0;
+
+	while(node_ptr != NULL){
+		buffer_push(buf_ptr, depth);
+		buffer_push(buf_ptr, node_ptr->symbol);
+		buffer_push(buf_ptr, node_ptr->rule_num);
+		buffer_push(buf_ptr, node_ptr->symbol_index);
+		if(flag_token_index == 1)
+			buffer_push(buf_ptr, node_ptr->token_index);
+		else
+			buffer_push(buf_ptr, node_ptr->tkn_ptr != NULL ? node_ptr->tkn_ptr->column : -1);
+
+		if(node_ptr->first_child != NULL){
+			node_ptr = node_ptr->first_child;
+			depth++;
+			continue;
+		}
+
+		while(node_ptr != root_node_ptr && node_ptr->next_sibling == NULL){
+			node_ptr = node_ptr->parent;
+			depth--;
+		}
+		node_ptr = node_ptr != root_node_ptr ? node_ptr->next_sibling : NULL;
+	}
+}
+
+static void serialize_parse_tree(ParseTree_Node *root_node_ptr, IntBuffer *buf_ptr){
+	ParseTree_Node *node_ptr = root_node_ptr;
+	int depth = 0;
+
+	while(node_ptr != NULL){
+		buffer_push(buf_ptr, depth);
+		buffer_push(buf_ptr, node_ptr->symbol);
+		buffer_push(buf_ptr, node_ptr->rule_num);
+		buffer_push(buf_ptr, node_ptr->symbol_index);
+		buffer_push(buf_ptr, node_ptr->tkn_ptr != NULL ? node_ptr->tkn_ptr->line : -1);
+
+		if(node_ptr->first_child != NULL){
+			node_ptr = node_ptr->first_child;
+			depth++;
+			continue;
+		}
+
+		while(node_ptr != root_node_ptr && node_ptr->next_sibling == NULL){
+			node_ptr = node_ptr->parent;
+			depth--;
+		}
+		node_ptr = node_ptr != root_node_ptr ? node_ptr->next_sibling : NULL;
+	}
+}
+
+static void serialize_flat_tree(ParserLL1_FlatTree *ft_ptr, IntBuffer *buf_ptr){
+	if(ft_ptr == NULL){
+		buffer_push(buf_ptr, -1);
+		return;
+	}
+
+	buffer_push(buf_ptr, ft_ptr->len_nodes);
+	for (int i = 0; i < ft_ptr->len_nodes; ++i){
+		buffer_push(buf_ptr, ft_ptr->symbols[i]);
+		buffer_push(buf_ptr, ft_ptr->rule_nums[i]);
+		buffer_push(buf_ptr, ft_ptr->symbol_indices[i]);
+		buffer_push(buf_ptr, ft_ptr->token_indices[i]);
+		buffer_push(buf_ptr, ft_ptr->subtree_sizes[i]);
+		buffer_push(buf_ptr, ft_ptr->parents[i]);
+		buffer_push(buf_ptr, ft_ptr->tkn_ptrs[i] != NULL);
+	}
+}
+
+// Nodes in preorder as depth, symbol, rule, symbol index and token position,
+// the attributes all tree modes have
+static void serialize_nodes(ParserLL1_Node *root_node_ptr, IntBuffer *buf_ptr){
+	ParserLL1_Node *node_ptr = root_node_ptr;
+	int depth = 0;
+
+	while(node_ptr != NULL){
+		buffer_push(buf_ptr, depth);
+		buffer_push(buf_ptr, node_ptr->symbol);
+		buffer_push(buf_ptr, node_ptr->rule_num);
+		buffer_push(buf_ptr, node_ptr->symbol_index);
+		buffer_push(buf_ptr, node_ptr->token_index);
+
+		if(node_ptr->first_child != NULL){
+			node_ptr = node_ptr->first_child;
+			depth++;
+			continue;
+		}
+
+		while(node_ptr != root_node_ptr && node_ptr->next_sibling == NULL){
+			node_ptr = node_ptr->parent;
+			depth--;
+		}
+		node_ptr = node_ptr != root_node_ptr ? node_ptr->next_sibling : NULL;
+	}
+}
+
+// Flat tree in the form of serialize_nodes. Parents come before their
+// children, so depths are found in one pass
+static void serialize_flat_nodes(ParserLL1_FlatTree *ft_ptr, IntBuffer *buf_ptr){
+	int *depths = malloc( sizeof(int) * (ft_ptr->len_nodes > 0 ? ft_ptr->len_nodes : 1) );
+
+	for (int i = 0; i < ft_ptr->len_nodes; ++i){
+		depths[i] = ft_ptr->parents[i] >= 0 ? depths[ft_ptr->parents[i]] + 1 : 0;
+
+		buffer_push(buf_ptr, depths[i]);
+		buffer_push(buf_ptr, ft_ptr->symbols[i]);
+		buffer_push(buf_ptr, ft_ptr->rule_nums[i]);
+		buffer_push(buf_ptr, ft_ptr->symbol_indices[i]);
+		buffer_push(buf_ptr, ft_ptr->token_indices[i]);
+	}
+
+	free(depths);
+}
+
+static void serialize_errors(const ParserLL1_Error *errors, int len_errors, IntBuffer *buf_ptr){
+	buffer_push(buf_ptr, len_errors);
+	for (int i = 0; i < len_errors; ++i){
+		buffer_push(buf_ptr, errors[i].token_index);
+		buffer_push(buf_ptr, errors[i].lookahead_symbol);
+		buffer_push(buf_ptr, errors[i].top_symbol);
+	}
+}
+
+static void serialize_parser_errors(ParserLL1 *psr_ptr, IntBuffer *buf_ptr){
+	int len_errors = ParserLL1_get_num_errors(psr_ptr);
+	ParserLL1_Error *errors = malloc( sizeof(ParserLL1_Error) * (len_errors > 0 ? len_errors : 1) );
+	len_errors = ParserLL1_get_errors(psr_ptr, errors, len_errors);
+
+	serialize_errors(errors, len_errors, buf_ptr);
+	free(errors);
+}
+
+// Returns 1 and prints the comparison if it failed
+static int check(int flag_same, const char *test_name, const char *grammar_name, int run){
+	if(flag_same == 1)
+		return 0;
+
+	printf("%s: %s run %d differs\n", test_name, grammar_name, run);
+	return 1;
+}
+
+// Compares and frees the pair of buffers, as check
+static int check_buffers(IntBuffer *buf_ptrs, const char *test_name, const char *grammar_name, int run){
+	int flag_same = buf_ptrs[0].len_values == buf_ptrs[1].len_values && (buf_ptrs[0].len_values == 0 || memcmp(buf_ptrs[0].values, buf_ptrs[1].values, sizeof(int) * buf_ptrs[0].len_values) == 0);
+
+	for (int i = 0; i < 2; ++i){
+		free(buf_ptrs[i].values);
+		buf_ptrs[i] = (IntBuffer){NULL, 0, 0};
+	}
+
+	return check(flag_same, test_name, grammar_name, run);
+}
+
+static int random_terminal(BenchGrammar *bgr_ptr, unsigned int *seed){
+	int symbol;
+	do{
+		symbol = bgr_ptr->terminal_symbols[rand_r(seed) % bgr_ptr->len_terminal_symbols];
+	}while(symbol == bgr_ptr->end_symbol);
+
+	return symbol;
+}
+
+// Replaces symbols at random intervals, keeping the end symbol
+static void corrupt(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, int interval, unsigned int *seed){
+	for (int i = 1 + rand_r(seed) % interval; i < len_symbols - 1; i += 1 + rand_r(seed) % interval)
+		symbols[i] = random_terminal(bgr_ptr, seed);
+}
+
+// Gives tokens in small batches of uneven size
+static int next_tokens(void *ctx, Token **tkn_ptrs, int len_tkn_ptrs){
+	TokenSource *src_ptr = ctx;
+
+	int len = 0;
+	while(len < len_tkn_ptrs && len < 37 && src_ptr->pos < src_ptr->len_tkn_ptrs)
+		tkn_ptrs[len++] = src_ptr->tkn_ptrs[src_ptr->pos++];
+
+	return len;
+}
+
+// Appends nodes in the form of serialize_nodes. Events give the lookahead
+// position for skipped terminals, where trees have none
+static void add_event(ParserLL1_Event *evt_ptr, void *ctx){
+	EventTree *evt_tree_ptr = ctx;
+
+	if(evt_ptr->type == PARSERLL1_EVENT_EXIT){
+		evt_tree_ptr->depth--;
+		return;
+	}
+
+	int flag_token = evt_ptr->type == PARSERLL1_EVENT_TOKEN && evt_ptr->rule_num == 0;
+	buffer_push(&(evt_tree_ptr->buf), evt_tree_ptr->depth);
+	buffer_push(&(evt_tree_ptr->buf), evt_ptr->symbol);
+	buffer_push(&(evt_tree_ptr->buf), evt_ptr->rule_num);
+	buffer_push(&(evt_tree_ptr->buf), evt_ptr->symbol_index);
+	buffer_push(&(evt_tree_ptr->buf), flag_token == 1 ? evt_ptr->token_index : -1);
+
+	if(evt_ptr->type == PARSERLL1_EVENT_ENTER)
+		evt_tree_ptr->depth++;
+	if(evt_ptr->tkn_ptr != NULL)
+		Token_destroy(evt_ptr->tkn_ptr);
+}
+
+static int token_to_symbol(Token *tkn_ptr){
+	return tkn_ptr->column;
+}
+
+static char *symbol_to_string(int symbol){
+	(void)symbol;
+	return "symbol";
+}
+
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer){
+	(void)tkn_ptr;
+	if(len_buffer > 0)
+		buffer[0] = '\0';
+}
+
+// Fills symbols with statements ending in semicolons, and blocks of
+// statements. Returns number of symbols written
+static int generate_statements(int *symbols, int len_symbols, int depth, unsigned int *seed){
+	int len = 0;
+
+	if(depth < 3 && rand_r(seed) % 6 == 0 && len_symbols >= 2){
+		symbols[len++] = SYMBOL_LEFT_BRACE;
+		for (int i = rand_r(seed) % 40; i > 0 && len_symbols - len > 16; --i)
+			len += generate_statements(symbols + len, len_symbols - len - 1, depth + 1, seed);
+		symbols[len++] = SYMBOL_RIGHT_BRACE;
+		return len;
+	}
+
+	int num_parens = rand_r(seed) % 3;
+	symbols[len++] = SYMBOL_ID;
+	symbols[len++] = SYMBOL_ASSIGN;
+	for (int i = 0; i < num_parens; ++i)
+		symbols[len++] = SYMBOL_LEFT_PAREN;
+	symbols[len++] = SYMBOL_ID;
+	for (int i = 0; i < num_parens; ++i)
+		symbols[len++] = SYMBOL_RIGHT_PAREN;
+	symbols[len++] = SYMBOL_SEMICOLON;
+
+	return len;
+}
+
+
+///////////
+// Tests //
+///////////
+
+// Edits one input repeatedly. After each edit, the reparsed tree must match
+// a parser that processed the new input from the start
+static int test_reparse(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	int num_failures = 0;
+
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 100 + run;
+		int cap_symbols = INPUT_SYMBOLS + 4 * NUM_EDITS;
+		int *symbols = malloc( sizeof(int) * cap_symbols );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		if(run % 2 == 1)
+			corrupt(bgr_ptr, symbols, len_symbols, 200, &seed);
+
+		ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+		ParserLL1_set_incremental_mode(psr_ptr);
+		if(run % 4 == 3)
+			ParserLL1_set_sync_recovery(psr_ptr, 1, NULL, 0);
+
+		Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+		for (int i = 0; i < len_symbols; ++i)
+			ParserLL1_step(psr_ptr, tkn_ptrs[i]);
+		free(tkn_ptrs);
+
+		for (int edit = 0; edit < NUM_EDITS; ++edit){
+			int edit_index = rand_r(&seed) % (len_symbols + 1);
+			int len_removed = rand_r(&seed) % 4;
+			if(edit_index + len_removed > len_symbols)
+				len_removed = len_symbols - edit_index;
+			int len_inserted = rand_r(&seed) % 4;
+
+			int inserted[4];
+			for (int i = 0; i < len_inserted; ++i)
+				inserted[i] = random_terminal(bgr_ptr, &seed);
+
+			memmove(symbols + edit_index + len_inserted, symbols + edit_index + len_removed, sizeof(int) * (len_symbols - edit_index - len_removed));
+			memcpy(symbols + edit_index, inserted, sizeof(int) * len_inserted);
+			len_symbols += len_inserted - len_removed;
+
+			tkn_ptrs = bench_new_tokens(inserted, len_inserted);
+			Parser_StepResult_type result = ParserLL1_reparse(psr_ptr, edit_index, len_removed, tkn_ptrs, len_inserted);
+			free(tkn_ptrs);
+
+			ParserLL1 *ref_psr_ptr = ParserLL1_new_session(grm_ptr);
+			ParserLL1_set_incremental_mode(ref_psr_ptr);
+			if(run % 4 == 3)
+				ParserLL1_set_sync_recovery(ref_psr_ptr, 1, NULL, 0);
+
+			Parser_StepResult_type ref_result = PARSER_STEP_RESULT_MORE_INPUT;
+			tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+			for (int i = 0; i < len_symbols; ++i)
+				ref_result = ParserLL1_step(ref_psr_ptr, tkn_ptrs[i]);
+			free(tkn_ptrs);
+
+			IntBuffer bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+			ParserLL1 *psr_ptrs[2] = {psr_ptr, ref_psr_ptr};
+			for (int i = 0; i < 2; ++i){
+				serialize_arena_tree(ParserLL1_get_arena_tree(psr_ptrs[i]), 0, &bufs[i]);
+				serialize_parser_errors(psr_ptrs[i], &bufs[i]);
+			}
+
+			int len_failures = check(result == ref_result, "reparse status", bgr_ptr->name, run);
+			len_failures += check_buffers(bufs, "reparse", bgr_ptr->name, run);
+			num_failures += len_failures;
+
+			ParserLL1_destroy(ref_psr_ptr);
+
+			// Later edits build on a wrong parse
+			if(len_failures > 0)
+				break;
+		}
+
+		ParserLL1_destroy(psr_ptr);
+		free(symbols);
+	}
+
+	return num_failures;
+}
+
+// Saves a checkpoint, parses other input and restores, possibly more than
+// once, then parses the rest. Must match parsing the input without detours
+static int test_checkpoint(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	int num_failures = 0;
+
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 200 + run;
+		int flag_flat_mode = run % 2;
+
+		int *symbols = malloc( sizeof(int) * INPUT_SYMBOLS );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		if(run % 4 >= 2)
+			corrupt(bgr_ptr, symbols, len_symbols, 100, &seed);
+
+		int len_detour = 1 + rand_r(&seed) % 200;
+		int *detour = malloc( sizeof(int) * len_detour );
+		for (int i = 0; i < len_detour; ++i)
+			detour[i] = random_terminal(bgr_ptr, &seed);
+
+		ParserLL1 *psr_ptrs[2];
+		Parser_StepResult_type results[2];
+		for (int i = 0; i < 2; ++i){
+			psr_ptrs[i] = ParserLL1_new_session(grm_ptr);
+			if(flag_flat_mode == 1)
+				ParserLL1_set_flat_mode(psr_ptrs[i]);
+			else
+				ParserLL1_set_arena_mode(psr_ptrs[i], 64);
+		}
+
+		int stop_index;
+		Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+		results[0] = ParserLL1_parse_tokens(psr_ptrs[0], tkn_ptrs, len_symbols, &stop_index);
+		for (int i = stop_index; i < len_symbols; ++i)
+			Token_destroy(tkn_ptrs[i]);
+		free(tkn_ptrs);
+
+		// Prefix, checkpoint, detour, restore, part of the rest, restore again
+		// and the rest. Tokens that are not processed are still owned here
+		int len_prefix = rand_r(&seed) % len_symbols;
+		tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+		ParserLL1_parse_tokens(psr_ptrs[1], tkn_ptrs, len_prefix, &stop_index);
+		for (int i = stop_index; i < len_prefix; ++i)
+			Token_destroy(tkn_ptrs[i]);
+
+		ParserLL1_Checkpoint *chk_ptr = ParserLL1_checkpoint(psr_ptrs[1]);
+
+		Token **detour_tkn_ptrs = bench_new_tokens(detour, len_detour);
+		ParserLL1_parse_tokens(psr_ptrs[1], detour_tkn_ptrs, len_detour, &stop_index);
+		for (int i = stop_index; i < len_detour; ++i)
+			Token_destroy(detour_tkn_ptrs[i]);
+		free(detour_tkn_ptrs);
+		ParserLL1_restore(psr_ptrs[1], chk_ptr);
+
+		Token **again_tkn_ptrs = bench_new_tokens(symbols + len_prefix, (len_symbols - len_prefix) / 2);
+		ParserLL1_parse_tokens(psr_ptrs[1], again_tkn_ptrs, (len_symbols - len_prefix) / 2, &stop_index);
+		for (int i = stop_index; i < (len_symbols - len_prefix) / 2; ++i)
+			Token_destroy(again_tkn_ptrs[i]);
+		free(again_tkn_ptrs);
+		ParserLL1_restore(psr_ptrs[1], chk_ptr);
+
+		results[1] = ParserLL1_parse_tokens(psr_ptrs[1], tkn_ptrs + len_prefix, len_symbols - len_prefix, &stop_index);
+		for (int i = len_prefix + stop_index; i < len_symbols; ++i)
+			Token_destroy(tkn_ptrs[i]);
+		free(tkn_ptrs);
+		ParserLL1_Checkpoint_destroy(chk_ptr);
+
+		// Token positions count from the parser start, so the restored parser
+		// has the same ones
+		IntBuffer bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+		for (int i = 0; i < 2; ++i){
+			if(flag_flat_mode == 1){
+				ParserLL1_FlatTree *ft_ptr = ParserLL1_get_flat_tree(psr_ptrs[i]);
+				serialize_flat_tree(ft_ptr, &bufs[i]);
+				ParserLL1_FlatTree_destroy(ft_ptr);
+			}
+			else{
+				serialize_arena_tree(ParserLL1_get_arena_tree(psr_ptrs[i]), 1, &bufs[i]);
+			}
+			serialize_parser_errors(psr_ptrs[i], &bufs[i]);
+		}
+
+		num_failures += check(results[0] == results[1], "checkpoint status", bgr_ptr->name, run);
+		num_failures += check_buffers(bufs, "checkpoint", bgr_ptr->name, run);
+
+		for (int i = 0; i < 2; ++i)
+			ParserLL1_destroy(psr_ptrs[i]);
+		free(symbols);
+		free(detour);
+	}
+
+	return num_failures;
+}
+
+// Discards tokens after errors in batches, which must match ParserLL1_step
+// discarding them one at a time, with and without sync recovery
+static int test_recovery_skip(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	int num_failures = 0;
+
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 300 + run;
+		int flag_sync_recovery = run % 2;
+		int sync_symbols[2] = {bgr_ptr->terminal_symbols[0], bgr_ptr->terminal_symbols[bgr_ptr->len_terminal_symbols / 2]};
+
+		int *symbols = malloc( sizeof(int) * INPUT_SYMBOLS );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		corrupt(bgr_ptr, symbols, len_symbols, run < NUM_RUNS / 2 ? 50 : 4, &seed);
+
+		ParserLL1_TokenRecord *records = calloc(len_symbols, sizeof(ParserLL1_TokenRecord));
+		for (int i = 0; i < len_symbols; ++i)
+			records[i].symbol = symbols[i];
+
+		// Step on each token first, then each batched call
+		IntBuffer bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+		Parser_StepResult_type ref_result = PARSER_STEP_RESULT_MORE_INPUT;
+		int ref_stop_index = 0;
+
+		for (int how = 0; how < 4; ++how){
+			ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+			ParserLL1_set_arena_mode(psr_ptr, 0);
+			ParserLL1_set_sync_recovery(psr_ptr, flag_sync_recovery, sync_symbols, 2);
+
+			Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+			Parser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;
+			int stop_index = 0;
+
+			if(how == 0){
+				while(stop_index < len_symbols && result != PARSER_STEP_RESULT_SUCCESS && result != PARSER_STEP_RESULT_HALTED && result != PARSER_STEP_RESULT_UNKNOWN_INPUT)
+					result = ParserLL1_step(psr_ptr, tkn_ptrs[stop_index++]);
+			}
+			else if(how == 1){
+				result = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_symbols, &stop_index);
+			}
+			else if(how == 2){
+				result = ParserLL1_parse_records(psr_ptr, records, len_symbols, NULL, &stop_index);
+				stop_index = 0;
+			}
+			else{
+				// Pulled tokens belong to the parser
+				TokenSource src = {tkn_ptrs, len_symbols, 0};
+				result = ParserLL1_run(psr_ptr, next_tokens, &src);
+				stop_index = src.pos;
+			}
+
+			for (int i = stop_index; i < len_symbols; ++i)
+				Token_destroy(tkn_ptrs[i]);
+			free(tkn_ptrs);
+
+			// Records give no tokens, so tokens are compared by position
+			IntBuffer *buf_ptr = &bufs[how == 0 ? 0 : 1];
+			serialize_arena_tree(ParserLL1_get_arena_tree(psr_ptr), 1, buf_ptr);
+			serialize_parser_errors(psr_ptr, buf_ptr);
+
+			if(how == 0){
+				ref_result = result;
+				ref_stop_index = stop_index;
+			}
+			else{
+				// ParserLL1_run only tells that the source ran out while
+				// parsing goes on
+				Parser_StepResult_type expected_result = ref_result;
+				if(how == 3 && (ref_result == PARSER_STEP_RESULT_MORE_INPUT || ref_result == PARSER_STEP_RESULT_FAIL))
+					expected_result = PARSER_STEP_RESULT_MORE_INPUT;
+
+				num_failures += check(result == expected_result, "recovery skip status", bgr_ptr->name, run);
+				num_failures += check(how != 1 || stop_index == ref_stop_index, "recovery skip stop index", bgr_ptr->name, run);
+
+				// Keep the reference for the next call
+				IntBuffer ref_buf = {malloc( sizeof(int) * (bufs[0].len_values > 0 ? bufs[0].len_values : 1) ), bufs[0].len_values, bufs[0].len_values};
+				memcpy(ref_buf.values, bufs[0].values, sizeof(int) * bufs[0].len_values);
+				num_failures += check_buffers(bufs, "recovery skip", bgr_ptr->name, run);
+				bufs[0] = ref_buf;
+			}
+
+			ParserLL1_destroy(psr_ptr);
+		}
+
+		free(bufs[0].values);
+		free(records);
+		free(symbols);
+	}
+
+	return num_failures;
+}
+
+// Splits a long statement list into chunks parsed in parallel. Status, tree
+// and errors must match a sequential parse, including for input where chunks
+// fall back to sequential parsing
+static int test_chunked(void){
+	int num_failures = 0;
+
+	int variable_symbols[] = {SYMBOL_START, SYMBOL_LIST, SYMBOL_ITEM, SYMBOL_EXPRESSION, SYMBOL_EMPTY};
+	int terminal_symbols[] = {SYMBOL_ID, SYMBOL_ASSIGN, SYMBOL_SEMICOLON, SYMBOL_LEFT_BRACE, SYMBOL_RIGHT_BRACE, SYMBOL_LEFT_PAREN, SYMBOL_RIGHT_PAREN, SYMBOL_END};
+	int len_terminal_symbols = sizeof(terminal_symbols) / sizeof(int);
+
+	ParserLL1_Grammar *grm_ptr = ParserLL1_Grammar_new(variable_symbols, sizeof(variable_symbols) / sizeof(int), terminal_symbols, len_terminal_symbols, SYMBOL_START, SYMBOL_EMPTY, SYMBOL_END, NULL, 0, token_to_symbol, symbol_to_string, token_to_value);
+
+	int start_rule[] = {SYMBOL_LIST, SYMBOL_END};
+	int list_rule[] = {SYMBOL_ITEM, SYMBOL_LIST};
+	int empty_rule[] = {SYMBOL_EMPTY};
+	int statement_rule[] = {SYMBOL_ID, SYMBOL_ASSIGN, SYMBOL_EXPRESSION, SYMBOL_SEMICOLON};
+	int block_rule[] = {SYMBOL_LEFT_BRACE, SYMBOL_LIST, SYMBOL_RIGHT_BRACE};
+	int id_rule[] = {SYMBOL_ID};
+	int paren_rule[] = {SYMBOL_LEFT_PAREN, SYMBOL_EXPRESSION, SYMBOL_RIGHT_PAREN};
+	ParserLL1_Grammar_add_rule(grm_ptr, 1, SYMBOL_START, start_rule, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 2, SYMBOL_LIST, list_rule, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 3, SYMBOL_LIST, empty_rule, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 4, SYMBOL_ITEM, statement_rule, 4);
+	ParserLL1_Grammar_add_rule(grm_ptr, 5, SYMBOL_ITEM, block_rule, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 6, SYMBOL_EXPRESSION, id_rule, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 7, SYMBOL_EXPRESSION, paren_rule, 3);
+	ParserLL1_Grammar_initialize_rules(grm_ptr);
+
+	int *symbols = malloc( sizeof(int) * CHUNKED_INPUT_SYMBOLS );
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 400 + run;
+
+		int len_symbols = 0;
+		while(CHUNKED_INPUT_SYMBOLS - len_symbols > 64)
+			len_symbols += generate_statements(symbols + len_symbols, CHUNKED_INPUT_SYMBOLS - len_symbols - 1, 0, &seed);
+		symbols[len_symbols++] = SYMBOL_END;
+
+		// Valid input, scattered errors, many errors, early end
+		if(run % 4 == 1){
+			for (int i = 0; i < 20; ++i)
+				symbols[rand_r(&seed) % (len_symbols - 1)] = terminal_symbols[rand_r(&seed) % (len_terminal_symbols - 1)];
+		}
+		else if(run % 4 == 2){
+			for (int i = 0; i < len_symbols / 30; ++i)
+				symbols[rand_r(&seed) % (len_symbols - 1)] = terminal_symbols[rand_r(&seed) % (len_terminal_symbols - 1)];
+		}
+		else if(run % 4 == 3){
+			symbols[len_symbols / 2] = SYMBOL_END;
+		}
+
+		IntBuffer bufs[2] = {{NULL, 0, 0}, {NULL, 0, 0}};
+
+		ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+		Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+		int stop_index;
+		Parser_StepResult_type result = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_symbols, &stop_index);
+		for (int i = stop_index; i < len_symbols; ++i)
+			Token_destroy(tkn_ptrs[i]);
+		free(tkn_ptrs);
+
+		ParseTree *tree = ParserLL1_get_parse_tree(psr_ptr);
+		serialize_parse_tree(tree, &bufs[0]);
+		serialize_parser_errors(psr_ptr, &bufs[0]);
+		ParseTree_Node_destroy(tree);
+		ParserLL1_destroy(psr_ptr);
+
+		ParserLL1_Document doc;
+		doc.tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+		doc.len_tkn_ptrs = len_symbols;
+		ParserLL1_parse_document_chunked(grm_ptr, &doc, SYMBOL_LIST, SYMBOL_SEMICOLON, CHUNKED_THREADS);
+		for (int i = doc.stop_index; i < len_symbols; ++i)
+			Token_destroy(doc.tkn_ptrs[i]);
+		free(doc.tkn_ptrs);
+
+		serialize_parse_tree(doc.tree, &bufs[1]);
+		serialize_errors(doc.errors, doc.len_errors, &bufs[1]);
+		ParserLL1_Document_clear(&doc);
+
+		num_failures += check(result == doc.result && stop_index == doc.stop_index, "chunked status", "statements", run);
+		num_failures += check_buffers(bufs, "chunked", "statements", run);
+	}
+
+	free(symbols);
+	ParserLL1_Grammar_destroy(grm_ptr);
+
+	return num_failures;
+}
+
+// Parses the same input in arena, flat and event mode. Status, tree and
+// errors must be the same, with and without errors. Trees are compared once
+// parsing has ended, as the arena tree also holds symbols not reached yet
+static int test_tree_modes(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	int num_failures = 0;
+
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 500 + run;
+
+		int *symbols = malloc( sizeof(int) * INPUT_SYMBOLS );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		if(run % 2 == 1)
+			corrupt(bgr_ptr, symbols, len_symbols, run % 4 == 1 ? 200 : 10, &seed);
+
+		// Arena, flat and event mode
+		IntBuffer bufs[3] = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}};
+		Parser_StepResult_type results[3];
+		int stop_indices[3];
+
+		for (int how = 0; how < 3; ++how){
+			ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+			EventTree evt_tree = {{NULL, 0, 0}, 0};
+			if(how == 0)
+				ParserLL1_set_arena_mode(psr_ptr, 0);
+			else if(how == 1)
+				ParserLL1_set_flat_mode(psr_ptr);
+			else
+				ParserLL1_set_event_mode(psr_ptr, add_event, &evt_tree);
+			if(run % 4 == 3)
+				ParserLL1_set_sync_recovery(psr_ptr, 1, NULL, 0);
+
+			Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+			results[how] = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_symbols, &stop_indices[how]);
+			for (int i = stop_indices[how]; i < len_symbols; ++i)
+				Token_destroy(tkn_ptrs[i]);
+			free(tkn_ptrs);
+
+			int flag_ended = results[how] == PARSER_STEP_RESULT_SUCCESS || results[how] == PARSER_STEP_RESULT_HALTED;
+			if(how == 0){
+				if(flag_ended == 1)
+					serialize_nodes(ParserLL1_get_arena_tree(psr_ptr), &bufs[0]);
+			}
+			else if(how == 1){
+				ParserLL1_FlatTree *ft_ptr = ParserLL1_get_flat_tree(psr_ptr);
+				num_failures += check((ft_ptr != NULL) == flag_ended, "tree modes flat tree", bgr_ptr->name, run);
+				if(ft_ptr != NULL && flag_ended == 1)
+					serialize_flat_nodes(ft_ptr, &bufs[1]);
+				ParserLL1_FlatTree_destroy(ft_ptr);
+			}
+			else{
+				if(flag_ended == 1){
+					num_failures += check(evt_tree.depth == 0, "tree modes event depth", bgr_ptr->name, run);
+					bufs[2] = evt_tree.buf;
+				}
+				else{
+					free(evt_tree.buf.values);
+				}
+			}
+			serialize_parser_errors(psr_ptr, &bufs[how]);
+
+			ParserLL1_destroy(psr_ptr);
+		}
+
+		for (int how = 1; how < 3; ++how){
+			const char *test_name = how == 1 ? "tree modes flat" : "tree modes event";
+			num_failures += check(results[how] == results[0] && stop_indices[how] == stop_indices[0], test_name, bgr_ptr->name, run);
+
+			// Keep the arena tree for the next comparison
+			IntBuffer pair[2] = {{malloc( sizeof(int) * (bufs[0].len_values > 0 ? bufs[0].len_values : 1) ), bufs[0].len_values, bufs[0].len_values}, bufs[how]};
+			memcpy(pair[0].values, bufs[0].values, sizeof(int) * bufs[0].len_values);
+			num_failures += check_buffers(pair, test_name, bgr_ptr->name, run);
+		}
+
+		free(bufs[0].values);
+		free(symbols);
+	}
+
+	return num_failures;
+}
+
+// Saves the grammar, then maps the image with ParserLL1_Grammar_load and
+// reads it into memory for ParserLL1_Grammar_from_image. Status, tree and
+// errors must match the saved grammar, with and without errors
+static int test_image(BenchGrammar *bgr_ptr, ParserLL1_Grammar *grm_ptr){
+	int num_failures = 0;
+
+	if(ParserLL1_Grammar_save(grm_ptr, IMAGE_PATH) != 0)
+		return check(0, "image save", bgr_ptr->name, 0);
+
+	void *image_ptr = NULL;
+	long len_image = 0;
+	FILE *file_ptr = fopen(IMAGE_PATH, "rb");
+	if(file_ptr != NULL && fseek(file_ptr, 0, SEEK_END) == 0 && (len_image = ftell(file_ptr)) > 0 && fseek(file_ptr, 0, SEEK_SET) == 0){
+		// Aligned to 8 bytes by malloc
+		image_ptr = malloc(len_image);
+		if(fread(image_ptr, 1, len_image, file_ptr) != (size_t)len_image){
+			free(image_ptr);
+			image_ptr = NULL;
+		}
+	}
+	if(file_ptr != NULL)
+		fclose(file_ptr);
+
+	// Original, mapped and in memory
+	ParserLL1_Grammar *grm_ptrs[3];
+	grm_ptrs[0] = grm_ptr;
+	grm_ptrs[1] = ParserLL1_Grammar_load(IMAGE_PATH, token_to_symbol, symbol_to_string, token_to_value);
+	grm_ptrs[2] = image_ptr != NULL ? ParserLL1_Grammar_from_image(image_ptr, len_image, token_to_symbol, symbol_to_string, token_to_value) : NULL;
+	num_failures += check(grm_ptrs[1] != NULL, "image load", bgr_ptr->name, 0);
+	num_failures += check(grm_ptrs[2] != NULL, "image from memory", bgr_ptr->name, 0);
+
+	for (int run = 0; run < NUM_RUNS && num_failures == 0; ++run){
+		unsigned int seed = 600 + run;
+
+		int *symbols = malloc( sizeof(int) * INPUT_SYMBOLS );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		if(run % 2 == 1)
+			corrupt(bgr_ptr, symbols, len_symbols, 50, &seed);
+
+		IntBuffer bufs[3] = {{NULL, 0, 0}, {NULL, 0, 0}, {NULL, 0, 0}};
+		Parser_StepResult_type results[3];
+		int stop_indices[3];
+
+		for (int i = 0; i < 3; ++i){
+			ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptrs[i]);
+			ParserLL1_set_arena_mode(psr_ptr, 0);
+			if(run % 4 == 3)
+				ParserLL1_set_sync_recovery(psr_ptr, 1, NULL, 0);
+
+			Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+			results[i] = ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_symbols, &stop_indices[i]);
+			for (int j = stop_indices[i]; j < len_symbols; ++j)
+				Token_destroy(tkn_ptrs[j]);
+			free(tkn_ptrs);
+
+			serialize_arena_tree(ParserLL1_get_arena_tree(psr_ptr), 1, &bufs[i]);
+			serialize_parser_errors(psr_ptr, &bufs[i]);
+
+			ParserLL1_destroy(psr_ptr);
+		}
+
+		for (int i = 1; i < 3; ++i){
+			const char *test_name = i == 1 ? "image load" : "image from memory";
+			num_failures += check(results[i] == results[0] && stop_indices[i] == stop_indices[0], test_name, bgr_ptr->name, run);
+
+			// Keep the original's tree for the next comparison
+			IntBuffer pair[2] = {{malloc( sizeof(int) * (bufs[0].len_values > 0 ? bufs[0].len_values : 1) ), bufs[0].len_values, bufs[0].len_values}, bufs[i]};
+			memcpy(pair[0].values, bufs[0].values, sizeof(int) * bufs[0].len_values);
+			num_failures += check_buffers(pair, test_name, bgr_ptr->name, run);
+		}
+
+		free(bufs[0].values);
+		free(symbols);
+	}
+
+	for (int i = 1; i < 3; ++i){
+		if(grm_ptrs[i] != NULL)
+			ParserLL1_Grammar_destroy(grm_ptrs[i]);
+	}
+	free(image_ptr);
+	remove(IMAGE_PATH);
+
+	return num_failures;
+}
+
+
+//////////
+// Main //
+//////////
+
+int main(void){
+	BenchGrammar *bgr_ptrs[] = {
+		BenchGrammar_new_expression(),
+		BenchGrammar_new_json(),
+		BenchGrammar_new_generated(10, 1),
+		BenchGrammar_new_generated(100, 3)
+	};
+	int len_bgr_ptrs = sizeof(bgr_ptrs) / sizeof(BenchGrammar *);
+	int num_failures = 0;
+
+	for (int i = 0; i < len_bgr_ptrs; ++i){
+		ParserLL1_Grammar *grm_ptr = BenchGrammar_build(bgr_ptrs[i]);
+		ParserLL1_Grammar_initialize_rules(grm_ptr);
+
+		num_failures += test_reparse(bgr_ptrs[i], grm_ptr);
+		num_failures += test_checkpoint(bgr_ptrs[i], grm_ptr);
+		num_failures += test_recovery_skip(bgr_ptrs[i], grm_ptr);
+		num_failures += test_tree_modes(bgr_ptrs[i], grm_ptr);
+		num_failures += test_image(bgr_ptrs[i], grm_ptr);
+
+		ParserLL1_Grammar_destroy(grm_ptr);
+		BenchGrammar_destroy(bgr_ptrs[i]);
+	}
+
+	num_failures += test_chunked();
+
+	printf("%d failures\n", num_failures);
+
+	return num_failures > 0;
+}
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ParserLL1.h"
+#include "Token.h"
+#include "bench_grammars.h"
+
+// Parses the same inputs with the parsers written by
+// ParserLL1_Grammar_generate_c for the benchmark grammars, and with the
+// library and the grammar they were generated from, and compares status,
+// parse tree, errors and statistics:
+// - <name>_parse_tokens and <name>_step on each token, against
+//   ParserLL1_parse_tokens with the original grammar
+// - ParserLL1_parse_tokens with the grammar from <name>_grammar_new, against
+//   the same
+// - <name>_parse_tokens with the original grammar, which the generated code
+//   hands to the library
+// Each in arena, event and ParseTree mode, on valid input, and on input with
+// errors with and without sync recovery, error limits and tree limits.
+// Usage: test_generated
+//
+// Prints each comparison that differs, and exits with 1 if any did.
+
+
+///////////////
+// Constants //
+///////////////
+
+// Inputs generated for each grammar
+#define NUM_RUNS 8
+
+// Symbols of generated inputs
+#define INPUT_SYMBOLS 2000
+
+// Ways of parsing an input, compared to the first
+enum{
+	WAY_LIBRARY,
+	WAY_LIBRARY_TABLES,
+	WAY_GENERATED,
+	WAY_GENERATED_STEP,
+	WAY_GENERATED_ORIGINAL,
+	NUM_WAYS
+};
+
+// Tree building modes
+enum{
+	MODE_ARENA,
+	MODE_EVENT,
+	MODE_PARSE_TREE,
+	NUM_MODES
+};
+
+
+/////////////////////
+// Data Structures //
+/////////////////////
+
+// Serialized tree, errors and statistics, compared as a whole
+typedef struct IntBuffer{
+	int *values;
+	int len_values;
+	int cap_values;
+}IntBuffer;
+
+// Nodes of a tree rebuilt from events
+typedef struct EventTree{
+	IntBuffer *buf_ptr;
+	int depth;
+}EventTree;
+
+// Functions of a generated parser
+typedef struct GeneratedParser{
+	ParserLL1_Grammar *(*grammar_new)(int (*)(Token *), char *(*)(int), void (*)(Token *, char *, int));
+	Parser_StepResult_type (*step)(ParserLL1 *, Token *);
+	Parser_StepResult_type (*parse_tokens)(ParserLL1 *, Token **, int, int *);
+}GeneratedParser;
+
+
+/////////////////////////////////
+// Generated Parser Prototypes //
+/////////////////////////////////
+
+ParserLL1_Grammar *expression_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+Parser_StepResult_type expression_step(ParserLL1 *psr_ptr, Token *tkn_ptr);
+Parser_StepResult_type expression_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+
+ParserLL1_Grammar *json_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+Parser_StepResult_type json_step(ParserLL1 *psr_ptr, Token *tkn_ptr);
+Parser_StepResult_type json_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+
+ParserLL1_Grammar *generated_10_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+Parser_StepResult_type generated_10_step(ParserLL1 *psr_ptr, Token *tkn_ptr);
+Parser_StepResult_type generated_10_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+
+ParserLL1_Grammar *generated_100_grammar_new(int (*token_to_symbol)(Token *), char *(*symbol_to_string)(int), void (*token_to_value)(Token *, char *, int));
+Parser_StepResult_type generated_100_step(ParserLL1 *psr_ptr, Token *tkn_ptr);
+Parser_StepResult_type generated_100_parse_tokens(ParserLL1 *psr_ptr, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static void buffer_push(IntBuffer *buf_ptr, int value);
+static void serialize_nodes(ParserLL1_Node *root_node_ptr, IntBuffer *buf_ptr);
+static void serialize_parse_tree(ParseTree_Node *root_node_ptr, IntBuffer *buf_ptr);
+static void serialize_parser_errors(ParserLL1 *psr_ptr, IntBuffer *buf_ptr);
+static void serialize_stats(ParserLL1 *psr_ptr, IntBuffer *buf_ptr);
+static void add_event(ParserLL1_Event *evt_ptr, void *ctx);
+static int random_terminal(BenchGrammar *bgr_ptr, unsigned int *seed);
+static void corrupt(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, int interval, unsigned int *seed);
+static int token_to_symbol(Token *tkn_ptr);
+static char *symbol_to_string(int symbol);
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer);
+
+static Parser_StepResult_type parse(ParserLL1 *psr_ptr, GeneratedParser *gp_ptr, int way, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index);
+static int test_generated(BenchGrammar *bgr_ptr, GeneratedParser *gp_ptr);
+
+
+/////////////
+// Helpers //
+/////////////
+
+static void buffer_push(IntBuffer *buf_ptr, int value){
+	if(buf_ptr->len_values == buf_ptr->cap_values){
+		buf_ptr->cap_values = buf_ptr->cap_values > 0 ? buf_ptr->cap_values * 2 : 1024;
+		buf_ptr->values = realloc( buf_ptr->values, sizeof(int) * buf_ptr->cap_values );
+	}
+
+	buf_ptr->values[buf_ptr->len_values++] = value;
+}
+
+// Nodes in preorder as depth, symbol, rule, symbol index and token position.
+// Walks with parent links, as long lists make trees too deep for recursion
+static void serialize_nodes(ParserLL1_Node *root_node_ptr, IntBuffer *buf_ptr){
+	ParserLL1_Node *node_ptr = root_node_ptr;
+	int depth = 0;
+
+	while(node_ptr != NULL){
+		buffer_push(buf_ptr, depth);
+		buffer_push(buf_ptr, node_ptr->symbol);
+		buffer_push(buf_ptr, node_ptr->rule_num);
+		buffer_push(buf_ptr, node_ptr->symbol_index);
+		buffer_push(buf_ptr, node_ptr->token_index);
+
+		if(node_ptr->first_child != NULL){
+			node_ptr = node_ptr->first_child;
+			depth++;
+			continue;
+		}
+
+		while(node_ptr != root_node_ptr && node_ptr->next_sibling == NULL){
+			node_ptr = node_ptr->parent;
+			depth--;
+		}
+		node_ptr = node_ptr != root_node_ptr ? node_ptr->next_sibling : NULL;
+	}
+}
+
+static void serialize_parse_tree(ParseTree_Node *root_node_ptr, IntBuffer *buf_ptr){
+	ParseTree_Node *node_ptr = root_node_ptr;
+	int depth = 0;
+
+	while(node_ptr != NULL){
+		buffer_push(buf_ptr, depth);
+		buffer_push(buf_ptr, node_ptr->symbol);
+		buffer_push(buf_ptr, node_ptr->rule_num);
+		buffer_push(buf_ptr, node_ptr->symbol_index);
+		buffer_push(buf_ptr, node_ptr->tkn_ptr != NULL ? node_ptr->tkn_ptr->line : -1);
+
+		if(node_ptr->first_child != NULL){
+			node_ptr = node_ptr->first_child;
+			depth++;
+			continue;
+		}
+
+		while(node_ptr != root_node_ptr && node_ptr->next_sibling == NULL){
+			node_ptr = node_ptr->parent;
+			depth--;
+		}
+		node_ptr = node_ptr != root_node_ptr ? node_ptr->next_sibling : NULL;
+	}
+}
+
+static void serialize_parser_errors(ParserLL1 *psr_ptr, IntBuffer *buf_ptr){
+	int len_errors = ParserLL1_get_num_errors(psr_ptr);
+	ParserLL1_Error *errors = malloc( sizeof(ParserLL1_Error) * (len_errors > 0 ? len_errors : 1) );
+	len_errors = ParserLL1_get_errors(psr_ptr, errors, len_errors);
+
+	buffer_push(buf_ptr, len_errors);
+	for (int i = 0; i < len_errors; ++i){
+		buffer_push(buf_ptr, errors[i].token_index);
+		buffer_push(buf_ptr, errors[i].lookahead_symbol);
+		buffer_push(buf_ptr, errors[i].top_symbol);
+	}
+
+	free(errors);
+}
+
+// Counters are compared when compiled in, peak stack depth always
+static void serialize_stats(ParserLL1 *psr_ptr, IntBuffer *buf_ptr){
+	ParserLL1_Stats stats;
+	ParserLL1_get_stats(psr_ptr, &stats);
+
+	long long counters[] = {stats.tokens_consumed, stats.expansions, stats.epsilon_expansions, stats.terminal_matches, stats.errors_recorded, stats.tokens_discarded, stats.nodes_allocated};
+	for (size_t i = 0; i < sizeof(counters) / sizeof(long long); ++i)
+		buffer_push(buf_ptr, (int)counters[i]);
+	buffer_push(buf_ptr, stats.peak_stack_depth);
+
+	buffer_push(buf_ptr, stats.len_rule_expansions);
+	for (int i = 0; i < stats.len_rule_expansions; ++i)
+		buffer_push(buf_ptr, (int)stats.rule_expansions[i]);
+}
+
+// Appends nodes in the form of serialize_nodes, as test_equivalence
+static void add_event(ParserLL1_Event *evt_ptr, void *ctx){
+	EventTree *evt_tree_ptr = ctx;
+
+	if(evt_ptr->type == PARSERLL1_EVENT_EXIT){
+		evt_tree_ptr->depth--;
+		return;
+	}
+
+	int flag_token = evt_ptr->type == PARSERLL1_EVENT_TOKEN && evt_ptr->rule_num == 0;
+	buffer_push(evt_tree_ptr->buf_ptr, evt_tree_ptr->depth);
+	buffer_push(evt_tree_ptr->buf_ptr, evt_ptr->symbol);
+	buffer_push(evt_tree_ptr->buf_ptr, evt_ptr->rule_num);
+	buffer_push(evt_tree_ptr->buf_ptr, evt_ptr->symbol_index);
+	buffer_push(evt_tree_ptr->buf_ptr, flag_token == 1 ? evt_ptr->token_index : -1);
+
+	if(evt_ptr->type == PARSERLL1_EVENT_ENTER)
+		evt_tree_ptr->depth++;
+	if(evt_ptr->tkn_ptr != NULL)
+		Token_destroy(evt_ptr->tkn_ptr);
+}
+
+static int random_terminal(BenchGrammar *bgr_ptr, unsigned int *seed){
+	int symbol;
+	do{
+		symbol = bgr_ptr->terminal_symbols[rand_r(seed) % bgr_ptr->len_terminal_symbols];
+	}while(symbol == bgr_ptr->end_symbol);
+
+	return symbol;
+}
+
+// Replaces symbols at random intervals, keeping the end symbol
+static void corrupt(BenchGrammar *bgr_ptr, int *symbols, int len_symbols, int interval, unsigned int *seed){
+	for (int i = 1 + rand_r(seed) % interval; i < len_symbols - 1; i += 1 + rand_r(seed) % interval)
+		symbols[i] = random_terminal(bgr_ptr, seed);
+}
+
+static int token_to_symbol(Token *tkn_ptr){
+	return tkn_ptr->column;
+}
+
+static char *symbol_to_string(int symbol){
+	(void)symbol;
+	return "symbol";
+}
+
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer){
+	(void)tkn_ptr;
+	if(len_buffer > 0)
+		buffer[0] = '\0';
+}
+
+
+///////////
+// Tests //
+///////////
+
+// Stepping stops where ParserLL1_parse_tokens would
+static Parser_StepResult_type parse(ParserLL1 *psr_ptr, GeneratedParser *gp_ptr, int way, Token **tkn_ptrs, int len_tkn_ptrs, int *stop_index){
+	if(way == WAY_LIBRARY || way == WAY_LIBRARY_TABLES)
+		return ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_tkn_ptrs, stop_index);
+	if(way != WAY_GENERATED_STEP)
+		return gp_ptr->parse_tokens(psr_ptr, tkn_ptrs, len_tkn_ptrs, stop_index);
+
+	Parser_StepResult_type result = PARSER_STEP_RESULT_MORE_INPUT;
+	int i = 0;
+	while(i < len_tkn_ptrs){
+		result = gp_ptr->step(psr_ptr, tkn_ptrs[i++]);
+		if(result == PARSER_STEP_RESULT_SUCCESS || result == PARSER_STEP_RESULT_HALTED || result == PARSER_STEP_RESULT_UNKNOWN_INPUT || result == PARSER_STEP_RESULT_MAX_ERRORS || result == PARSER_STEP_RESULT_LIMIT_EXCEEDED)
+			break;
+	}
+
+	*stop_index = i;
+	return result;
+}
+
+static int test_generated(BenchGrammar *bgr_ptr, GeneratedParser *gp_ptr){
+	int num_failures = 0;
+
+	ParserLL1_Grammar *grm_ptr = BenchGrammar_build(bgr_ptr);
+	ParserLL1_Grammar_initialize_rules(grm_ptr);
+	ParserLL1_Grammar *tbl_grm_ptr = gp_ptr->grammar_new(token_to_symbol, symbol_to_string, token_to_value);
+	if(tbl_grm_ptr == NULL){
+		printf("generated: %s grammar_new failed\n", bgr_ptr->name);
+		ParserLL1_Grammar_destroy(grm_ptr);
+		return 1;
+	}
+
+	for (int run = 0; run < NUM_RUNS; ++run){
+		unsigned int seed = 700 + run;
+
+		int *symbols = malloc( sizeof(int) * INPUT_SYMBOLS );
+		int len_symbols = bgr_ptr->generate(bgr_ptr, symbols, INPUT_SYMBOLS, &seed);
+		if(run % 2 == 1)
+			corrupt(bgr_ptr, symbols, len_symbols, 50, &seed);
+
+		for (int mode = 0; mode < NUM_MODES; ++mode){
+			IntBuffer bufs[NUM_WAYS];
+			Parser_StepResult_type results[NUM_WAYS];
+			int stop_indices[NUM_WAYS];
+
+			for (int way = 0; way < NUM_WAYS; ++way){
+				ParserLL1 *psr_ptr = ParserLL1_new_session(way == WAY_LIBRARY || way == WAY_GENERATED_ORIGINAL ? grm_ptr : tbl_grm_ptr);
+				bufs[way] = (IntBuffer){NULL, 0, 0};
+				EventTree evt_tree = {&bufs[way], 0};
+
+				if(mode == MODE_ARENA)
+					ParserLL1_set_arena_mode(psr_ptr, 0);
+				else if(mode == MODE_EVENT)
+					ParserLL1_set_event_mode(psr_ptr, add_event, &evt_tree);
+				if(run % 4 == 3)
+					ParserLL1_set_sync_recovery(psr_ptr, 1, NULL, 0);
+				if(run == 5)
+					ParserLL1_set_max_errors(psr_ptr, 4, 1);
+				if(run >= 6)
+					ParserLL1_set_limits(psr_ptr, len_symbols, 0, 0);
+
+				Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+				results[way] = parse(psr_ptr, gp_ptr, way, tkn_ptrs, len_symbols, &stop_indices[way]);
+				for (int i = stop_indices[way]; i < len_symbols; ++i)
+					Token_destroy(tkn_ptrs[i]);
+				free(tkn_ptrs);
+
+				if(mode == MODE_ARENA){
+					serialize_nodes(ParserLL1_get_arena_tree(psr_ptr), &bufs[way]);
+				}
+				else if(mode == MODE_PARSE_TREE){
+					ParseTree *tree = ParserLL1_get_parse_tree(psr_ptr);
+					serialize_parse_tree(tree, &bufs[way]);
+					if(tree != NULL)
+						ParseTree_Node_destroy(tree);
+				}
+				serialize_parser_errors(psr_ptr, &bufs[way]);
+				serialize_stats(psr_ptr, &bufs[way]);
+
+				ParserLL1_destroy(psr_ptr);
+			}
+
+			for (int way = 1; way < NUM_WAYS; ++way){
+				int flag_same = results[way] == results[0] && stop_indices[way] == stop_indices[0];
+				flag_same = flag_same && bufs[way].len_values == bufs[0].len_values && memcmp(bufs[way].values, bufs[0].values, sizeof(int) * bufs[0].len_values) == 0;
+				if(flag_same == 0){
+					printf("generated: %s run %d mode %d way %d differs\n", bgr_ptr->name, run, mode, way);
+					num_failures++;
+				}
+			}
+
+			for (int way = 0; way < NUM_WAYS; ++way)
+				free(bufs[way].values);
+		}
+
+		free(symbols);
+	}
+
+	ParserLL1_Grammar_destroy(tbl_grm_ptr);
+	ParserLL1_Grammar_destroy(grm_ptr);
+
+	return num_failures;
+}
+
+
+//////////
+// Main //
+//////////
+
+int main(void){
+	// Same grammars as generate_parsers
+	BenchGrammar *bgr_ptrs[] = {
+		BenchGrammar_new_expression(),
+		BenchGrammar_new_json(),
+		BenchGrammar_new_generated(10, 1),
+		BenchGrammar_new_generated(100, 3)
+	};
+	GeneratedParser gps[] = {
+		{expression_grammar_new, expression_step, expression_parse_tokens},
+		{json_grammar_new, json_step, json_parse_tokens},
+		{generated_10_grammar_new, generated_10_step, generated_10_parse_tokens},
+		{generated_100_grammar_new, generated_100_step, generated_100_parse_tokens}
+	};
+	int len_bgr_ptrs = sizeof(bgr_ptrs) / sizeof(BenchGrammar *);
+	int num_failures = 0;
+
+	for (int i = 0; i < len_bgr_ptrs; ++i){
+		num_failures += test_generated(bgr_ptrs[i], &gps[i]);
+		BenchGrammar_destroy(bgr_ptrs[i]);
+	}
+
+	printf("%d failures\n", num_failures);
+
+	return num_failures > 0;
+}
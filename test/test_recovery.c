@@ -0,0 +1,155 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "ParserLL1.h"
+#include "Token.h"
+#include "bench_grammars.h"
+
+// Checks that sync recovery reports one error for each corrupted item of a
+// list, however many symbols of the item are missing.
+// Usage: test_recovery
+//
+// Prints each input with a wrong number of errors, and exits with 1 if any.
+
+
+///////////////
+// Constants //
+///////////////
+
+// Items of each input
+#define NUM_ITEMS 200
+
+// Item grammar. Terminals first
+enum{
+	SYMBOL_X = 1,
+	SYMBOL_Y,
+	SYMBOL_Z,
+	SYMBOL_W,
+	SYMBOL_C,
+	SYMBOL_END,
+	SYMBOL_START,
+	SYMBOL_LIST,
+	SYMBOL_ITEM,
+	SYMBOL_Y_PART,
+	SYMBOL_Z_PART,
+	SYMBOL_EMPTY
+};
+
+
+/////////////////////////////////
+// Private Function Prototypes //
+/////////////////////////////////
+
+static int token_to_symbol(Token *tkn_ptr);
+static char *symbol_to_string(int symbol);
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer);
+
+
+/////////////
+// Helpers //
+/////////////
+
+static int token_to_symbol(Token *tkn_ptr){
+	return tkn_ptr->column;
+}
+
+static char *symbol_to_string(int symbol){
+	(void)symbol;
+	return "symbol";
+}
+
+static void token_to_value(Token *tkn_ptr, char *buffer, int len_buffer){
+	(void)tkn_ptr;
+	if(len_buffer > 0)
+		buffer[0] = '\0';
+}
+
+
+//////////
+// Main //
+//////////
+
+int main(void){
+	int variable_symbols[] = {SYMBOL_START, SYMBOL_LIST, SYMBOL_ITEM, SYMBOL_Y_PART, SYMBOL_Z_PART, SYMBOL_EMPTY};
+	int terminal_symbols[] = {SYMBOL_X, SYMBOL_Y, SYMBOL_Z, SYMBOL_W, SYMBOL_C, SYMBOL_END};
+
+	ParserLL1_Grammar *grm_ptr = ParserLL1_Grammar_new(variable_symbols, sizeof(variable_symbols) / sizeof(int), terminal_symbols, sizeof(terminal_symbols) / sizeof(int), SYMBOL_START, SYMBOL_EMPTY, SYMBOL_END, NULL, 0, token_to_symbol, symbol_to_string, token_to_value);
+
+	// Items are x z w y, ended by c. A corrupted item ends early, so the
+	// parts still expected are popped as missing when c is found
+	int start_rule[] = {SYMBOL_LIST, SYMBOL_END};
+	int list_rule[] = {SYMBOL_ITEM, SYMBOL_C, SYMBOL_LIST};
+	int empty_rule[] = {SYMBOL_EMPTY};
+	int item_rule[] = {SYMBOL_X, SYMBOL_Z_PART, SYMBOL_W, SYMBOL_Y_PART};
+	int y_rule[] = {SYMBOL_Y};
+	int z_rule[] = {SYMBOL_Z};
+	ParserLL1_Grammar_add_rule(grm_ptr, 1, SYMBOL_START, start_rule, 2);
+	ParserLL1_Grammar_add_rule(grm_ptr, 2, SYMBOL_LIST, list_rule, 3);
+	ParserLL1_Grammar_add_rule(grm_ptr, 3, SYMBOL_LIST, empty_rule, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 4, SYMBOL_ITEM, item_rule, 4);
+	ParserLL1_Grammar_add_rule(grm_ptr, 5, SYMBOL_Y_PART, y_rule, 1);
+	ParserLL1_Grammar_add_rule(grm_ptr, 6, SYMBOL_Z_PART, z_rule, 1);
+	ParserLL1_Grammar_initialize_rules(grm_ptr);
+
+	int item[] = {SYMBOL_X, SYMBOL_Z, SYMBOL_W, SYMBOL_Y, SYMBOL_C};
+	int len_item = sizeof(item) / sizeof(int);
+	int *symbols = malloc( sizeof(int) * (NUM_ITEMS * len_item + 1) );
+	int num_failures = 0;
+
+	for (int run = 0; run < 8; ++run){
+		unsigned int seed = run;
+		int len_symbols = 0;
+		int num_corrupted = 0;
+
+		// Corrupted items keep between 1 and 3 symbols before c
+		for (int i = 0; i < NUM_ITEMS; ++i){
+			int len_kept = len_item - 1;
+			if(rand_r(&seed) % 4 == 0){
+				len_kept = 1 + rand_r(&seed) % (len_item - 2);
+				num_corrupted++;
+			}
+
+			for (int j = 0; j < len_kept; ++j)
+				symbols[len_symbols++] = item[j];
+			symbols[len_symbols++] = SYMBOL_C;
+		}
+		symbols[len_symbols++] = SYMBOL_END;
+
+		// Same count with c declared as sync terminal, and when stepping on
+		// each token instead of skipping in batches
+		int sync_symbols[] = {SYMBOL_C};
+		for (int how = 0; how < 3; ++how){
+			ParserLL1 *psr_ptr = ParserLL1_new_session(grm_ptr);
+			ParserLL1_set_sync_recovery(psr_ptr, 1, sync_symbols, how == 1 ? 1 : 0);
+
+			Token **tkn_ptrs = bench_new_tokens(symbols, len_symbols);
+			int stop_index = 0;
+			if(how < 2){
+				ParserLL1_parse_tokens(psr_ptr, tkn_ptrs, len_symbols, &stop_index);
+			}
+			else{
+				while(stop_index < len_symbols)
+					ParserLL1_step(psr_ptr, tkn_ptrs[stop_index++]);
+			}
+
+			for (int i = stop_index; i < len_symbols; ++i)
+				Token_destroy(tkn_ptrs[i]);
+			free(tkn_ptrs);
+
+			int num_errors = ParserLL1_get_num_errors(psr_ptr);
+			if(num_errors != num_corrupted){
+				printf("run %d, way %d: %d errors for %d corrupted items\n", run, how, num_errors, num_corrupted);
+				num_failures++;
+			}
+
+			ParserLL1_destroy(psr_ptr);
+		}
+	}
+
+	free(symbols);
+	ParserLL1_Grammar_destroy(grm_ptr);
+
+	printf("%d failures\n", num_failures);
+
+	return num_failures > 0;
+}